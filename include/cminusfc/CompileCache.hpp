@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+
+/**
+ * 按内容哈希的编译缓存
+ *
+ * 键由调用者拼接：输入文件的内容、影响输出的选项与编译器版本，
+ * 取其 64 位 FNV-1a 哈希作为缓存目录中的文件名。缓存项依次存放键的长度
+ * （一行）、完整的键与输出，查找时比较完整的键，哈希冲突时视为未命中。
+ * 写入先写临时文件再 rename，多个进程同时写同一项也不会读到半个文件；
+ * 命中时更新文件的修改时间，写入后按修改时间从旧到新淘汰，直到总大小不超过上限（LRU）。
+ * 命中与未命中的次数累计在缓存目录的 stats 文件中。
+ * 批量编译时多个线程共用一个 CompileCache，计数由 mutex_ 保护
+ *
+ * 缓存只是加速手段，文件系统出错时视为未命中，不影响编译
+ */
+class CompileCache {
+  public:
+    explicit CompileCache(const std::filesystem::path &dir,
+                          std::uintmax_t max_size = 64 << 20);
+
+    // 可执行文件的大小与修改时间，编译器重新构建后旧的缓存项自然失效
+    static std::string compiler_version();
+
+    bool lookup(const std::string &key, std::string &output);
+    void store(const std::string &key, const std::string &output);
+
+    // 本进程与缓存目录累计的命中、未命中次数
+    std::string stats() const;
+
+  private:
+    std::filesystem::path entry_path(const std::string &key) const;
+    void evict();
+    void record(bool hit);
+
+    mutable std::mutex mutex_;
+    std::filesystem::path dir_;
+    std::uintmax_t max_size_;
+    unsigned hits_{0};
+    unsigned misses_{0};
+    unsigned long long total_hits_{0};
+    unsigned long long total_misses_{0};
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Module.hpp"
+#include "PhiElimination.hpp"
+#include "RegAlloc.hpp"
+
+#include <string>
+#include <unordered_map>
+
+/**
+ * x86-64 后端：把 lightir 翻译为 GNU as 语法（AT&T）的汇编，
+ * 调用约定遵循 System V ABI，可以直接与 cminus_io 链接
+ *
+ * phi 由 PhiElimination 消除，每个虚拟寄存器在栈帧中占一个 8 字节的槽，
+ * alloca 的空间紧随其后。指令尽量直接以寄存器、栈槽或立即数为操作数，
+ * 在结果所在的寄存器中计算；操作数形式不合法时才经由 rax/rcx/xmm0/xmm1 中转
+ *
+ * 开启 regalloc 时由 RegAlloc 把虚拟寄存器分配到 rbx、r10、r12-r15
+ * 与 xmm8-xmm15，其余的寄存器留作参数传递与计算的临时寄存器
+ */
+class CodeGen {
+  public:
+    // 物理寄存器编号，按指令编码顺序排列
+    enum Reg : int {
+        RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+        R8, R9, R10, R11, R12, R13, R14, R15,
+        XMM0, XMM1, XMM2, XMM3, XMM4, XMM5, XMM6, XMM7,
+        XMM8, XMM9, XMM10, XMM11, XMM12, XMM13, XMM14, XMM15,
+    };
+
+    explicit CodeGen(Module *m, bool regalloc = false);
+
+    void run();
+    std::string print() const { return output_; }
+
+    // 按类型选择寄存器名：浮点为 xmm，指针为 64 位，其余为 32 位
+    static std::string reg_name(int reg, Type *ty);
+    static std::string reg_name8(int reg);
+
+  private:
+    void split_critical_edges(Function *f);
+    void gen_global_var(GlobalVariable *gv);
+    void gen_constant(Constant *c);
+    void gen_function(Function *f);
+    void gen_instr(Instruction *inst);
+
+    void gen_ret(ReturnInst *inst);
+    void gen_br(BranchInst *inst);
+    void gen_binary(Instruction *inst);
+    void gen_cmp(Instruction *inst);
+    void gen_fcmp(Instruction *inst);
+    // 把 al 中的比较结果零扩展后写入 inst
+    void gen_setcc_result(Instruction *inst);
+    void gen_load(LoadInst *inst);
+    void gen_store(StoreInst *inst);
+    void gen_gep(GetElementPtrInst *inst);
+    void gen_call(CallInst *inst);
+    void gen_cast(Instruction *inst);
+    // 在 bb 的终结指令之前执行 phi 消除产生的复制
+    void gen_copies(BasicBlock *bb);
+
+    // 从栈槽把 pred -> succ 这条边上需要的值装回寄存器
+    void gen_reloads(BasicBlock *pred, BasicBlock *succ);
+    // 在栈帧底部保存或恢复用到的被调用者保存寄存器
+    void save_callee_saved(bool save);
+
+    // 把 val 读入寄存器 reg / 把寄存器 reg 写回 val 所在的位置，
+    // 读在 cur_pos_ 处进行，写在 cur_pos_ + 1 处进行
+    void load_value(Value *val, int reg);
+    void store_value(int reg, Value *val);
+    void load_vreg(int vreg, int reg);
+    void store_vreg(int reg, int vreg);
+    std::string vreg_loc(int vreg) const;
+
+    // 以下都针对 cur_pos_：val 所在的物理寄存器，不在寄存器中时返回 -1
+    int value_reg(Value *val) const;
+    // 写 val 的指令应当把结果放在哪个寄存器，没有分到寄存器时为 scratch
+    int result_reg(Value *val, int scratch) const;
+    // 可以直接作为指令操作数的形式：寄存器、栈槽或整数立即数；
+    // 浮点常量与地址需要先计算，返回空串
+    std::string operand(Value *val) const;
+    std::string vreg_operand(int vreg) const;
+    // 同 operand，不能直接使用时读入 scratch
+    std::string operand_or_load(Value *val, int scratch);
+    // 指针 ptr 所指的内存操作数，必要时把 ptr 读入 rax
+    std::string address(Value *ptr);
+
+    void emit(const std::string &inst) { output_ += "\t" + inst + "\n"; }
+    void emit_label(const std::string &label) { output_ += label + ":\n"; }
+
+    Module *m_;
+    bool regalloc_;
+    PhiElimination phi_elim_;
+    RegAlloc reg_alloc_;
+    std::string output_;
+
+    // 当前函数的状态
+    Function *func_{nullptr};
+    std::unordered_map<BasicBlock *, std::string> label_;
+    // 紧接在当前块之后的块，跳到它时可以省去 jmp
+    BasicBlock *next_bb_{nullptr};
+    std::unordered_map<Value *, int> alloca_offset_;
+    int frame_size_{0};
+    int callee_save_offset_{0};
+    int cur_pos_{0};
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Module.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * 不依赖 LLVM 后端的 lightir 解释器
+ *
+ * 执行前先把每个函数翻译为寄存器式的字节码：每个值占帧中的一个槽，
+ * 常量与全局变量的地址预先放在帧模板中，操作数都是槽编号；
+ * 跳转目标解析为字节码下标，phi 变为边上预先算好的复制序列。
+ * 执行时用 computed goto 直接跳到下一条字节码的处理代码（不支持时退化为 switch），
+ * 函数调用与返回也在同一个分派循环中完成，递归深度只受槽栈大小限制
+ *
+ * input、output、outputFloat、neg_idx_except 按 io.c 的语义内置实现，
+ * __profile_init 直接调用 io.c 中的实现
+ */
+class Interpreter {
+  public:
+    explicit Interpreter(Module *m);
+    ~Interpreter();
+
+    // 执行 main 并返回其返回值（main 为 void 时返回 0）
+    int run();
+
+    union Slot {
+        int32_t i;
+        float f;
+        char *p;
+    };
+
+  private:
+    struct FuncCode;
+
+    void lower_function(Function *f, FuncCode &code);
+    void init_global(char *addr, Constant *init);
+    // 从 entry 开始执行直到它返回；函数调用不占用本机栈
+    Slot execute(const FuncCode &entry);
+    // 在槽栈顶建立 code 的帧，返回其槽，mem 为其 alloca 内存；空间不足时报错退出
+    Slot *push_frame(const FuncCode &code, char *&mem);
+    void pop_frame(const FuncCode &code);
+
+    Module *m_;
+    std::unordered_map<Function *, unsigned> func_id_;
+    std::vector<std::unique_ptr<FuncCode>> funcs_;
+
+    std::vector<char> globals_;
+    std::unordered_map<Value *, char *> global_addr_;
+
+    // 所有调用共用的槽栈与 alloca 内存栈，大小固定，保证地址不会失效
+    std::vector<Slot> slot_stack_;
+    std::vector<char> mem_stack_;
+    size_t slot_top_{0};
+    size_t mem_top_{0};
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Module.hpp"
+
+/**
+ * 用 LLVM ORC 在进程内即时编译并执行 lightir 模块
+ *
+ * 模块先由 LLVMGen 翻译为 llvm::Module，交给 LLJIT 编译为本机代码；
+ * input、output、outputFloat、neg_idx_except 与 __profile_init 直接绑定到
+ * io.c 中的实现，不需要生成临时文件，也不需要另外链接
+ */
+class JIT {
+  public:
+    explicit JIT(Module *m) : m_(m) {}
+
+    // 执行 main 并返回其返回值（main 为 void 时返回 0），出错时返回 -1
+    int run();
+
+  private:
+    Module *m_;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Module.hpp"
+
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class PhiInst;
+
+/**
+ * 把 lightir 直接翻译为内存中的 llvm::Module，省去打印文本 IR
+ * 再由 LLVM 重新解析的开销，结果可以写成 bitcode 或交给 LLVM 继续处理
+ *
+ * 指令按基本块的排列顺序翻译：定值之前的使用（不可达块中可能出现）
+ * 先用占位值代替，定值时再替换；phi 的参数在整个函数翻译完成后
+ * 按 LLVM 中的前驱逐个补齐，没有参数的前驱取 undef
+ */
+class LLVMGen {
+  public:
+    LLVMGen(Module *m, const std::string &source_filename);
+
+    // 生成的模块不能通过 LLVM 的校验时报告到标准错误并返回 false
+    bool run();
+    llvm::Module &get_llvm_module() { return *llvm_module_; }
+    void write_bitcode(std::ostream &os);
+    // 交出 llvm::Module 及其所在的 LLVMContext，之后不能再使用本对象
+    std::pair<std::unique_ptr<llvm::Module>,
+              std::unique_ptr<llvm::LLVMContext>>
+    release();
+
+  private:
+    void gen_global_var(GlobalVariable *gv);
+    void gen_function(Function *f);
+    void gen_instr(Instruction *inst);
+    void gen_phi_incoming(PhiInst *phi);
+
+    llvm::Type *get_type(Type *ty);
+    llvm::Constant *get_constant(Constant *c);
+    llvm::Value *get_value(Value *val);
+    void define(Value *val, llvm::Value *llvm_val);
+
+    Module *m_;
+    std::unique_ptr<llvm::LLVMContext> ctx_;
+    std::unique_ptr<llvm::Module> llvm_module_;
+    std::unique_ptr<llvm::IRBuilder<>> builder_;
+
+    std::unordered_map<Value *, llvm::Value *> values_;
+    // 尚未定值就被使用的值及其占位值
+    std::unordered_map<Value *, llvm::Argument *> forward_refs_;
+    // 当前函数中等待补齐参数的 phi
+    std::vector<PhiInst *> phis_;
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "BasicBlock.hpp"
+#include "Function.hpp"
+#include "PhiElimination.hpp"
+
+#include <climits>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * 线性扫描寄存器分配，对象是 PhiElimination 给出的虚拟寄存器
+ *
+ * 指令按基本块的排列顺序线性编号，每条指令占两个位置：偶数位置读操作数，
+ * 奇数位置写结果；终结指令之后依次是 phi 消除产生的各条复制，
+ * 因此顺序化的复制经寄存器分配后仍然正确
+ *
+ * 每个虚拟寄存器的活跃区间取其所有活跃位置的包络（不含空洞）。
+ * 整数与浮点各自一类寄存器；跨越调用的区间只能使用被调用者保存的寄存器。
+ * 寄存器不足时比较溢出代价（使用次数按循环深度加权，再除以区间长度），
+ * 代价低的区间在当前位置被切分：之前留在寄存器中，之后只存在于栈槽中。
+ * 被切分的区间在每次定值时都写回栈槽，控制流从栈槽部分回到寄存器部分的边上
+ * 需要重新装入（get_reloads），为此调用者需要事先切分全部关键边
+ */
+class RegAlloc {
+  public:
+    struct RegClass {
+        std::vector<int> caller_saved;
+        std::vector<int> callee_saved;
+    };
+    static constexpr int no_split = INT_MAX;
+
+    RegAlloc(RegClass int_regs, RegClass float_regs)
+        : classes_{std::move(int_regs), std::move(float_regs)} {}
+
+    void run(Function *f, const PhiElimination &phi_elim);
+
+    // 指令读操作数的位置，写结果的位置为其后一个
+    int get_pos(Instruction *inst) const { return pos_.at(inst); }
+    // bb 末尾第 idx 条复制读操作数的位置
+    int get_copy_pos(BasicBlock *bb, unsigned idx) const {
+        return copy_begin_.at(bb) + 2 * idx;
+    }
+    // vreg 在 pos 处所在的寄存器，在栈槽中时返回 -1
+    int get_reg_at(int vreg, int pos) const {
+        auto &interval = intervals_[vreg];
+        return pos < interval.split ? interval.reg : -1;
+    }
+    // 没有分到寄存器或被切分过的 vreg 需要在栈槽中保存
+    bool needs_slot(int vreg) const {
+        auto &interval = intervals_[vreg];
+        return interval.reg == -1 or interval.split != no_split;
+    }
+    // 沿 pred -> succ 这条边需要从栈槽装入寄存器的 (vreg, 寄存器)
+    const std::vector<std::pair<int, int>> &
+    get_reloads(BasicBlock *pred, BasicBlock *succ) const {
+        static const std::vector<std::pair<int, int>> empty;
+        auto it = reloads_.find({pred, succ});
+        return it == reloads_.end() ? empty : it->second;
+    }
+    const std::vector<int> &get_used_callee_saved() const {
+        return used_callee_saved_;
+    }
+
+  private:
+    struct Interval {
+        int start{INT_MAX};
+        int end{-1};
+        double weight{0};
+        bool crosses_call{false};
+        int reg{-1};
+        int split{no_split};
+    };
+
+    void number_instrs(Function *f, const PhiElimination &phi_elim);
+    void compute_loop_depth(Function *f);
+    void build_intervals(Function *f);
+    void linear_scan(const RegClass &reg_class, std::vector<int> &vregs);
+    void resolve(Function *f);
+
+    RegClass classes_[2];
+
+    // 每个块中按顺序出现的读写事件，pos 为位置，def 区分读写
+    struct Event {
+        int vreg;
+        int pos;
+        bool def;
+    };
+    std::unordered_map<BasicBlock *, std::vector<Event>> events_;
+    std::unordered_map<Instruction *, int> pos_;
+    std::unordered_map<BasicBlock *, int> copy_begin_;
+    std::unordered_map<BasicBlock *, int> block_begin_;
+    std::unordered_map<BasicBlock *, int> block_end_;
+    std::vector<int> call_pos_;
+    std::unordered_map<BasicBlock *, int> loop_depth_;
+
+    std::vector<Type *> vreg_type_;
+    std::unordered_map<BasicBlock *, BitVector> live_in_;
+    std::vector<Interval> intervals_;
+    std::map<std::pair<BasicBlock *, BasicBlock *>,
+             std::vector<std::pair<int, int>>>
+        reloads_;
+    std::vector<int> used_callee_saved_;
+};
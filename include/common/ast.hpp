@@ -4,6 +4,11 @@
 extern "C" {
 #include "syntax_tree.h"
 extern syntax_tree *parse(const char *input);
+// 分析内存中的 len 字节，不要求以 '\0' 结尾；与 parse 一样可以在多个线程中同时调用
+extern syntax_tree *parse_buffer(const char *buffer, size_t len);
+// 原地分析 buffer，不复制：最后两个字节必须是 '\0'（不属于源代码），
+// 分析期间 flex 会临时改写其中的字节，返回前恢复
+extern syntax_tree *parse_buffer_inplace(char *buffer, size_t size);
 }
 #include "User.hpp"
 #include <memory>
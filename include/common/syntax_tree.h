@@ -1,30 +1,38 @@
 #ifndef __SYNTAXTREE_H__
 #define __SYNTAXTREE_H__
 
+#include <stddef.h>
 #include <stdio.h>
 
-#define SYNTAX_TREE_NODE_NAME_MAX 30
+struct syntax_tree_arena;
 
+// 结点与其孩子数组在所属语法树的 arena 中连续分配，孩子数组的长度在建立时确定；
+// name 指向驻留在同一 arena 中的字符串，同名的结点共用一份，长度不受限制
 struct _syntax_tree_node {
-    struct _syntax_tree_node *parent;
-    struct _syntax_tree_node *children[10];
+    struct _syntax_tree_node **children;
     int children_num;
+    int children_max;
 
-    char name[SYNTAX_TREE_NODE_NAME_MAX];
+    const char *name;
 };
 typedef struct _syntax_tree_node syntax_tree_node;
 
-syntax_tree_node *new_anon_syntax_tree_node();
-syntax_tree_node *new_syntax_tree_node(const char *name);
-int syntax_tree_add_child(syntax_tree_node *parent, syntax_tree_node *child);
-void del_syntax_tree_node(syntax_tree_node *node, int recursive);
-
 struct _syntax_tree {
     syntax_tree_node *root;
+    struct syntax_tree_arena *arena;
 };
 typedef struct _syntax_tree syntax_tree;
 
+// 在 tree 中建立最多有 children_max 个孩子的结点
+syntax_tree_node *new_syntax_tree_node(syntax_tree *tree, const char *name,
+                                       int children_max);
+// 同上，name 取前 len 个字节，不要求以 '\0' 结尾
+syntax_tree_node *new_syntax_tree_node_n(syntax_tree *tree, const char *name,
+                                         size_t len, int children_max);
+int syntax_tree_add_child(syntax_tree_node *parent, syntax_tree_node *child);
+
 syntax_tree *new_syntax_tree();
+// 整棵树的结点与名字随 arena 一起释放，不逐个遍历结点
 void del_syntax_tree(syntax_tree *tree);
 void print_syntax_tree(FILE *fout, syntax_tree *tree);
 
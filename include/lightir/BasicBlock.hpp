@@ -4,6 +4,7 @@
 #include "Value.hpp"
 
 #include <list>
+#include <map>
 #include <llvm/ADT/ilist.h>
 #include <llvm/ADT/ilist_node.h>
 #include <set>
@@ -67,6 +68,19 @@ class BasicBlock : public Value, public llvm::ilist_node<BasicBlock> {
     bool empty() const { return instr_list_.empty(); }
     int get_num_of_instr() const { return instr_list_.size(); }
 
+    /****************api about profile****************/
+    // 剖析数据给出的执行次数，未知时为 -1
+    long long get_profile_count() const { return profile_count_; }
+    void set_profile_count(long long count) { profile_count_ = count; }
+    // 到后继 succ 的边的执行次数，未知时为 -1
+    long long get_edge_count(BasicBlock *succ) const {
+        auto it = edge_counts_.find(succ);
+        return it == edge_counts_.end() ? -1 : it->second;
+    }
+    void set_edge_count(BasicBlock *succ, long long count) {
+        edge_counts_[succ] = count;
+    }
+
     /****************api about accessing parent****************/
     Function *get_parent() { return parent_; }
     Module *get_module();
@@ -82,4 +96,6 @@ class BasicBlock : public Value, public llvm::ilist_node<BasicBlock> {
     std::list<BasicBlock *> succ_bbs_;
     llvm::ilist<Instruction> instr_list_;
     Function *parent_;
+    long long profile_count_{-1};
+    std::map<BasicBlock *, long long> edge_counts_;
 };
@@ -30,6 +30,15 @@ class IRBuilder {
     IBinaryInst *create_isdiv(Value *lhs, Value *rhs) {
         return IBinaryInst::create_sdiv(lhs, rhs, this->BB_);
     }
+    IBinaryInst *create_shl(Value *lhs, Value *rhs) {
+        return IBinaryInst::create_shl(lhs, rhs, this->BB_);
+    }
+    IBinaryInst *create_ashr(Value *lhs, Value *rhs) {
+        return IBinaryInst::create_ashr(lhs, rhs, this->BB_);
+    }
+    IBinaryInst *create_lshr(Value *lhs, Value *rhs) {
+        return IBinaryInst::create_lshr(lhs, rhs, this->BB_);
+    }
 
     ICmpInst *create_icmp_eq(Value *lhs, Value *rhs) {
         return ICmpInst::create_eq(lhs, rhs, this->BB_);
@@ -20,6 +20,10 @@ class Instruction : public User, public llvm::ilist_node<Instruction> {
         sub,
         mul,
         sdiv,
+        // Shift operators
+        shl,
+        ashr,
+        lshr,
         // float binary operators
         fadd,
         fsub,
@@ -86,6 +90,10 @@ class Instruction : public User, public llvm::ilist_node<Instruction> {
     bool is_sub() const { return op_id_ == sub; }
     bool is_mul() const { return op_id_ == mul; }
     bool is_div() const { return op_id_ == sdiv; }
+    bool is_shl() const { return op_id_ == shl; }
+    bool is_ashr() const { return op_id_ == ashr; }
+    bool is_lshr() const { return op_id_ == lshr; }
+    bool is_shift() const { return shl <= op_id_ and op_id_ <= lshr; }
 
     bool is_fadd() const { return op_id_ == fadd; }
     bool is_fsub() const { return op_id_ == fsub; }
@@ -102,8 +110,8 @@ class Instruction : public User, public llvm::ilist_node<Instruction> {
     bool is_zext() const { return op_id_ == zext; }
 
     bool isBinary() const {
-        return (is_add() || is_sub() || is_mul() || is_div() || is_fadd() ||
-                is_fsub() || is_fmul() || is_fdiv()) &&
+        return (is_add() || is_sub() || is_mul() || is_div() || is_shift() ||
+                is_fadd() || is_fsub() || is_fmul() || is_fdiv()) &&
                (get_num_operand() == 2);
     }
 
@@ -138,6 +146,9 @@ class IBinaryInst : public BaseInst<IBinaryInst> {
     static IBinaryInst *create_sub(Value *v1, Value *v2, BasicBlock *bb);
     static IBinaryInst *create_mul(Value *v1, Value *v2, BasicBlock *bb);
     static IBinaryInst *create_sdiv(Value *v1, Value *v2, BasicBlock *bb);
+    static IBinaryInst *create_shl(Value *v1, Value *v2, BasicBlock *bb);
+    static IBinaryInst *create_ashr(Value *v1, Value *v2, BasicBlock *bb);
+    static IBinaryInst *create_lshr(Value *v1, Value *v2, BasicBlock *bb);
 
     virtual std::string print() override;
     Instruction *clone(BasicBlock *prt) const override {
@@ -211,13 +222,7 @@ public:
 
     virtual std::string print() override;
     Function *func_;
-    Instruction *clone(BasicBlock *prt) const override {
-            if(get_operands().size() == 1){
-                return new CallInst(func_, {}, prt);
-            }
-        return new CallInst(
-            func_, {get_operands().begin() + 1, get_operands().end()}, prt);
-    }
+    Instruction *clone(BasicBlock *prt) const override;
 };
 
 class BranchInst : public BaseInst<BranchInst> {
@@ -12,6 +12,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 class GlobalVariable;
 class Function;
@@ -41,6 +42,16 @@ class Module {
     std::string print();
 
   private:
+    friend class ConstantInt;
+    friend class ConstantFP;
+    friend class ConstantZero;
+
+    // 常量按模块缓存，随模块一起释放；声明在函数之前，析构时晚于使用它们的指令
+    std::unordered_map<int, std::unique_ptr<ConstantInt>> int_consts_;
+    std::unordered_map<bool, std::unique_ptr<ConstantInt>> bool_consts_;
+    std::unordered_map<float, std::unique_ptr<ConstantFP>> float_consts_;
+    std::unordered_map<Type *, std::unique_ptr<ConstantZero>> zero_consts_;
+
     // The global variables in the module
     llvm::ilist<GlobalVariable> global_list_;
     // The functions in the module
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Instruction.hpp"
+#include "PassManager.hpp"
+#include "Value.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+enum class AliasResult { NoAlias, MayAlias, MustAlias };
+
+/**
+ * 基础别名分析：将指针沿 gep 链回溯到基址（alloca / 全局变量 / 形参 /
+ * 从内存中读出的指针），并累计常量偏移，据此回答两个指针是否可能指向同一地址
+ *
+ * 使用方式与 Dominators 相同：由需要的 Pass 自行创建并调用 run()，
+ * 之后通过 alias() 查询，查询结果按指针对缓存；IR 改变后需重新 run()
+ */
+class AliasAnalysis : public Pass {
+  public:
+    // 指针分解的结果：base + offset（单位为字节）
+    struct PtrInfo {
+        Value *base;
+        int offset;
+        bool const_offset; // offset 是否完全由常量下标决定
+    };
+
+    explicit AliasAnalysis(Module *m) : Pass(m) {}
+    ~AliasAnalysis() = default;
+
+    void run() override;
+
+    AliasResult alias(Value *ptr1, Value *ptr2);
+    bool may_alias(Value *ptr1, Value *ptr2) {
+        return alias(ptr1, ptr2) != AliasResult::NoAlias;
+    }
+
+    static PtrInfo decompose(Value *ptr);
+    static Value *get_underlying_object(Value *ptr) {
+        return decompose(ptr).base;
+    }
+    // alloca 或全局变量：可以确定指向一块独立的内存
+    static bool is_identified_object(Value *base);
+
+    // alloca 的地址是否被传出（作为值存储、传参、参与 phi 等）
+    bool is_escaped(AllocaInst *alloca);
+
+    // for debug：函数中 load/store 访问的每一对不同地址的查询结果
+    std::string print(Function *f);
+
+  private:
+    struct PairHash {
+        std::size_t operator()(const std::pair<Value *, Value *> &p) const {
+            auto lhs = std::hash<Value *>()(p.first);
+            auto rhs = std::hash<Value *>()(p.second);
+            return lhs ^ (rhs << 1);
+        }
+    };
+
+    AliasResult compute_alias(Value *ptr1, Value *ptr2);
+    bool compute_escaped(Value *addr);
+
+    std::unordered_map<std::pair<Value *, Value *>, AliasResult, PairHash>
+        cache_;
+    std::unordered_map<AllocaInst *, bool> escaped_;
+};
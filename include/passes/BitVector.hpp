@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// 定长位向量，集合运算按 64 位字整体进行，便于编译器向量化
+class BitVector {
+  public:
+    BitVector() = default;
+    explicit BitVector(unsigned size)
+        : size_(size), words_((size + 63) / 64, 0) {}
+
+    unsigned size() const { return size_; }
+    void set(unsigned i) { words_[i / 64] |= uint64_t(1) << (i % 64); }
+    void reset(unsigned i) { words_[i / 64] &= ~(uint64_t(1) << (i % 64)); }
+    bool test(unsigned i) const {
+        return (words_[i / 64] >> (i % 64)) & 1;
+    }
+
+    // this |= other，返回是否有变化
+    bool merge(const BitVector &other) {
+        uint64_t changed = 0;
+        for (unsigned i = 0; i < words_.size(); i++) {
+            auto word = words_[i] | other.words_[i];
+            changed |= word ^ words_[i];
+            words_[i] = word;
+        }
+        return changed != 0;
+    }
+    // this = use | (out & ~def)，返回是否有变化
+    bool assign_transfer(const BitVector &use, const BitVector &out,
+                         const BitVector &def) {
+        uint64_t changed = 0;
+        for (unsigned i = 0; i < words_.size(); i++) {
+            auto word = use.words_[i] | (out.words_[i] & ~def.words_[i]);
+            changed |= word ^ words_[i];
+            words_[i] = word;
+        }
+        return changed != 0;
+    }
+
+    // 依次以每个置位的下标调用 f
+    template <typename F> void for_each(F f) const {
+        for (unsigned i = 0; i < words_.size(); i++) {
+            for (auto word = words_[i]; word != 0; word &= word - 1)
+                f(i * 64 + __builtin_ctzll(word));
+        }
+    }
+
+  private:
+    unsigned size_{0};
+    std::vector<uint64_t> words_;
+};
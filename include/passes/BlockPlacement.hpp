@@ -0,0 +1,39 @@
+#pragma once
+
+#include "BasicBlock.hpp"
+#include "Function.hpp"
+#include "PassManager.hpp"
+
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/**
+ * 基本块布局：把热的后继排在后面顺序执行（fall-through），冷块移到函数末尾
+ *
+ * 边的权重优先取 -profile-use 附加的边计数；没有剖析数据时按静态启发式估计：
+ * 块的频率按所在循环的嵌套深度估计（每层 x8），离开循环的条件分支一边概率取 1/8，
+ * 调用 neg_idx_except 的块视为冷块，概率为 0。
+ * 先按权重从大到小把边两端的链首尾相接（Pettis-Hansen），再从入口所在的链开始，
+ * 每次选与已放置的块之间边权重之和最大的链接在后面，冷链按原来的顺序放在最后
+ *
+ * 只改变 Function::get_basic_blocks() 的顺序，不改变控制流图，
+ * LLVM IR 输出与 -S 后端都按这个顺序生成代码
+ */
+class BlockPlacement : public Pass {
+  public:
+    BlockPlacement(Module *m) : Pass(m) {}
+
+    void run() override;
+
+  private:
+    void estimate_static(Function *f);
+    void estimate_profile(Function *f);
+    void place(Function *f);
+
+    std::vector<BasicBlock *> blocks_;
+    std::unordered_set<BasicBlock *> cold_;
+    std::map<std::pair<BasicBlock *, BasicBlock *>, double> weight_;
+};
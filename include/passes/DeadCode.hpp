@@ -1,5 +1,6 @@
 #pragma once
 
+#include "DominatorTree.hpp"
 #include "FuncInfo.hpp"
 #include "PassManager.hpp"
 
@@ -8,23 +9,37 @@
 /**
  * 死代码消除：参见
  *https://www.clear.rice.edu/comp512/Lectures/10Dead-Clean-SCCP.pdf
+ *
+ * aggressive 模式（ADCE）下条件跳转不再默认活跃：
+ * 只有当某条活跃指令所在的块控制依赖于它时才活跃，
+ * 死的条件跳转改为跳到最近的活跃后必经块，从而删除整段无用的分支和循环
  **/
 class DeadCode : public Pass {
   public:
-    DeadCode(Module *m) : Pass(m), func_info(std::make_shared<FuncInfo>(m)) {}
+    DeadCode(Module *m, bool aggressive = false)
+        : Pass(m), func_info(std::make_shared<FuncInfo>(m)),
+          aggressive(aggressive) {}
 
     void run();
 
   private:
     std::shared_ptr<FuncInfo> func_info;
+    bool aggressive;
     int ins_count{0}; // 用以衡量死代码消除的性能
     std::deque<Instruction *> work_list{};
     std::unordered_map<Instruction *, bool> marked{};
 
+    // ADCE 所需的后必经树，get_idom 返回 nullptr 表示虚拟出口
+    PostDomTree post_dom_tree{};
+    std::unordered_set<BasicBlock *> live_blocks{};
+
     void mark(Function *func);
     void mark(Instruction *ins);
+    void mark_live(Instruction *ins);
     bool sweep(Function *func);
     bool clear_basic_blocks(Function *func);
     bool is_critical(Instruction *ins);
     void sweep_globally();
+
+    bool rewrite_dead_branches(Function *func);
 };
@@ -0,0 +1,233 @@
+#pragma once
+
+#include "BasicBlock.hpp"
+#include "Function.hpp"
+
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// 正向控制流图：以入口块为根，求支配树
+struct ForwardCFG {
+    static std::list<BasicBlock *> &preds(BasicBlock *bb) {
+        return bb->get_pre_basic_blocks();
+    }
+    static std::list<BasicBlock *> &succs(BasicBlock *bb) {
+        return bb->get_succ_basic_blocks();
+    }
+    static std::vector<BasicBlock *> roots(Function *f) {
+        return {f->get_entry_block()};
+    }
+};
+
+// 反向控制流图：以所有 ret 块为根，求后必经树
+struct BackwardCFG {
+    static std::list<BasicBlock *> &preds(BasicBlock *bb) {
+        return bb->get_succ_basic_blocks();
+    }
+    static std::list<BasicBlock *> &succs(BasicBlock *bb) {
+        return bb->get_pre_basic_blocks();
+    }
+    static std::vector<BasicBlock *> roots(Function *f) {
+        std::vector<BasicBlock *> exits;
+        for (auto &bb : f->get_basic_blocks()) {
+            if (bb.is_terminated() and bb.get_terminator()->is_ret())
+                exits.push_back(&bb);
+        }
+        return exits;
+    }
+};
+
+/**
+ * 通用的支配树，CFG 参数决定方向（ForwardCFG / BackwardCFG）
+ *
+ * 所有根都挂在一个虚拟根（nullptr）下，因此多个 ret 块的后必经树
+ * 以虚拟出口为根。结点按后序编号，支配者、前驱等均存放在以编号为下标的
+ * 连续数组中，迭代求 idom 时的 intersect 只需比较编号
+ * 算法参见 Cooper, Harvey, Kennedy. A Simple, Fast Dominance Algorithm
+ *
+ * 从根出发不可达的块不在树中，is_reachable 返回 false
+ */
+template <typename CFG> class DominatorTree {
+  public:
+    void build(Function *f);
+
+    bool is_reachable(BasicBlock *bb) const { return id_.count(bb); }
+    // 根的直接支配者是虚拟根，返回 nullptr
+    BasicBlock *get_idom(BasicBlock *bb) const {
+        return node_[idom_[id_.at(bb)]];
+    }
+    bool dominates(BasicBlock *a, BasicBlock *b) const {
+        auto ia = id_.at(a), ib = id_.at(b);
+        return dfs_in_[ia] <= dfs_in_[ib] and dfs_out_[ib] <= dfs_out_[ia];
+    }
+    // 传入 nullptr 得到虚拟根的孩子，即各个根
+    const std::vector<BasicBlock *> &get_children(BasicBlock *bb) const {
+        return children_[id_.at(bb)];
+    }
+    const std::vector<BasicBlock *> &get_frontier(BasicBlock *bb) const {
+        return frontier_[id_.at(bb)];
+    }
+    // 不含虚拟根的后序
+    std::vector<BasicBlock *> get_post_order() const {
+        return {node_.begin(), node_.end() - 1};
+    }
+
+  private:
+    void compute_post_order(Function *f);
+    void compute_idom();
+    void compute_tree();
+    void compute_frontier();
+
+    std::unordered_map<BasicBlock *, unsigned> id_;
+    std::vector<BasicBlock *> node_; // 后序编号 -> 块，最后一个为虚拟根
+    std::vector<unsigned> pred_begin_; // 前驱按编号压缩存放
+    std::vector<unsigned> preds_;
+    std::vector<unsigned> idom_;
+    std::vector<unsigned> dfs_in_;
+    std::vector<unsigned> dfs_out_;
+    std::vector<std::vector<BasicBlock *>> children_;
+    std::vector<std::vector<BasicBlock *>> frontier_;
+};
+
+using DomTree = DominatorTree<ForwardCFG>;
+using PostDomTree = DominatorTree<BackwardCFG>;
+
+template <typename CFG> void DominatorTree<CFG>::build(Function *f) {
+    compute_post_order(f);
+    compute_idom();
+    compute_tree();
+    compute_frontier();
+}
+
+template <typename CFG>
+void DominatorTree<CFG>::compute_post_order(Function *f) {
+    id_.clear();
+    node_.clear();
+    auto roots = CFG::roots(f);
+
+    // 显式栈的深度优先遍历，先用 id_ 记录访问过的块
+    std::vector<std::pair<BasicBlock *, std::list<BasicBlock *>::iterator>>
+        stack;
+    auto visit = [&](BasicBlock *bb) {
+        id_[bb] = 0;
+        stack.emplace_back(bb, CFG::succs(bb).begin());
+    };
+    for (auto root : roots) {
+        if (id_.count(root))
+            continue;
+        visit(root);
+        while (not stack.empty()) {
+            auto &[bb, it] = stack.back();
+            if (it == CFG::succs(bb).end()) {
+                node_.push_back(bb);
+                stack.pop_back();
+                continue;
+            }
+            auto succ = *it++;
+            if (not id_.count(succ))
+                visit(succ);
+        }
+    }
+    node_.push_back(nullptr);
+    for (unsigned i = 0; i < node_.size(); i++) {
+        id_[node_[i]] = i;
+    }
+
+    unsigned root_id = node_.size() - 1;
+    pred_begin_.assign(1, 0);
+    preds_.clear();
+    for (unsigned i = 0; i < root_id; i++) {
+        // 各个根以虚拟根为前驱
+        if (std::find(roots.begin(), roots.end(), node_[i]) != roots.end())
+            preds_.push_back(root_id);
+        for (auto pred : CFG::preds(node_[i])) {
+            auto it = id_.find(pred);
+            if (it != id_.end())
+                preds_.push_back(it->second);
+        }
+        pred_begin_.push_back(preds_.size());
+    }
+    pred_begin_.push_back(preds_.size());
+}
+
+template <typename CFG> void DominatorTree<CFG>::compute_idom() {
+    unsigned root_id = node_.size() - 1;
+    const unsigned undefined = node_.size();
+    idom_.assign(node_.size(), undefined);
+    idom_[root_id] = root_id;
+
+    auto intersect = [&](unsigned b1, unsigned b2) {
+        while (b1 != b2) {
+            while (b1 < b2)
+                b1 = idom_[b1];
+            while (b2 < b1)
+                b2 = idom_[b2];
+        }
+        return b1;
+    };
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        // 逆后序
+        for (unsigned i = root_id; i-- > 0;) {
+            unsigned new_idom = undefined;
+            for (unsigned j = pred_begin_[i]; j < pred_begin_[i + 1]; j++) {
+                unsigned pred = preds_[j];
+                if (idom_[pred] == undefined)
+                    continue;
+                new_idom =
+                    new_idom == undefined ? pred : intersect(pred, new_idom);
+            }
+            if (idom_[i] != new_idom) {
+                idom_[i] = new_idom;
+                changed = true;
+            }
+        }
+    }
+}
+
+template <typename CFG> void DominatorTree<CFG>::compute_tree() {
+    unsigned root_id = node_.size() - 1;
+    children_.assign(node_.size(), {});
+    // 逆后序加入孩子，使孩子列表的顺序稳定
+    for (unsigned i = root_id; i-- > 0;) {
+        children_[idom_[i]].push_back(node_[i]);
+    }
+
+    dfs_in_.assign(node_.size(), 0);
+    dfs_out_.assign(node_.size(), 0);
+    unsigned order = 0;
+    std::vector<std::pair<unsigned, unsigned>> stack{{root_id, 0}};
+    dfs_in_[root_id] = order++;
+    while (not stack.empty()) {
+        auto &[node, child] = stack.back();
+        if (child == children_[node].size()) {
+            dfs_out_[node] = order++;
+            stack.pop_back();
+            continue;
+        }
+        unsigned next = id_[children_[node][child++]];
+        dfs_in_[next] = order++;
+        stack.emplace_back(next, 0);
+    }
+}
+
+template <typename CFG> void DominatorTree<CFG>::compute_frontier() {
+    frontier_.assign(node_.size(), {});
+    for (unsigned i = 0; i + 1 < node_.size(); i++) {
+        if (pred_begin_[i + 1] - pred_begin_[i] < 2)
+            continue;
+        for (unsigned j = pred_begin_[i]; j < pred_begin_[i + 1]; j++) {
+            // 同一个块的各个前驱按顺序处理，重复的边界只需与末尾比较
+            for (unsigned runner = preds_[j]; runner != idom_[i];
+                 runner = idom_[runner]) {
+                auto &df = frontier_[runner];
+                if (df.empty() or df.back() != node_[i])
+                    df.push_back(node_[i]);
+            }
+        }
+    }
+}
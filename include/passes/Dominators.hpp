@@ -1,6 +1,7 @@
 #pragma once
 
 #include "BasicBlock.hpp"
+#include "DominatorTree.hpp"
 #include "PassManager.hpp"
 
 #include <map>
@@ -44,15 +45,12 @@ class Dominators : public Pass {
 
   private:
 
-    void dfs(BasicBlock *bb, std::set<BasicBlock *> &visited);
-    void create_idom(Function *f);
-    void create_dominance_frontier(Function *f);
+    // idom 与支配边界由 DomTree 计算，这里只转存为按块索引的形式
+    void create_idom(Function *f, const DomTree &tree);
+    void create_dominance_frontier(Function *f, const DomTree &tree);
     void create_dom_tree_succ(Function *f);
     void create_dom_dfs_order(Function *f);
 
-    BasicBlock * intersect(BasicBlock *b1, BasicBlock *b2);
-
-    void create_reverse_post_order(Function *f);
     void set_idom(BasicBlock *bb, BasicBlock *idom) { idom_[bb] = idom; }
     void set_dominance_frontier(BasicBlock *bb, BBSet &df) {
         dom_frontier_[bb].clear();
@@ -61,19 +59,10 @@ class Dominators : public Pass {
     void add_dom_tree_succ_block(BasicBlock *bb, BasicBlock *dom_tree_succ_bb) {
         dom_tree_succ_blocks_[bb].insert(dom_tree_succ_bb);
     }
-    unsigned int get_post_order(BasicBlock *bb) {
-        return post_order_.at(bb);
-    }
     // for debug
     void print_idom(Function *f);
     void print_dominance_frontier(Function *f);
 
-    // TODO 补充需要的函数
-    std::list<BasicBlock *> reverse_post_order_{};
-    std::map<BasicBlock *, int> post_order_id_{}; // the root has highest ID
-
-    std::vector<BasicBlock *> post_order_vec_{}; // 逆后序
-    std::map<BasicBlock *, unsigned int> post_order_{}; // 逆后序
     std::map<BasicBlock *, BasicBlock *> idom_{};  // 直接支配
     std::map<BasicBlock *, BBSet> dom_frontier_{}; // 支配边界集合
     std::map<BasicBlock *, BBSet> dom_tree_succ_blocks_{}; // 支配树中的后继节点
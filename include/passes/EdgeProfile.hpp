@@ -0,0 +1,105 @@
+#pragma once
+
+#include "BasicBlock.hpp"
+#include "Function.hpp"
+#include "GlobalVariable.hpp"
+#include "PassManager.hpp"
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * 边剖析：插桩与读取剖析数据共用同一套边的编号
+ *
+ * 每个函数的边按块的排列顺序、跳转目标的顺序列出（同一对块只算一条），
+ * 另外加上虚拟出口 EXIT（用 nullptr 表示）：ret 块与调用 neg_idx_except
+ * 的块各有一条到 EXIT 的边，EXIT 到入口块的边计函数的调用次数。
+ * 按优先级（EXIT -> 入口、回边、关键边、其余）求一棵生成树，
+ * 只在不属于生成树的边上放计数器，树边的计数由流量守恒推出。
+ * 插桩必须在其他优化之前进行，读取剖析数据时的控制流图才能与插桩时一致；
+ * 控制流图的校验和用于发现不一致
+ */
+class EdgeProfile {
+  public:
+    struct Edge {
+        BasicBlock *src; // nullptr 为 EXIT
+        BasicBlock *dst; // nullptr 为 EXIT
+    };
+
+    explicit EdgeProfile(Function *f);
+
+    const std::vector<Edge> &get_edges() const { return edges_; }
+    // 边的计数器编号，树边为 -1
+    int get_counter(unsigned edge) const { return counter_[edge]; }
+    unsigned get_num_counters() const { return num_counters_; }
+    unsigned get_checksum() const { return checksum_; }
+
+    // 由计数器的值推出每条边的计数
+    std::vector<long long>
+    reconstruct(const std::vector<long long> &counters) const;
+
+    // 调用后不会返回的函数，调用处视为一条到 EXIT 的边
+    static bool is_noreturn_call(Instruction *inst);
+
+  private:
+    Function *f_;
+    std::vector<Edge> edges_;
+    std::vector<int> counter_;
+    unsigned num_counters_{0};
+    unsigned checksum_{0};
+};
+
+/**
+ * 插桩：在非树边上累加全局数组 __profile_counters 中的计数器，
+ * 函数名、校验和与计数器个数编码在 __profile_desc 中，
+ * main 开头调用 io.c 中的 __profile_init 注册，程序退出时写出剖析数据
+ */
+class EdgeProfiler : public Pass {
+  public:
+    EdgeProfiler(Module *m) : Pass(m) {}
+
+    void run() override;
+
+  private:
+    void instrument(Function *f, const EdgeProfile &profile, unsigned base);
+    // 在 pos 之前插入计数器 idx 的自增，pos 为空时插入到 bb 末尾
+    void insert_increment(BasicBlock *bb, Instruction *pos, unsigned idx);
+
+    GlobalVariable *counters_{nullptr};
+};
+
+/**
+ * 读取 __profile_init 写出的剖析数据，格式为
+ *   cminus-edge-profile 1
+ *   function <函数名> <校验和> <计数器个数>
+ *   <每个计数器的值，一行一个>
+ * 按函数名与校验和匹配函数，推出块与边的计数
+ * （-profile-use 在前端生成 IR 后、任何优化之前调用 annotate，
+ *  控制流图与插桩时相同，校验和才能匹配）
+ */
+class ProfileData {
+  public:
+    // 读取失败时返回 false
+    bool read(const std::string &path);
+
+    // f 没有匹配的剖析数据（函数名不存在或校验和不同）时返回 false
+    bool get_counts(Function *f,
+                    std::unordered_map<BasicBlock *, long long> &block_count,
+                    std::map<std::pair<BasicBlock *, BasicBlock *>, long long>
+                        &edge_count) const;
+
+    std::string print(Module *m) const;
+
+    // 把块与边的计数写到 IR 的各个基本块上，返回没有匹配剖析数据的函数名
+    std::vector<std::string> annotate(Module *m) const;
+
+  private:
+    struct FuncProfile {
+        unsigned checksum;
+        std::vector<long long> counters;
+    };
+    std::unordered_map<std::string, FuncProfile> funcs_;
+};
@@ -13,9 +13,16 @@ public:
 
     void inline_all_functions();
 
+    // 没有剖析数据时只内联少于 6 个块的函数；有剖析数据时不内联从未执行的调用点，
+    // 热调用点（次数不低于最热块的 1%）放宽到 24 个块；有多个 ret 的非 void 函数总是不内联
+    bool should_inline(Instruction *call, Function *func);
+
     // void log();
     std::set<std::string> outside_func={"output",
                                         "outputFloat",
                                         "input",
                                         "neg_idx_except"};
+
+  private:
+    long long hot_count_{0};
 };
\ No newline at end of file
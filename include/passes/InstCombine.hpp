@@ -0,0 +1,52 @@
+#pragma once
+
+#include "ConstPropagation.hpp"
+#include "Instruction.hpp"
+#include "PassManager.hpp"
+
+#include <deque>
+#include <unordered_set>
+
+/**
+ * 窥孔指令合并：以工作表的方式反复对指令做
+ *   - 常量折叠（包括比较、类型转换）
+ *   - 规范化：可交换运算/比较把常量放到右边，sub x, C 变为 add x, -C
+ *   - 代数恒等式化简（见 InstCombine.cpp 中的恒等式表）
+ *   - 乘除 2 的幂变为移位
+ *   - 消去 zext(icmp) 再与常量比较、fptosi(sitofp) 往返等冗余
+ * 被替换指令的使用者会重新加入工作表，直到不再变化
+ */
+class InstCombine : public Pass {
+  public:
+    InstCombine(Module *m) : Pass(m), folder_(m) {}
+
+    void run() override;
+
+  private:
+    void run_on_func(Function *func);
+
+    // 返回 nullptr 表示没有变化，返回 inst 本身表示原地修改，
+    // 否则返回用以替换 inst 的值
+    Value *combine(Instruction *inst);
+
+    Value *fold_constant(Instruction *inst);
+    bool canonicalize(Instruction *inst);
+    Value *simplify_identity(Instruction *inst);
+    Value *simplify_same_operands(Instruction *inst);
+    Value *reassociate(Instruction *inst);
+    Value *strength_reduce(Instruction *inst);
+    Value *simplify_cmp_of_zext(Instruction *inst);
+    Value *simplify_cast(Instruction *inst);
+    Value *simplify_phi(Instruction *inst);
+
+    Instruction *insert_before(Instruction *pos, Instruction *inst);
+    bool is_trivially_dead(Instruction *inst);
+    void push(Value *val);
+    void push_users(Value *val);
+    void erase(Instruction *inst);
+
+    ConstFolder folder_;
+    std::deque<Instruction *> work_list_;
+    std::unordered_set<Instruction *> in_work_list_;
+    int combined_count_{0}; // 用以衡量指令合并的效果
+};
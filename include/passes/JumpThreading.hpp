@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ConstPropagation.hpp"
+#include "PassManager.hpp"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * 跳转线程化：若基本块的跳转条件沿某条入边可以求出常量
+ * （例如条件来自本块中常量参数的 phi，再经过 icmp/zext），
+ * 就为这个前驱复制一份该块，副本直接跳到确定的后继
+ *
+ * 只复制不超过 dup_threshold 条指令的块，且不对循环头线程化，
+ * 以免产生不可归约的控制流；块中被外部使用的定值通过插入 phi 重建 SSA
+ */
+class JumpThreading : public Pass {
+  public:
+    JumpThreading(Module *m) : Pass(m), folder_(m) {}
+
+    void run() override;
+
+  private:
+    static constexpr int dup_threshold = 6;
+
+    bool run_on_func(Function *func);
+    void find_loop_headers(Function *func);
+
+    // 沿 pred -> bb 这条边求 val 的值，不是常量时返回 nullptr
+    ConstantInt *eval_on_edge(Value *val, BasicBlock *bb, BasicBlock *pred,
+                              int depth);
+    bool can_duplicate(BasicBlock *bb);
+    void thread_edge(BasicBlock *pred, BasicBlock *bb, BasicBlock *target);
+
+    // 原值 orig 在 bb、副本 copy 在 dup_bb 中定值，为其余的使用重建 SSA
+    void update_ssa(Instruction *orig, Value *copy, BasicBlock *bb,
+                    BasicBlock *dup_bb);
+    Value *read_at_exit(BasicBlock *block);
+    Value *read_at_entry(BasicBlock *block);
+    void fill_pending_phis();
+
+    ConstFolder folder_;
+    std::unordered_set<BasicBlock *> loop_headers_;
+    int threaded_count_{0}; // 用以衡量线程化的效果
+
+    // update_ssa 的状态：每个块入口处可见的定值，新插入的 phi，
+    // 以及其中还没有填入参数的 phi
+    Value *orig_{nullptr};
+    Value *copy_{nullptr};
+    BasicBlock *bb_{nullptr};
+    BasicBlock *dup_bb_{nullptr};
+    std::unordered_map<BasicBlock *, Value *> entry_val_;
+    std::vector<PhiInst *> new_phis_;
+    std::vector<PhiInst *> pending_phis_;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "BasicBlock.hpp"
+#include "BitVector.hpp"
+#include "PassManager.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * 活跃变量分析：对函数中的 SSA 值（形参与有返回值的指令）稠密编号，
+ * 每个基本块的 use/def/live-in/live-out 都是以编号为下标的位向量
+ *
+ * phi 的参数视为在对应前驱块末尾被使用，phi 本身在块入口定值，
+ * 因此不出现在所在块的 live-in 中
+ *
+ * 按正向控制流图的后序（逆后序的反向）迭代到不动点，
+ * 块内某条指令处的活跃集合通过从块末尾向前扫描得到
+ */
+class Liveness : public Pass {
+  public:
+    explicit Liveness(Module *m) : Pass(m) {}
+    ~Liveness() = default;
+
+    void run() override;
+    void run_on_func(Function *f);
+
+    // 编号在函数内从 0 开始连续分配
+    unsigned get_num_values(Function *f) const { return values_.at(f).size(); }
+    // 不参与分析的值（常量、全局变量、void 指令）返回 -1
+    int get_value_id(Value *val) const {
+        auto it = value_id_.find(val);
+        return it == value_id_.end() ? -1 : it->second;
+    }
+    Value *get_value(Function *f, unsigned id) const {
+        return values_.at(f)[id];
+    }
+
+    const BitVector &get_live_in(BasicBlock *bb) { return live_in_.at(bb); }
+    const BitVector &get_live_out(BasicBlock *bb) {
+        return live_out_.at(bb);
+    }
+    bool is_live_in(Value *val, BasicBlock *bb);
+    bool is_live_out(Value *val, BasicBlock *bb);
+
+    // 紧接在 inst 之前/之后活跃的值
+    BitVector get_live_before(Instruction *inst);
+    BitVector get_live_after(Instruction *inst);
+    bool is_live_before(Value *val, Instruction *inst);
+    bool is_live_after(Value *val, Instruction *inst);
+
+    std::vector<Value *> to_values(Function *f, const BitVector &set) const;
+
+    // for debug
+    std::string print(Function *f);
+
+  private:
+    void number_values(Function *f);
+    void compute_local(Function *f);
+    // 把 inst 的定值与使用从 live 中反向扣除/加入
+    void step_backward(Instruction *inst, BitVector &live);
+
+    std::unordered_map<Value *, unsigned> value_id_;
+    std::unordered_map<Function *, std::vector<Value *>> values_;
+
+    std::unordered_map<BasicBlock *, BitVector> use_;
+    std::unordered_map<BasicBlock *, BitVector> def_;
+    // 后继块中 phi 经由这条边使用的值
+    std::unordered_map<BasicBlock *, BitVector> phi_use_;
+    std::unordered_map<BasicBlock *, BitVector> live_in_;
+    std::unordered_map<BasicBlock *, BitVector> live_out_;
+};
@@ -1,32 +1,57 @@
 #pragma once
 
+#include "BitVector.hpp"
 #include "Dominators.hpp"
 #include "Instruction.hpp"
 #include "Value.hpp"
 
 #include <map>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 class Mem2Reg : public Pass {
   private:
     Function *func_;
     std::unique_ptr<Dominators> dominators_;
     std::map<Value *, Value *> phi_map;
-    // TODO 添加需要的变量
 
-    // 变量定值栈
-    std::map<Value *, std::vector<Value *>> var_val_stack;
-    // phi指令对应的左值(地址)
-    std::map<PhiInst *, Value *> phi_lval;
+    // 每个变量当前的最新定值，没有定值时为 nullptr
+    std::vector<Value *> var_val_;
+    // 撤销日志：记录每次定值前变量的旧值，离开基本块时回滚
+    std::vector<std::pair<unsigned, Value *>> undo_log_;
+    // phi指令对应的变量编号
+    std::unordered_map<PhiInst *, unsigned> phi_var_;
+
+    // 为 true 时只在变量活跃的支配边界上插入 phi（pruned SSA），
+    // 否则只为跨块活跃的变量插入 phi（semi-pruned SSA）
+    bool pruned_;
+    // 可提升变量与基本块的稠密编号，作为位向量的下标
+    std::unordered_map<Value *, unsigned> var_id_;
+    std::vector<Value *> vars_;
+    std::unordered_map<BasicBlock *, unsigned> bb_id_;
+    std::vector<BasicBlock *> bbs_;
+
+    void number_vars();
+    void rename_block(BasicBlock *bb);
+    void define(unsigned var, Value *val) {
+        undo_log_.emplace_back(var, var_val_[var]);
+        var_val_[var] = val;
+    }
+    // 按变量求每个块入口处活跃的变量集合，kill 为块内有 store 的变量
+    std::vector<BitVector>
+    compute_live_in(const std::vector<BitVector> &upward_use,
+                    const std::vector<BitVector> &kill);
 
   public:
-    Mem2Reg(Module *m) : Pass(m) {}
+    Mem2Reg(Module *m, bool pruned = false) : Pass(m), pruned_(pruned) {}
     ~Mem2Reg() = default;
 
     void run() override;
 
     void generate_phi();
-    void rename(BasicBlock *bb);
+    // 以显式栈沿支配树先序遍历，不随支配树深度递归（Dominators 的 dfs 序同样如此）
+    void rename();
 
     static inline bool is_global_variable(Value *l_val) {
         return dynamic_cast<GlobalVariable *>(l_val) != nullptr;
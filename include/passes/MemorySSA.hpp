@@ -0,0 +1,149 @@
+#pragma once
+
+#include "AliasAnalysis.hpp"
+#include "Dominators.hpp"
+#include "FuncInfo.hpp"
+#include "PassManager.hpp"
+
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class MemoryAccess {
+  public:
+    enum AccessKind { LiveOnEntry, Def, Use, Phi };
+
+    MemoryAccess(AccessKind kind, BasicBlock *bb, unsigned id)
+        : kind_(kind), bb_(bb), id_(id) {}
+    virtual ~MemoryAccess() = default;
+
+    AccessKind get_kind() const { return kind_; }
+    BasicBlock *get_block() const { return bb_; }
+    unsigned get_id() const { return id_; }
+
+    bool is_live_on_entry() const { return kind_ == LiveOnEntry; }
+    bool is_def() const { return kind_ == Def; }
+    bool is_use() const { return kind_ == Use; }
+    bool is_phi() const { return kind_ == Phi; }
+
+  private:
+    AccessKind kind_;
+    BasicBlock *bb_;
+    unsigned id_;
+};
+
+// store 与有副作用的 call 对应的内存定值，以及读内存的 load
+class MemoryUseOrDef : public MemoryAccess {
+  public:
+    MemoryUseOrDef(AccessKind kind, Instruction *inst, unsigned id)
+        : MemoryAccess(kind, inst->get_parent(), id), inst_(inst) {}
+
+    Instruction *get_instruction() const { return inst_; }
+    MemoryAccess *get_defining_access() const { return defining_; }
+    void set_defining_access(MemoryAccess *def) { defining_ = def; }
+
+  private:
+    Instruction *inst_;
+    MemoryAccess *defining_{nullptr};
+};
+
+class MemoryPhi : public MemoryAccess {
+  public:
+    MemoryPhi(BasicBlock *bb, unsigned id) : MemoryAccess(Phi, bb, id) {}
+
+    void add_incoming(MemoryAccess *access, BasicBlock *pre_bb) {
+        incoming_.emplace_back(access, pre_bb);
+    }
+    const std::vector<std::pair<MemoryAccess *, BasicBlock *>> &
+    get_incoming() const {
+        return incoming_;
+    }
+
+  private:
+    std::vector<std::pair<MemoryAccess *, BasicBlock *>> incoming_;
+};
+
+/**
+ * Memory SSA：把整块内存看作一个变量，store/非纯函数调用是定值（MemoryDef），
+ * load 是使用（MemoryUse），在定值块的迭代支配边界处放置 MemoryPhi，
+ * 再沿支配树重命名，使每个访存都直接指向到达它的内存定值
+ *
+ * get_clobbering_access 借助别名分析沿定值链向上跳过不相关的定值，
+ * 查询结果按 (起点, 地址) 缓存并做路径压缩，重复查询近似 O(1)
+ */
+class MemorySSA : public Pass {
+  public:
+    explicit MemorySSA(Module *m)
+        : Pass(m), func_info_(std::make_shared<FuncInfo>(m)) {}
+    ~MemorySSA() = default;
+
+    void run() override;
+    void run_on_func(Function *f);
+
+    MemoryUseOrDef *get_memory_access(Instruction *inst) {
+        auto it = inst_access_.find(inst);
+        return it == inst_access_.end() ? nullptr : it->second;
+    }
+    MemoryPhi *get_memory_phi(BasicBlock *bb) {
+        auto it = block_phi_.find(bb);
+        return it == block_phi_.end() ? nullptr : it->second;
+    }
+    MemoryAccess *get_live_on_entry(Function *f) {
+        return live_on_entry_.at(f);
+    }
+    // 块内的访存按指令顺序排列，MemoryPhi（若有）在最前
+    const std::vector<MemoryAccess *> &get_block_accesses(BasicBlock *bb) {
+        return block_accesses_[bb];
+    }
+
+    // walker：给出真正可能修改 loc 的最近定值
+    MemoryAccess *get_clobbering_access(Instruction *inst);
+    MemoryAccess *get_clobbering_access(MemoryAccess *start, Value *loc);
+
+    AliasAnalysis &get_alias_analysis() { return *alias_; }
+
+    // for debug：在访存指令前注明对应的 MemoryDef/MemoryUse，load 还注明 walker 的结果
+    std::string print(Function *f);
+
+  private:
+    struct PairHash {
+        std::size_t
+        operator()(const std::pair<MemoryAccess *, Value *> &p) const {
+            auto lhs = std::hash<MemoryAccess *>()(p.first);
+            auto rhs = std::hash<Value *>()(p.second);
+            return lhs ^ (rhs << 1);
+        }
+    };
+
+    bool is_mem_def(Instruction *inst);
+    bool is_mem_use(Instruction *inst);
+    bool clobbers(MemoryUseOrDef *def, Value *loc);
+
+    void create_accesses(Function *f);
+    void insert_phis(Function *f);
+    void rename(Function *f);
+
+    MemoryAccess *walk(MemoryAccess *start, Value *loc, unsigned &low);
+    MemoryAccess *resolve_phi(MemoryPhi *phi, Value *loc, unsigned &low);
+
+    std::string access_name(MemoryAccess *access);
+
+    std::shared_ptr<FuncInfo> func_info_;
+    std::unique_ptr<Dominators> dominators_;
+    std::unique_ptr<AliasAnalysis> alias_;
+
+    std::vector<std::unique_ptr<MemoryAccess>> accesses_;
+    std::unordered_map<Function *, MemoryAccess *> live_on_entry_;
+    std::unordered_map<Instruction *, MemoryUseOrDef *> inst_access_;
+    std::unordered_map<BasicBlock *, MemoryPhi *> block_phi_;
+    std::unordered_map<BasicBlock *, std::vector<MemoryAccess *>>
+        block_accesses_;
+
+    // walker 缓存，以及正在求解的 MemoryPhi 在求解栈中的深度
+    std::unordered_map<std::pair<MemoryAccess *, Value *>, MemoryAccess *,
+                       PairHash>
+        clobber_cache_;
+    std::unordered_map<MemoryPhi *, unsigned> visiting_;
+    unsigned next_id_{0};
+};
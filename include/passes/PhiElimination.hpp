@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Liveness.hpp"
+#include "PassManager.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * 消除 phi（退出 SSA）：为后端、解释器等不认识 phi 的使用者给出
+ * 每个 SSA 值所在的虚拟寄存器，以及在各个前驱块末尾需要执行的复制
+ *
+ * 1. 切分关键边：phi 所在块的前驱若有多个后继，则在这条边上插入新块，
+ *    此后每个需要复制的前驱都只有一个后继，复制可以放在其跳转之前
+ * 2. 合并：phi 与其参数在互不冲突（借助 Liveness 判断）时归入同一个
+ *    虚拟寄存器，这条边上相应的复制随之消失
+ * 3. 每条边上剩余的复制是并行复制，按 Boissinot 等人的算法顺序化，
+ *    交换或循环依赖时借助新的临时虚拟寄存器打破
+ *
+ * IR 中的 phi 保持不变，使用者根据 get_copies 的结果自行生成复制
+ */
+class PhiElimination : public Pass {
+  public:
+    struct Copy {
+        int dst;
+        int src;                  // 源为常量等没有虚拟寄存器的值时为 -1
+        Value *src_val{nullptr};  // src 为 -1 时的源值
+    };
+
+    explicit PhiElimination(Module *m) : Pass(m), liveness_(m) {}
+
+    void run() override;
+    void run_on_func(Function *f);
+
+    // 形参与有返回值的指令所在的虚拟寄存器，其余的值返回 -1
+    int get_vreg(Value *val) const {
+        auto it = vreg_.find(val);
+        return it == vreg_.end() ? -1 : it->second;
+    }
+    unsigned get_num_vregs(Function *f) const {
+        return vreg_type_.at(f).size();
+    }
+    Type *get_vreg_type(Function *f, int vreg) const {
+        return vreg_type_.at(f)[vreg];
+    }
+    // 在 bb 的终结指令之前按顺序执行的复制
+    const std::vector<Copy> &get_copies(BasicBlock *bb) const {
+        static const std::vector<Copy> empty;
+        auto it = copies_.find(bb);
+        return it == copies_.end() ? empty : it->second;
+    }
+
+    // for debug
+    std::string print(Function *f);
+
+    // 把一条边上的并行复制顺序化；types 为各虚拟寄存器的类型，
+    // 打破环时新建的临时虚拟寄存器追加在其后
+    static std::vector<Copy> sequentialize(const std::vector<Copy> &parallel,
+                                           std::vector<Type *> &types);
+
+  private:
+    void split_critical_edges(Function *f);
+    void coalesce(Function *f);
+    bool interfere(Value *a, Value *b);
+    // b 定值处 a 是否活跃
+    bool live_at_def(Value *a, Value *b);
+    int find(int id) {
+        while (parent_[id] != id)
+            id = parent_[id] = parent_[parent_[id]];
+        return id;
+    }
+
+    Liveness liveness_;
+    // 合并用的并查集，下标为 Liveness 中的值编号
+    std::vector<int> parent_;
+    std::vector<std::vector<Value *>> members_;
+
+    std::unordered_map<Value *, int> vreg_;
+    std::unordered_map<Function *, std::vector<Type *>> vreg_type_;
+    std::unordered_map<BasicBlock *, std::vector<Copy>> copies_;
+
+    int split_count_{0};
+    int coalesced_count_{0};
+    int copy_count_{0};
+};
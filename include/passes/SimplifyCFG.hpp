@@ -0,0 +1,39 @@
+#pragma once
+
+#include "BasicBlock.hpp"
+#include "Function.hpp"
+#include "PassManager.hpp"
+
+/**
+ * 控制流图化简，反复执行直到不再变化：
+ *   - 删除从入口不可达的基本块，并清除后继 phi 中对应的参数
+ *   - 条件为常量或两个目标相同的条件跳转改为无条件跳转
+ *   - 只含一条无条件跳转的空块：让前驱直接跳到它的后继
+ *   - 唯一后继只有唯一前驱时，把两个块合并为一个
+ * 所有变换都同步维护 phi 与 pre_bbs_/succ_bbs_
+ */
+class SimplifyCFG : public Pass {
+  public:
+    SimplifyCFG(Module *m) : Pass(m) {}
+
+    void run() override;
+
+    // 把 pred 末尾跳转中指向 old_succ 的目标改为 new_succ，并更新前驱后继表；
+    // new_succ 中的 phi 由调用者负责
+    static void redirect_edge(BasicBlock *pred, BasicBlock *old_succ,
+                              BasicBlock *new_succ);
+    // 在 pred -> succ 这条边上插入只含一条跳转的新块，succ 的 phi 随之更新
+    static BasicBlock *split_edge(BasicBlock *pred, BasicBlock *succ);
+    // 删除 bb 中所有 phi 来自 pred 的一个参数
+    static void remove_phi_incoming(BasicBlock *bb, BasicBlock *pred);
+
+  private:
+    bool run_on_func(Function *func);
+
+    bool remove_unreachable(Function *func);
+    bool fold_branch(BasicBlock *bb);
+    bool forward_empty_block(BasicBlock *bb);
+    bool merge_into_pred(BasicBlock *bb);
+
+    int changed_count_{0}; // 用以衡量化简的效果
+};
@@ -0,0 +1,149 @@
+#include "CompileCache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string fnv_hash(const std::string &data) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (unsigned char ch : data) {
+        hash ^= ch;
+        hash *= 1099511628211ull;
+    }
+    char buf[17];
+    std::snprintf(buf, sizeof(buf), "%016llx",
+                  static_cast<unsigned long long>(hash));
+    return buf;
+}
+
+// 先写到同目录下的临时文件，再 rename 覆盖目标
+bool write_atomic(const fs::path &path, const std::string &data) {
+    static std::atomic<unsigned> counter{0};
+    auto tmp = path;
+    tmp += ".tmp." + std::to_string(getpid()) + "." +
+           std::to_string(counter++);
+    {
+        std::ofstream out(tmp, std::ios::binary);
+        if (not out.write(data.data(), data.size()))
+            return false;
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec)
+        fs::remove(tmp, ec);
+    return not ec;
+}
+
+} // namespace
+
+CompileCache::CompileCache(const fs::path &dir, std::uintmax_t max_size)
+    : dir_(dir), max_size_(max_size) {
+    std::error_code ec;
+    fs::create_directories(dir_, ec);
+}
+
+std::string CompileCache::compiler_version() {
+    std::error_code ec;
+    auto exe = fs::read_symlink("/proc/self/exe", ec);
+    if (ec)
+        return "cminusfc";
+    auto size = fs::file_size(exe, ec);
+    auto time = fs::last_write_time(exe, ec).time_since_epoch().count();
+    return "cminusfc " + std::to_string(size) + " " + std::to_string(time);
+}
+
+fs::path CompileCache::entry_path(const std::string &key) const {
+    return dir_ / (fnv_hash(key) + ".out");
+}
+
+bool CompileCache::lookup(const std::string &key, std::string &output) {
+    auto path = entry_path(key);
+    std::ifstream in(path, std::ios::binary);
+    if (not in) {
+        record(false);
+        return false;
+    }
+    std::ostringstream buf;
+    buf << in.rdbuf();
+    auto entry = buf.str();
+    // 文件名只是键的哈希，比较存下的完整键，哈希冲突的另一项与损坏的项都算未命中
+    std::size_t key_size = 0;
+    auto newline = entry.find('\n');
+    bool matched = false;
+    if (newline != std::string::npos) {
+        auto [end, ec] =
+            std::from_chars(entry.data(), entry.data() + newline, key_size);
+        matched = ec == std::errc() and end == entry.data() + newline and
+                  key_size <= entry.size() - newline - 1 and
+                  entry.compare(newline + 1, key_size, key) == 0;
+    }
+    if (not matched) {
+        record(false);
+        return false;
+    }
+    output = entry.substr(newline + 1 + key_size);
+    // 命中的项移到 LRU 的最新端
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    record(true);
+    return true;
+}
+
+void CompileCache::store(const std::string &key, const std::string &output) {
+    auto entry = std::to_string(key.size()) + "\n" + key + output;
+    if (write_atomic(entry_path(key), entry))
+        evict();
+}
+
+void CompileCache::evict() {
+    std::vector<std::pair<fs::file_time_type, fs::path>> entries;
+    std::uintmax_t total = 0;
+    std::error_code ec;
+    for (auto &entry : fs::directory_iterator(dir_, ec)) {
+        if (entry.path().extension() != ".out")
+            continue;
+        auto size = entry.file_size(ec);
+        if (ec)
+            continue;
+        total += size;
+        entries.emplace_back(entry.last_write_time(ec), entry.path());
+    }
+    std::sort(entries.begin(), entries.end());
+    for (auto &[time, path] : entries) {
+        if (total <= max_size_)
+            break;
+        auto size = fs::file_size(path, ec);
+        if (fs::remove(path, ec))
+            total -= size;
+    }
+}
+
+void CompileCache::record(bool hit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    (hit ? hits_ : misses_)++;
+    // 累计次数为尽力而为：并发的进程同时更新时可能丢失其中一次
+    auto path = dir_ / "stats";
+    total_hits_ = total_misses_ = 0;
+    std::ifstream in(path);
+    in >> total_hits_ >> total_misses_;
+    (hit ? total_hits_ : total_misses_)++;
+    write_atomic(path, std::to_string(total_hits_) + " " +
+                           std::to_string(total_misses_) + "\n");
+}
+
+std::string CompileCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return "cache: " + std::to_string(hits_) + " hits, " +
+           std::to_string(misses_) + " misses (total " +
+           std::to_string(total_hits_) + " hits, " +
+           std::to_string(total_misses_) + " misses)";
+}
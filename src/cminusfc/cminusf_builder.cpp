@@ -4,12 +4,13 @@
 #define CONST_INT(num) ConstantInt::get(num, module.get())
 
 // types
-Type *VOID_T;
-Type *INT1_T;
-Type *INT32_T;
-Type *INT32PTR_T;
-Type *FLOAT_T;
-Type *FLOATPTR_T;
+// 类型属于各自的 Module，批量编译时每个线程各建一个 Module，因此按线程保存
+thread_local Type *VOID_T;
+thread_local Type *INT1_T;
+thread_local Type *INT32_T;
+thread_local Type *INT32PTR_T;
+thread_local Type *FLOAT_T;
+thread_local Type *FLOATPTR_T;
 
 bool promote(IRBuilder *builder, Value **l_val_p, Value **r_val_p) {
     bool is_int = false;
@@ -360,7 +361,6 @@ Value* CminusfBuilder::visit(ASTVar &node) {
         builder->set_insert_point(newBB);
         //context.now_bb = newBB;
         auto addr = scope.find(node.id);
-        std::cout << addr->get_type()->print() << std::endl;
         if(idx->get_type() == FLOAT_T) {
             if(addr->get_type()->get_pointer_element_type() == INT32PTR_T ||
             addr->get_type()->get_pointer_element_type() == FLOATPTR_T) {//函数参数是数组时
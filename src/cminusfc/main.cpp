@@ -1,39 +1,90 @@
 
+#include "CodeGen.hpp"
+#include "CompileCache.hpp"
+#include "Interpreter.hpp"
+#include "JIT.hpp"
+#include "LLVMGen.hpp"
 #include "Module.hpp"
 #include "PassManager.hpp"
 #include "ast.hpp"
+#include "AliasAnalysis.hpp"
+#include "MemorySSA.hpp"
+#include "BlockPlacement.hpp"
 #include "cminusf_builder.hpp"
 #include "PassManager.hpp"
 #include "DeadCode.hpp"
+#include "EdgeProfile.hpp"
 #include "Mem2Reg.hpp"
 #include "ConstPropagation.hpp"
 #include "FunctionInline.hpp"
+#include "InstCombine.hpp"
+#include "SimplifyCFG.hpp"
+#include "JumpThreading.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <set>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 using std::string;
 using std::operator""s;
 
 struct Config {
     string exe_name; // compiler exe name
-    std::filesystem::path input_file;
+    std::vector<std::filesystem::path> input_files;
     std::filesystem::path output_file;
 
     bool emitast{false};
     bool emitllvm{false};
+    bool emitbc{false};
+    bool emitasm{false};
+    bool run{false};
+    bool interpret{false};
+    bool regalloc{false};
     // optization config
+    bool mem2reg{false};
+    bool pruned_ssa{false};
     bool const_prop{false};
     bool dce{false};
+    bool adce{false};
     bool func_inline{false};
+    bool inst_combine{false};
+    bool simplify_cfg{false};
+    bool jump_threading{false};
+    bool block_placement{false};
+    // analysis dump config
+    bool print_alias{false};
+    bool print_memssa{false};
+    // profile config
+    bool profile_gen{false};
+    string profile_show;
+    string profile_use;
+    // cache config
+    string cache_dir;
+    bool cache_stats{false};
+    // batch config
+    unsigned jobs{std::max(1u, std::thread::hardware_concurrency())};
+    bool batch_report{false};
 
     Config(int argc, char **argv) : argc(argc), argv(argv) {
         parse_cmd_line();
         check();
     }
 
+    // 未指定 -o 时输出文件与输入同名、位于当前目录，扩展名按输出格式
+    std::filesystem::path output_path(const std::filesystem::path &input) const;
+    // 编译缓存的键，不可缓存（不写输出文件或读不到输入）时为空
+    string cache_key(const std::filesystem::path &input) const;
+
   private:
     int argc{-1};
     char **argv{nullptr};
@@ -45,11 +96,42 @@ struct Config {
     void print_err(const string &msg) const;
 };
 
-int main(int argc, char **argv) {
-    Config config(argc, argv);
+namespace {
+
+bool read_file(const std::filesystem::path &path, string &content) {
+    std::ifstream in(path, std::ios::binary);
+    if (not in)
+        return false;
+    std::ostringstream buf;
+    buf << in.rdbuf();
+    content = buf.str();
+    return true;
+}
+
+} // namespace
 
-    auto syntax_tree = parse(config.input_file.c_str());
-    auto ast = AST(syntax_tree);
+int compile(const Config &config, const std::filesystem::path &input_file,
+            CompileCache *cache) {
+    auto output_file = config.output_path(input_file);
+
+    // 命中缓存时直接写出结果，跳过分析、建树与所有的 pass
+    string cache_key;
+    if (cache)
+        cache_key = config.cache_key(input_file);
+    if (not cache_key.empty()) {
+        string output;
+        if (cache->lookup(cache_key, output)) {
+            std::ofstream(output_file, std::ios::binary) << output;
+            return 0;
+        }
+    }
+
+    // 打不开或有语法错误时 parse 已报告错误，返回失败而不退出进程，
+    // 批量编译中其他文件照常编译
+    auto tree = parse(input_file.c_str());
+    if (tree == nullptr)
+        return 1;
+    auto ast = AST(tree);
 
     if (config.emitast) { // if emit ast (lab1), print ast and return
         ASTPrinter printer;
@@ -60,37 +142,205 @@ int main(int argc, char **argv) {
         ast.run_visitor(builder);
         m = builder.getModule();
 
+        if (not config.profile_show.empty()) {
+            ProfileData profile;
+            if (not profile.read(config.profile_show)) {
+                std::cerr << "cannot read profile " << config.profile_show
+                          << std::endl;
+                return -1;
+            }
+            std::cout << profile.print(m.get());
+            return 0;
+        }
+
+        // 剖析数据在任何优化之前附加到 IR，此时的控制流图与插桩时相同
+        if (not config.profile_use.empty()) {
+            ProfileData profile;
+            if (not profile.read(config.profile_use)) {
+                std::cerr << "cannot read profile " << config.profile_use
+                          << std::endl;
+                return -1;
+            }
+            for (auto &name : profile.annotate(m.get())) {
+                std::cerr << "warning: no matching profile for function "
+                          << name << std::endl;
+            }
+        }
+
         PassManager PM(m.get());
+        // 插桩在所有优化之前，剖析数据才能与未优化的控制流图对应
+        if (config.profile_gen) {
+            PM.add_pass<EdgeProfiler>();
+        }
         // optimization 
         if(config.dce) {
-            PM.add_pass<DeadCode>();
+            PM.add_pass<DeadCode>(config.adce);
         }
 
         if(config.func_inline) {
             PM.add_pass<FunctionInline>();
-            PM.add_pass<DeadCode>();
+            PM.add_pass<DeadCode>(config.adce);
+        }
+
+        if(config.mem2reg) {
+            PM.add_pass<Mem2Reg>(config.pruned_ssa);
+            PM.add_pass<DeadCode>(config.adce);
         }
 
         if(config.const_prop) {
-            PM.add_pass<Mem2Reg>();
-            PM.add_pass<DeadCode>();
             PM.add_pass<ConstPropagation>();
-            PM.add_pass<DeadCode>();
+            PM.add_pass<DeadCode>(config.adce);
+        }
+
+        if(config.inst_combine) {
+            PM.add_pass<InstCombine>();
+            PM.add_pass<DeadCode>(config.adce);
+        }
+
+        if(config.simplify_cfg) {
+            PM.add_pass<SimplifyCFG>();
+            PM.add_pass<DeadCode>(config.adce);
+        }
+
+        if(config.jump_threading) {
+            PM.add_pass<JumpThreading>();
+            PM.add_pass<SimplifyCFG>();
+            PM.add_pass<DeadCode>(config.adce);
+        }
+        // 布局放在最后，之前的优化不再增删块
+        if (config.block_placement) {
+            PM.add_pass<BlockPlacement>();
         }
         PM.run();
 
-        std::ofstream output_stream(config.output_file);
+        // 分析结果的调试输出：对优化后的 IR 运行分析，打印到标准输出后结束
+        if (config.print_alias) {
+            AliasAnalysis alias(m.get());
+            alias.run();
+            for (auto &func : m->get_functions()) {
+                if (not func.is_declaration())
+                    std::cout << alias.print(&func);
+            }
+            return 0;
+        }
+        if (config.print_memssa) {
+            MemorySSA mssa(m.get());
+            mssa.run();
+            for (auto &func : m->get_functions()) {
+                if (not func.is_declaration())
+                    std::cout << "function " << func.get_name() << "\n"
+                              << mssa.print(&func);
+            }
+            return 0;
+        }
+        if (config.run) {
+            JIT jit(m.get());
+            return jit.run();
+        }
+        if (config.interpret) {
+            Interpreter interpreter(m.get());
+            return interpreter.run();
+        }
+
+        std::ostringstream output_stream;
         if (config.emitllvm) {
-            auto abs_path = std::filesystem::canonical(config.input_file);
+            auto abs_path = std::filesystem::canonical(input_file);
             output_stream << "; ModuleID = 'cminus'\n";
             output_stream << "source_filename = " << abs_path << "\n\n";
             output_stream << m->print();
-        } 
+        } else if (config.emitasm) {
+            CodeGen codegen(m.get(), config.regalloc);
+            codegen.run();
+            output_stream << codegen.print();
+        } else if (config.emitbc) {
+            auto abs_path = std::filesystem::canonical(input_file);
+            LLVMGen llvm_gen(m.get(), abs_path.string());
+            if (not llvm_gen.run())
+                return 1;
+            llvm_gen.write_bitcode(output_stream);
+        }
+        std::ofstream(output_file, std::ios::binary) << output_stream.str();
+        if (not cache_key.empty())
+            cache->store(cache_key, output_stream.str());
     }
 
     return 0;
 }
 
+// 批量编译：各个文件在线程池中并行编译，各自有独立的 Module 与输出
+int compile_batch(const Config &config, CompileCache *cache) {
+    using clock = std::chrono::steady_clock;
+    struct Result {
+        int ret;
+        std::uintmax_t size;
+        double seconds;
+    };
+    auto &inputs = config.input_files;
+    std::vector<Result> results(inputs.size());
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i; (i = next++) < inputs.size();) {
+            auto start = clock::now();
+            std::error_code ec;
+            auto size = std::filesystem::file_size(inputs[i], ec);
+            auto ret = compile(config, inputs[i], cache);
+            std::chrono::duration<double> time = clock::now() - start;
+            results[i] = {ret, ec ? 0 : size, time.count()};
+        }
+    };
+
+    auto start = clock::now();
+    unsigned num_threads = std::min<size_t>(config.jobs, inputs.size());
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < num_threads; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    std::chrono::duration<double> total_time = clock::now() - start;
+
+    int ret = 0;
+    std::uintmax_t total_size = 0;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (results[i].ret != 0) {
+            ret = 1;
+            std::cerr << inputs[i].string() << ": compilation failed"
+                      << std::endl;
+        }
+        total_size += results[i].size;
+        if (config.batch_report)
+            std::cerr << inputs[i].string() << ": " << results[i].size
+                      << " bytes, " << results[i].seconds * 1000 << " ms"
+                      << std::endl;
+    }
+    if (config.batch_report) {
+        auto seconds = total_time.count();
+        std::cerr << inputs.size() << " files, " << total_size << " bytes in "
+                  << seconds * 1000 << " ms with " << num_threads
+                  << " threads (" << inputs.size() / seconds << " files/s, "
+                  << total_size / seconds / (1 << 20) << " MiB/s)"
+                  << std::endl;
+    }
+    return ret;
+}
+
+int main(int argc, char **argv) {
+    Config config(argc, argv);
+
+    std::unique_ptr<CompileCache> cache;
+    if (not config.cache_dir.empty())
+        cache = std::make_unique<CompileCache>(config.cache_dir);
+
+    int ret = config.input_files.size() == 1
+                  ? compile(config, config.input_files.front(), cache.get())
+                  : compile_batch(config, cache.get());
+    if (cache and config.cache_stats)
+        std::cerr << cache->stats() << std::endl;
+    return ret;
+}
+
 void Config::parse_cmd_line() {
     exe_name = argv[0];
     for (int i = 1; i < argc; ++i) {
@@ -107,30 +357,132 @@ void Config::parse_cmd_line() {
             emitast = true;
         } else if (argv[i] == "-emit-llvm"s) {
             emitllvm = true;
+        } else if (argv[i] == "-emit-llvm-bc"s) {
+            emitbc = true;
+        } else if (argv[i] == "-S"s) {
+            emitasm = true;
+        } else if (argv[i] == "-run"s) {
+            run = true;
+        } else if (argv[i] == "-interpret"s) {
+            interpret = true;
+        } else if (argv[i] == "-regalloc"s) {
+            regalloc = true;
+        } else if (argv[i] == "-profile-gen"s) {
+            profile_gen = true;
+        } else if (string(argv[i]).rfind("-profile-show=", 0) == 0) {
+            profile_show = string(argv[i]).substr(strlen("-profile-show="));
+        } else if (string(argv[i]).rfind("-profile-use=", 0) == 0) {
+            profile_use = string(argv[i]).substr(strlen("-profile-use="));
+        } else if (string(argv[i]).rfind("-cache-dir=", 0) == 0) {
+            cache_dir = string(argv[i]).substr(strlen("-cache-dir="));
+        } else if (argv[i] == "-cache-stats"s) {
+            cache_stats = true;
+        } else if (argv[i][0] == '-' and argv[i][1] == 'j' and
+                   argv[i][2] != '\0' and
+                   std::all_of(argv[i] + 2, argv[i] + strlen(argv[i]),
+                               ::isdigit)) {
+            // 只接受 -j 后全是数字的参数，-jump-threading 等选项由后面的分支处理
+            jobs = std::atoi(argv[i] + 2);
+            if (jobs == 0) {
+                print_err("bad number of jobs");
+            }
+        } else if (argv[i] == "-batch-report"s) {
+            batch_report = true;
         } else if (argv[i] == "-dce"s) {
             dce = true;
+        } else if (argv[i] == "-adce"s) {
+            adce = true;
         } else if (argv[i] == "-const-prop"s) {
             const_prop = true;
         } else if (argv[i] == "-func-inline"s) {
             func_inline = true;
-        } else {
-            if (input_file.empty()) {
-                input_file = argv[i];
-            } else {
-                string err =
-                    "unrecognized command-line option \'"s + argv[i] + "\'"s;
-                print_err(err);
+        } else if (argv[i] == "-mem2reg"s) {
+            mem2reg = true;
+        } else if (argv[i] == "-pruned-ssa"s) {
+            pruned_ssa = true;
+        } else if (argv[i] == "-instcombine"s) {
+            inst_combine = true;
+        } else if (argv[i] == "-simplifycfg"s) {
+            simplify_cfg = true;
+        } else if (argv[i] == "-jump-threading"s) {
+            jump_threading = true;
+        } else if (argv[i] == "-block-placement"s) {
+            block_placement = true;
+        } else if (argv[i] == "-print-alias"s) {
+            print_alias = true;
+        } else if (argv[i] == "-print-memssa"s) {
+            print_memssa = true;
+        } else if (argv[i][0] == '@') {
+            // 响应文件：每行一个输入文件
+            std::ifstream in(argv[i] + 1);
+            if (not in) {
+                print_err("cannot read response file "s + (argv[i] + 1));
+            }
+            for (string line; std::getline(in, line);) {
+                if (not line.empty())
+                    input_files.emplace_back(line);
             }
+        } else if (argv[i][0] == '-') {
+            string err =
+                "unrecognized command-line option \'"s + argv[i] + "\'"s;
+            print_err(err);
+        } else {
+            input_files.emplace_back(argv[i]);
         }
     }
 }
 
 void Config::check() {
-    if (input_file.empty()) {
+    if (input_files.empty()) {
         print_err("no input file");
     }
-    if (input_file.extension() != ".cminus") {
-        print_err("file format not recognized");
+    for (auto &input_file : input_files) {
+        if (input_file.extension() != ".cminus") {
+            print_err("file format not recognized");
+        }
+    }
+    if (input_files.size() > 1) {
+        if (not output_file.empty()) {
+            print_err("-o cannot be used with multiple input files");
+        }
+        if (emitast || run || interpret || not profile_show.empty() ||
+            print_alias || print_memssa) {
+            print_err("-emit-ast, -run, -interpret, -profile-show, "
+                      "-print-alias and -print-memssa need a single input "
+                      "file");
+        }
+        std::set<std::filesystem::path> outputs;
+        for (auto &input_file : input_files) {
+            if (not outputs.insert(output_path(input_file)).second) {
+                print_err("input files have the same output file " +
+                          output_path(input_file).string());
+            }
+        }
+    }
+    if (emitllvm && emitasm) {
+        print_err("-emit-llvm and -S cannot be used together");
+    }
+    if (emitbc && (emitllvm || emitasm)) {
+        print_err("-emit-llvm-bc cannot be used with -emit-llvm or -S");
+    }
+    if (run && (emitllvm || emitbc || emitasm)) {
+        print_err("-run cannot be used with -emit-llvm, -emit-llvm-bc or -S");
+    }
+    if (interpret && (run || emitllvm || emitbc || emitasm)) {
+        print_err("-interpret cannot be used with -run, -emit-llvm, "
+                  "-emit-llvm-bc or -S");
+    }
+    if (regalloc && not emitasm) {
+        print_err("regalloc need -S");
+    }
+    if (profile_gen && not profile_use.empty()) {
+        print_err("-profile-gen and -profile-use cannot be used together");
+    }
+    if (cache_stats && cache_dir.empty()) {
+        print_err("-cache-stats need -cache-dir");
+    }
+    if (adce && not dce) {
+        print_err("adce need dce pass");
     }
     if (const_prop && not dce) {
         print_err("const-prop pass need dce pass");
@@ -138,19 +490,74 @@ void Config::check() {
     if (func_inline && not dce) {
         print_err("function inline pass need dce pass");
     }
-    if (output_file.empty()) {
-        output_file = input_file.stem();
-        if (emitllvm) {
-            output_file.replace_extension(".ll");
-        }
+    if (mem2reg && not dce) {
+        print_err("mem2reg pass need dce pass");
+    }
+    if (inst_combine && not dce) {
+        print_err("inst-combine pass need dce pass");
+    }
+    if (simplify_cfg && not dce) {
+        print_err("simplify-cfg pass need dce pass");
+    }
+    if (jump_threading && not simplify_cfg) {
+        print_err("jump-threading pass need simplify-cfg pass");
+    }
+    // const-prop works on the SSA form built by mem2reg
+    if (const_prop) {
+        mem2reg = true;
+    }
+    if (pruned_ssa && not mem2reg) {
+        print_err("pruned-ssa need mem2reg pass");
+    }
+}
+
+std::filesystem::path
+Config::output_path(const std::filesystem::path &input) const {
+    if (not output_file.empty())
+        return output_file;
+    std::filesystem::path output = input.stem();
+    if (emitllvm) {
+        output.replace_extension(".ll");
+    } else if (emitasm) {
+        output.replace_extension(".s");
+    } else if (emitbc) {
+        output.replace_extension(".bc");
+    }
+    return output;
+}
+
+string Config::cache_key(const std::filesystem::path &input_file) const {
+    if (not(emitllvm || emitasm || emitbc) || not profile_show.empty() ||
+        print_alias || print_memssa)
+        return "";
+    std::ostringstream key;
+    key << CompileCache::compiler_version() << "\n";
+    key << emitllvm << emitasm << emitbc << regalloc << mem2reg << pruned_ssa
+        << const_prop << dce << adce << func_inline << inst_combine
+        << simplify_cfg << jump_threading << block_placement << profile_gen
+        << "\n";
+    // -emit-llvm 与 -emit-llvm-bc 的输出中带有源文件的绝对路径
+    if (emitllvm || emitbc) {
+        std::error_code ec;
+        key << std::filesystem::canonical(input_file, ec) << "\n";
+    }
+    string content;
+    if (not read_file(input_file, content))
+        return "";
+    key << content.size() << "\n" << content;
+    if (not profile_use.empty()) {
+        if (not read_file(profile_use, content))
+            return "";
+        key << "\n" << content;
     }
+    return key.str();
 }
 
 void Config::print_help() const {
     std::cout << "Usage: " << exe_name
-              << " [-h|--help] [-o <target-file>] [-emit-llvm] [-S] [-dump-json]"
-                 "[-const-prop] [-dce]"
-                 "<input-file>"
+              << " [-h|--help] [-o <target-file>] [-emit-llvm] [-emit-llvm-bc] [-S] [-run] [-interpret] [-regalloc] [-dump-json]"
+                 "[-mem2reg] [-pruned-ssa] [-const-prop] [-instcombine] [-simplifycfg] [-jump-threading] [-block-placement] [-print-alias] [-print-memssa] [-dce] [-adce] [-profile-gen] [-profile-show=<file>] [-profile-use=<file>] [-cache-dir=<dir>] [-cache-stats] [-j<jobs>] [-batch-report]"
+                 "<input-file>... [@<response-file>]"
               << std::endl;
     exit(0);
 }
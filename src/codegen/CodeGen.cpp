@@ -0,0 +1,794 @@
+#include "CodeGen.hpp"
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "GlobalVariable.hpp"
+#include "Instruction.hpp"
+#include "SimplifyCFG.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <unordered_set>
+
+namespace {
+
+const int int_arg_regs[] = {CodeGen::RDI, CodeGen::RSI, CodeGen::RDX,
+                            CodeGen::RCX, CodeGen::R8,  CodeGen::R9};
+const int num_float_arg_regs = 8;
+
+std::string mov_op(Type *ty) {
+    if (ty->is_float_type())
+        return "movss";
+    if (ty->is_pointer_type())
+        return "movq";
+    return "movl";
+}
+
+uint32_t float_bits(float val) {
+    uint32_t bits;
+    std::memcpy(&bits, &val, sizeof(bits));
+    return bits;
+}
+
+// 操作数是否为内存地址（栈槽等），x86 的指令至多有一个内存操作数
+bool is_memory(const std::string &op) {
+    return not op.empty() and op.back() == ')';
+}
+
+int align_to(int size, int align) { return (size + align - 1) / align * align; }
+
+// 所有出边指向同一个块
+bool has_single_succ(BasicBlock *bb) {
+    auto &succ_bbs = bb->get_succ_basic_blocks();
+    return std::all_of(succ_bbs.begin(), succ_bbs.end(),
+                       [&](auto succ_bb) { return succ_bb == succ_bbs.front(); });
+}
+
+} // namespace
+
+CodeGen::CodeGen(Module *m, bool regalloc)
+    : m_(m), regalloc_(regalloc), phi_elim_(m),
+      reg_alloc_({{R10}, {RBX, R12, R13, R14, R15}},
+                 {{XMM8, XMM9, XMM10, XMM11, XMM12, XMM13, XMM14, XMM15},
+                  {}}) {}
+
+std::string CodeGen::reg_name(int reg, Type *ty) {
+    static const char *names64[] = {"rax", "rcx", "rdx", "rbx", "rsp", "rbp",
+                                    "rsi", "rdi", "r8",  "r9",  "r10", "r11",
+                                    "r12", "r13", "r14", "r15"};
+    static const char *names32[] = {"eax",  "ecx",  "edx",  "ebx",
+                                    "esp",  "ebp",  "esi",  "edi",
+                                    "r8d",  "r9d",  "r10d", "r11d",
+                                    "r12d", "r13d", "r14d", "r15d"};
+    if (reg >= XMM0)
+        return "%xmm" + std::to_string(reg - XMM0);
+    if (ty->is_pointer_type())
+        return std::string("%") + names64[reg];
+    return std::string("%") + names32[reg];
+}
+
+std::string CodeGen::reg_name8(int reg) {
+    static const char *names8[] = {"al",   "cl",   "dl",   "bl",
+                                   "spl",  "bpl",  "sil",  "dil",
+                                   "r8b",  "r9b",  "r10b", "r11b",
+                                   "r12b", "r13b", "r14b", "r15b"};
+    return std::string("%") + names8[reg];
+}
+
+void CodeGen::run() {
+    // 寄存器分配需要在边上装入被切分的值，先切分全部关键边
+    if (regalloc_) {
+        for (auto &func : m_->get_functions()) {
+            split_critical_edges(&func);
+        }
+    }
+    phi_elim_.run();
+    output_.clear();
+    for (auto &gv : m_->get_global_variable()) {
+        gen_global_var(&gv);
+    }
+    output_ += "\t.text\n";
+    for (auto &func : m_->get_functions()) {
+        if (not func.is_declaration())
+            gen_function(&func);
+    }
+    output_ += "\t.section\t.note.GNU-stack,\"\",@progbits\n";
+}
+
+void CodeGen::gen_global_var(GlobalVariable *gv) {
+    auto ty = gv->get_type()->get_pointer_element_type();
+    auto name = gv->get_name();
+    output_ += "\t.data\n";
+    emit(".globl\t" + name);
+    emit(".align\t" + std::to_string(ty->get_size() >= 8 ? 8 : 4));
+    emit(".type\t" + name + ", @object");
+    emit(".size\t" + name + ", " + std::to_string(ty->get_size()));
+    emit_label(name);
+    // 前端给数组的零初始化值用的是元素类型，按变量本身的大小清零
+    if (gv->get_init() == nullptr or
+        dynamic_cast<ConstantZero *>(gv->get_init()))
+        emit(".zero\t" + std::to_string(ty->get_size()));
+    else
+        gen_constant(gv->get_init());
+}
+
+void CodeGen::gen_constant(Constant *c) {
+    if (auto ci = dynamic_cast<ConstantInt *>(c)) {
+        emit(".long\t" + std::to_string(ci->get_value()));
+    } else if (auto cf = dynamic_cast<ConstantFP *>(c)) {
+        emit(".long\t" + std::to_string(float_bits(cf->get_value())));
+    } else if (auto ca = dynamic_cast<ConstantArray *>(c)) {
+        auto array_ty = static_cast<ArrayType *>(ca->get_type());
+        for (unsigned i = 0; i < array_ty->get_num_of_elements(); i++) {
+            gen_constant(ca->get_element_value(i));
+        }
+    } else {
+        emit(".zero\t" + std::to_string(c->get_type()->get_size()));
+    }
+}
+
+void CodeGen::split_critical_edges(Function *f) {
+    std::vector<std::pair<BasicBlock *, BasicBlock *>> edges;
+    for (auto &bb : f->get_basic_blocks()) {
+        std::unordered_set<BasicBlock *> pre_bbs(
+            bb.get_pre_basic_blocks().begin(), bb.get_pre_basic_blocks().end());
+        if (pre_bbs.size() < 2)
+            continue;
+        for (auto pre_bb : pre_bbs) {
+            std::unordered_set<BasicBlock *> succ_bbs(
+                pre_bb->get_succ_basic_blocks().begin(),
+                pre_bb->get_succ_basic_blocks().end());
+            if (succ_bbs.size() > 1)
+                edges.emplace_back(pre_bb, &bb);
+        }
+    }
+    for (auto [pre_bb, bb] : edges) {
+        SimplifyCFG::split_edge(pre_bb, bb);
+    }
+}
+
+std::string CodeGen::vreg_loc(int vreg) const {
+    return std::to_string(-8 * (vreg + 1)) + "(%rbp)";
+}
+
+void CodeGen::gen_function(Function *f) {
+    func_ = f;
+    label_.clear();
+    alloca_offset_.clear();
+
+    int index = 0;
+    for (auto &bb : f->get_basic_blocks()) {
+        label_[&bb] = ".L" + f->get_name() + "_" + std::to_string(index++);
+    }
+    if (regalloc_)
+        reg_alloc_.run(f, phi_elim_);
+    // 栈帧：先是各个虚拟寄存器的槽，然后是 alloca 的空间，
+    // 最后是被调用者保存的寄存器
+    frame_size_ = 8 * phi_elim_.get_num_vregs(f);
+    for (auto &bb : f->get_basic_blocks()) {
+        for (auto &inst : bb.get_instructions()) {
+            if (not inst.is_alloca())
+                continue;
+            auto size = static_cast<AllocaInst *>(&inst)
+                            ->get_alloca_type()
+                            ->get_size();
+            frame_size_ += align_to(size, 8);
+            alloca_offset_[&inst] = -frame_size_;
+        }
+    }
+    if (regalloc_)
+        frame_size_ += 8 * reg_alloc_.get_used_callee_saved().size();
+    frame_size_ = align_to(frame_size_, 16);
+    callee_save_offset_ = -frame_size_;
+
+    auto name = f->get_name();
+    emit(".globl\t" + name);
+    emit(".type\t" + name + ", @function");
+    emit_label(name);
+    emit("pushq\t%rbp");
+    emit("movq\t%rsp, %rbp");
+    if (frame_size_ != 0)
+        emit("subq\t$" + std::to_string(frame_size_) + ", %rsp");
+    if (regalloc_)
+        save_callee_saved(true);
+
+    // 形参从寄存器或调用者的栈帧中取出，存入各自的槽；其定值位置为 0
+    cur_pos_ = -1;
+    int int_idx = 0, float_idx = 0, stack_idx = 0;
+    for (auto &arg : f->get_args()) {
+        auto ty = arg.get_type();
+        int reg;
+        if (ty->is_float_type() and float_idx < num_float_arg_regs) {
+            reg = XMM0 + float_idx++;
+        } else if (not ty->is_float_type() and int_idx < 6) {
+            reg = int_arg_regs[int_idx++];
+        } else {
+            reg = ty->is_float_type() ? XMM0 : RAX;
+            emit(mov_op(ty) + "\t" + std::to_string(16 + 8 * stack_idx++) +
+                 "(%rbp), " + reg_name(reg, ty));
+        }
+        store_value(reg, &arg);
+    }
+
+    for (auto &bb : f->get_basic_blocks()) {
+        auto next = std::next(bb.getIterator());
+        next_bb_ = next == f->get_basic_blocks().end() ? nullptr : &*next;
+        emit_label(label_[&bb]);
+        // 前驱有多个后继时装入放在本块开头，关键边已切分，本块只有这个前驱
+        if (bb.get_pre_basic_blocks().size() == 1) {
+            auto pre_bb = bb.get_pre_basic_blocks().front();
+            if (not has_single_succ(pre_bb))
+                gen_reloads(pre_bb, &bb);
+        }
+        for (auto &inst : bb.get_instructions()) {
+            if (regalloc_ and not inst.is_phi() and not inst.is_alloca())
+                cur_pos_ = reg_alloc_.get_pos(&inst);
+            gen_instr(&inst);
+        }
+    }
+    emit(".size\t" + name + ", .-" + name);
+}
+
+void CodeGen::gen_instr(Instruction *inst) {
+    switch (inst->get_instr_type()) {
+    case Instruction::ret:
+        gen_ret(static_cast<ReturnInst *>(inst));
+        break;
+    case Instruction::br:
+        gen_br(static_cast<BranchInst *>(inst));
+        break;
+    case Instruction::add:
+    case Instruction::sub:
+    case Instruction::mul:
+    case Instruction::sdiv:
+    case Instruction::shl:
+    case Instruction::ashr:
+    case Instruction::lshr:
+    case Instruction::fadd:
+    case Instruction::fsub:
+    case Instruction::fmul:
+    case Instruction::fdiv:
+        gen_binary(inst);
+        break;
+    case Instruction::ge:
+    case Instruction::gt:
+    case Instruction::le:
+    case Instruction::lt:
+    case Instruction::eq:
+    case Instruction::ne:
+        gen_cmp(inst);
+        break;
+    case Instruction::fge:
+    case Instruction::fgt:
+    case Instruction::fle:
+    case Instruction::flt:
+    case Instruction::feq:
+    case Instruction::fne:
+        gen_fcmp(inst);
+        break;
+    case Instruction::load:
+        gen_load(static_cast<LoadInst *>(inst));
+        break;
+    case Instruction::store:
+        gen_store(static_cast<StoreInst *>(inst));
+        break;
+    case Instruction::getelementptr:
+        gen_gep(static_cast<GetElementPtrInst *>(inst));
+        break;
+    case Instruction::call:
+        gen_call(static_cast<CallInst *>(inst));
+        break;
+    case Instruction::zext:
+    case Instruction::fptosi:
+    case Instruction::sitofp:
+        gen_cast(inst);
+        break;
+    // alloca 的地址在使用处由 leaq 得到，phi 由前驱中的复制实现
+    case Instruction::alloca:
+    case Instruction::phi:
+        break;
+    }
+}
+
+void CodeGen::load_value(Value *val, int reg) {
+    auto ty = val->get_type();
+    if (auto ci = dynamic_cast<ConstantInt *>(val)) {
+        emit("movl\t$" + std::to_string(ci->get_value()) + ", " +
+             reg_name(reg, ty));
+    } else if (auto cf = dynamic_cast<ConstantFP *>(val)) {
+        // 浮点常量经由 r11 装入，r11 不用于存放其他值
+        emit("movl\t$" + std::to_string(float_bits(cf->get_value())) +
+             ", %r11d");
+        emit("movd\t%r11d, " + reg_name(reg, ty));
+    } else if (dynamic_cast<GlobalVariable *>(val)) {
+        emit("leaq\t" + val->get_name() + "(%rip), " + reg_name(reg, ty));
+    } else if (alloca_offset_.count(val)) {
+        emit("leaq\t" + std::to_string(alloca_offset_.at(val)) + "(%rbp), " +
+             reg_name(reg, ty));
+    } else {
+        load_vreg(phi_elim_.get_vreg(val), reg);
+    }
+}
+
+void CodeGen::store_value(int reg, Value *val) {
+    store_vreg(reg, phi_elim_.get_vreg(val));
+}
+
+void CodeGen::load_vreg(int vreg, int reg) {
+    auto ty = phi_elim_.get_vreg_type(func_, vreg);
+    if (regalloc_) {
+        auto src = reg_alloc_.get_reg_at(vreg, cur_pos_);
+        if (src != -1) {
+            if (src != reg)
+                emit(mov_op(ty) + "\t" + reg_name(src, ty) + ", " +
+                     reg_name(reg, ty));
+            return;
+        }
+    }
+    emit(mov_op(ty) + "\t" + vreg_loc(vreg) + ", " + reg_name(reg, ty));
+}
+
+void CodeGen::store_vreg(int reg, int vreg) {
+    auto ty = phi_elim_.get_vreg_type(func_, vreg);
+    if (regalloc_) {
+        auto dst = reg_alloc_.get_reg_at(vreg, cur_pos_ + 1);
+        if (dst != -1 and dst != reg)
+            emit(mov_op(ty) + "\t" + reg_name(reg, ty) + ", " +
+                 reg_name(dst, ty));
+        // 被切分的值在每次定值时都写回栈槽，栈槽中的值始终有效
+        if (not reg_alloc_.needs_slot(vreg))
+            return;
+    }
+    emit(mov_op(ty) + "\t" + reg_name(reg, ty) + ", " + vreg_loc(vreg));
+}
+
+int CodeGen::value_reg(Value *val) const {
+    if (not regalloc_ or alloca_offset_.count(val))
+        return -1;
+    auto vreg = phi_elim_.get_vreg(val);
+    return vreg == -1 ? -1 : reg_alloc_.get_reg_at(vreg, cur_pos_);
+}
+
+int CodeGen::result_reg(Value *val, int scratch) const {
+    if (regalloc_) {
+        auto reg = reg_alloc_.get_reg_at(phi_elim_.get_vreg(val), cur_pos_ + 1);
+        if (reg != -1)
+            return reg;
+    }
+    return scratch;
+}
+
+std::string CodeGen::vreg_operand(int vreg) const {
+    auto ty = phi_elim_.get_vreg_type(func_, vreg);
+    if (regalloc_) {
+        auto reg = reg_alloc_.get_reg_at(vreg, cur_pos_);
+        if (reg != -1)
+            return reg_name(reg, ty);
+    }
+    return vreg_loc(vreg);
+}
+
+std::string CodeGen::operand(Value *val) const {
+    if (auto ci = dynamic_cast<ConstantInt *>(val))
+        return "$" + std::to_string(ci->get_value());
+    if (dynamic_cast<Constant *>(val) or dynamic_cast<GlobalVariable *>(val) or
+        alloca_offset_.count(val))
+        return "";
+    return vreg_operand(phi_elim_.get_vreg(val));
+}
+
+std::string CodeGen::operand_or_load(Value *val, int scratch) {
+    auto op = operand(val);
+    if (not op.empty())
+        return op;
+    load_value(val, scratch);
+    return reg_name(scratch, val->get_type());
+}
+
+std::string CodeGen::address(Value *ptr) {
+    if (dynamic_cast<GlobalVariable *>(ptr))
+        return ptr->get_name() + "(%rip)";
+    if (alloca_offset_.count(ptr))
+        return std::to_string(alloca_offset_.at(ptr)) + "(%rbp)";
+    auto reg = value_reg(ptr);
+    if (reg == -1) {
+        load_value(ptr, RAX);
+        reg = RAX;
+    }
+    return "(" + reg_name(reg, ptr->get_type()) + ")";
+}
+
+void CodeGen::gen_copies(BasicBlock *bb) {
+    auto &copies = phi_elim_.get_copies(bb);
+    for (unsigned i = 0; i < copies.size(); i++) {
+        auto &copy = copies[i];
+        if (regalloc_)
+            cur_pos_ = reg_alloc_.get_copy_pos(bb, i);
+        auto ty = phi_elim_.get_vreg_type(func_, copy.dst);
+        auto src = copy.src == -1 ? operand(copy.src_val)
+                                  : vreg_operand(copy.src);
+        int dst =
+            regalloc_ ? reg_alloc_.get_reg_at(copy.dst, cur_pos_ + 1) : -1;
+        // 目标只在栈槽中、源在寄存器中或为整数常量时一条 mov 即可
+        if (dst == -1 and not src.empty() and not is_memory(src)) {
+            emit(mov_op(ty) + "\t" + src + ", " + vreg_loc(copy.dst));
+            continue;
+        }
+        // 否则直接读入目标所在的寄存器，没有时经临时寄存器写回栈槽
+        int reg = dst != -1 ? dst : ty->is_float_type() ? XMM0 : RAX;
+        if (copy.src == -1)
+            load_value(copy.src_val, reg);
+        else
+            load_vreg(copy.src, reg);
+        store_vreg(reg, copy.dst);
+    }
+}
+
+void CodeGen::gen_reloads(BasicBlock *pred, BasicBlock *succ) {
+    if (not regalloc_)
+        return;
+    for (auto [vreg, reg] : reg_alloc_.get_reloads(pred, succ)) {
+        auto ty = phi_elim_.get_vreg_type(func_, vreg);
+        emit(mov_op(ty) + "\t" + vreg_loc(vreg) + ", " + reg_name(reg, ty));
+    }
+}
+
+void CodeGen::save_callee_saved(bool save) {
+    auto &regs = reg_alloc_.get_used_callee_saved();
+    for (unsigned i = 0; i < regs.size(); i++) {
+        auto slot = std::to_string(callee_save_offset_ + 8 * int(i)) + "(%rbp)";
+        auto reg = reg_name(regs[i], m_->get_int32_ptr_type());
+        emit(save ? "movq\t" + reg + ", " + slot
+                  : "movq\t" + slot + ", " + reg);
+    }
+}
+
+void CodeGen::gen_ret(ReturnInst *inst) {
+    if (not inst->is_void_ret()) {
+        auto val = inst->get_operand(0);
+        load_value(val, val->get_type()->is_float_type() ? XMM0 : RAX);
+    }
+    if (regalloc_)
+        save_callee_saved(false);
+    emit("leave");
+    emit("ret");
+}
+
+void CodeGen::gen_br(BranchInst *inst) {
+    auto bb = inst->get_parent();
+    if (not inst->is_cond_br()) {
+        auto succ_bb = static_cast<BasicBlock *>(inst->get_operand(0));
+        gen_copies(bb);
+        gen_reloads(bb, succ_bb);
+        if (succ_bb != next_bb_)
+            emit("jmp\t" + label_.at(succ_bb));
+        return;
+    }
+    // 先检查条件，以免其所在的寄存器被复制覆盖；之后的复制与装入都是 mov，
+    // 不改变标志位
+    auto cond = operand(inst->get_condition());
+    if (is_memory(cond)) {
+        emit("cmpl\t$0, " + cond);
+    } else {
+        auto reg = value_reg(inst->get_condition());
+        if (reg == -1) {
+            load_value(inst->get_condition(), RCX);
+            reg = RCX;
+        }
+        auto name = reg_name(reg, inst->get_condition()->get_type());
+        emit("testl\t" + name + ", " + name);
+    }
+    gen_copies(bb);
+    auto true_bb = static_cast<BasicBlock *>(inst->get_operand(1));
+    auto false_bb = static_cast<BasicBlock *>(inst->get_operand(2));
+    // 两个目标相同时装入只能放在这里，否则放在各个后继的开头
+    if (true_bb == false_bb)
+        gen_reloads(bb, true_bb);
+    if (true_bb == next_bb_ and false_bb != next_bb_) {
+        emit("je\t" + label_.at(false_bb));
+        return;
+    }
+    emit("jne\t" + label_.at(true_bb));
+    if (false_bb != next_bb_)
+        emit("jmp\t" + label_.at(false_bb));
+}
+
+void CodeGen::gen_binary(Instruction *inst) {
+    auto lhs = inst->get_operand(0), rhs = inst->get_operand(1);
+    auto ty = inst->get_type();
+    auto type = inst->get_instr_type();
+    // idivl 的被除数与商固定在 eax
+    if (type == Instruction::sdiv) {
+        load_value(lhs, RAX);
+        emit("cltd");
+        auto divisor = operand(rhs);
+        if (divisor.empty() or divisor[0] == '$') {
+            load_value(rhs, RCX);
+            divisor = "%ecx";
+        }
+        emit("idivl\t" + divisor);
+        store_value(RAX, inst);
+        return;
+    }
+
+    std::string op;
+    bool commutative = false;
+    switch (type) {
+    case Instruction::add:
+        op = "addl";
+        commutative = true;
+        break;
+    case Instruction::sub:
+        op = "subl";
+        break;
+    case Instruction::mul:
+        op = "imull";
+        commutative = true;
+        break;
+    case Instruction::shl:
+        op = "sall";
+        break;
+    case Instruction::ashr:
+        op = "sarl";
+        break;
+    case Instruction::lshr:
+        op = "shrl";
+        break;
+    case Instruction::fadd:
+        op = "addss";
+        commutative = true;
+        break;
+    case Instruction::fsub:
+        op = "subss";
+        break;
+    case Instruction::fmul:
+        op = "mulss";
+        commutative = true;
+        break;
+    default:
+        op = "divss";
+        break;
+    }
+
+    // 在结果所在的寄存器中计算：先把 lhs 写入其中，再以 rhs 为源操作数。
+    // 结果与 rhs 分到同一个寄存器时，写入 lhs 会破坏 rhs，
+    // 可交换的运算交换两个操作数，否则改在临时寄存器中计算
+    int scratch = ty->is_float_type() ? XMM0 : RAX;
+    int dst = result_reg(inst, scratch);
+    if (value_reg(rhs) == dst and value_reg(lhs) != dst) {
+        if (commutative)
+            std::swap(lhs, rhs);
+        else
+            dst = scratch;
+    }
+    std::string src;
+    if (type == Instruction::shl or type == Instruction::ashr or
+        type == Instruction::lshr) {
+        // 移位量只能是立即数或 cl
+        src = operand(rhs);
+        if (src.empty() or src[0] != '$') {
+            load_value(rhs, RCX);
+            src = "%cl";
+        }
+    } else {
+        src = operand_or_load(rhs, ty->is_float_type() ? XMM1 : RCX);
+    }
+    load_value(lhs, dst);
+    emit(op + "\t" + src + ", " + reg_name(dst, ty));
+    store_value(dst, inst);
+}
+
+void CodeGen::gen_cmp(Instruction *inst) {
+    auto lhs = inst->get_operand(0), rhs = inst->get_operand(1);
+    // cmpl 的第二个操作数不能是立即数，两个操作数也不能都在内存中
+    auto src = operand_or_load(rhs, RCX);
+    auto dst = operand(lhs);
+    if (dst.empty() or dst[0] == '$' or (is_memory(dst) and is_memory(src))) {
+        load_value(lhs, RAX);
+        dst = "%eax";
+    }
+    emit("cmpl\t" + src + ", " + dst);
+    std::string cc;
+    switch (inst->get_instr_type()) {
+    case Instruction::ge:
+        cc = "ge";
+        break;
+    case Instruction::gt:
+        cc = "g";
+        break;
+    case Instruction::le:
+        cc = "le";
+        break;
+    case Instruction::lt:
+        cc = "l";
+        break;
+    case Instruction::eq:
+        cc = "e";
+        break;
+    default:
+        cc = "ne";
+        break;
+    }
+    emit("set" + cc + "\t%al");
+    gen_setcc_result(inst);
+}
+
+void CodeGen::gen_fcmp(Instruction *inst) {
+    auto lhs = inst->get_operand(0), rhs = inst->get_operand(1);
+    // ucomiss 比较第二个操作数与第一个，第二个操作数必须在寄存器中
+    auto ucomiss = [&](Value *first, Value *second) {
+        auto reg = value_reg(second);
+        if (reg == -1) {
+            load_value(second, XMM1);
+            reg = XMM1;
+        }
+        emit("ucomiss\t" + operand_or_load(first, XMM0) + ", " +
+             reg_name(reg, second->get_type()));
+    };
+    // lightir 的浮点比较都是无序谓词（uge/ult/ueq...），与 -emit-llvm、
+    // -interpret 一致，有 NaN 时结果为真。ucomiss 无序时置
+    // ZF=PF=CF=1，因此只用 b/be/e 判断；ge/gt 交换操作数
+    switch (inst->get_instr_type()) {
+    case Instruction::fge:
+        ucomiss(lhs, rhs);
+        emit("setbe\t%al");
+        break;
+    case Instruction::fgt:
+        ucomiss(lhs, rhs);
+        emit("setb\t%al");
+        break;
+    case Instruction::fle:
+        ucomiss(rhs, lhs);
+        emit("setbe\t%al");
+        break;
+    case Instruction::flt:
+        ucomiss(rhs, lhs);
+        emit("setb\t%al");
+        break;
+    case Instruction::feq:
+        ucomiss(rhs, lhs);
+        emit("sete\t%al");
+        break;
+    default:
+        ucomiss(rhs, lhs);
+        emit("setne\t%al");
+        emit("setp\t%cl");
+        emit("orb\t%cl, %al");
+        break;
+    }
+    gen_setcc_result(inst);
+}
+
+void CodeGen::gen_setcc_result(Instruction *inst) {
+    auto dst = result_reg(inst, RAX);
+    emit("movzbl\t%al, " + reg_name(dst, inst->get_type()));
+    store_value(dst, inst);
+}
+
+void CodeGen::gen_load(LoadInst *inst) {
+    auto ty = inst->get_load_type();
+    auto addr = address(inst->get_lval());
+    int dst = result_reg(inst, ty->is_float_type() ? XMM0 : RCX);
+    emit(mov_op(ty) + "\t" + addr + ", " + reg_name(dst, ty));
+    store_value(dst, inst);
+}
+
+void CodeGen::gen_store(StoreInst *inst) {
+    auto ty = inst->get_rval()->get_type();
+    auto addr = address(inst->get_lval());
+    // 源在内存中时需要先读入寄存器，地址可能已经占用了 rax
+    auto src = operand(inst->get_rval());
+    if (src.empty() or is_memory(src)) {
+        int reg = ty->is_float_type() ? XMM0 : RCX;
+        load_value(inst->get_rval(), reg);
+        src = reg_name(reg, ty);
+    }
+    emit(mov_op(ty) + "\t" + src + ", " + addr);
+}
+
+void CodeGen::gen_gep(GetElementPtrInst *inst) {
+    load_value(inst->get_operand(0), RAX);
+    // 第一个下标以指针所指类型为步长，其后逐层进入数组的元素类型
+    auto ty = inst->get_operand(0)->get_type()->get_pointer_element_type();
+    for (unsigned i = 1; i < inst->get_num_operand(); i++) {
+        auto size = std::to_string(ty->get_size());
+        auto idx = inst->get_operand(i);
+        if (auto ci = dynamic_cast<ConstantInt *>(idx)) {
+            if (ci->get_value() != 0)
+                emit("addq\t$" +
+                     std::to_string(int64_t(ci->get_value()) *
+                                    ty->get_size()) +
+                     ", %rax");
+        } else {
+            auto src = operand(idx);
+            if (src.empty() or src[0] == '$') {
+                load_value(idx, RCX);
+                src = "%ecx";
+            }
+            emit("movslq\t" + src + ", %rcx");
+            emit("imulq\t$" + size + ", %rcx");
+            emit("addq\t%rcx, %rax");
+        }
+        if (ty->is_array_type())
+            ty = static_cast<ArrayType *>(ty)->get_element_type();
+    }
+    store_value(RAX, inst);
+}
+
+void CodeGen::gen_call(CallInst *inst) {
+    auto func = static_cast<Function *>(inst->get_operand(0));
+    std::vector<std::pair<Value *, int>> reg_args;
+    std::vector<Value *> stack_args;
+    int int_idx = 0, float_idx = 0;
+    for (unsigned i = 1; i < inst->get_num_operand(); i++) {
+        auto arg = inst->get_operand(i);
+        if (arg->get_type()->is_float_type() and
+            float_idx < num_float_arg_regs)
+            reg_args.emplace_back(arg, XMM0 + float_idx++);
+        else if (not arg->get_type()->is_float_type() and int_idx < 6)
+            reg_args.emplace_back(arg, int_arg_regs[int_idx++]);
+        else
+            stack_args.push_back(arg);
+    }
+
+    // 栈上的参数逆序压栈，并保持调用时 rsp 按 16 字节对齐
+    int stack_size = 8 * stack_args.size();
+    if (stack_args.size() % 2 == 1) {
+        emit("subq\t$8, %rsp");
+        stack_size += 8;
+    }
+    for (auto it = stack_args.rbegin(); it != stack_args.rend(); ++it) {
+        auto arg = *it;
+        if (arg->get_type()->is_float_type()) {
+            load_value(arg, XMM0);
+            emit("subq\t$8, %rsp");
+            emit("movss\t%xmm0, (%rsp)");
+        } else {
+            load_value(arg, RAX);
+            emit("pushq\t%rax");
+        }
+    }
+    // 参数都来自栈槽或常量，依次读入参数寄存器不会相互覆盖
+    for (auto [arg, reg] : reg_args) {
+        load_value(arg, reg);
+    }
+    auto name = func->get_name();
+    emit("call\t" + (func->is_declaration() ? name + "@PLT" : name));
+    if (stack_size != 0)
+        emit("addq\t$" + std::to_string(stack_size) + ", %rsp");
+
+    if (not inst->is_void())
+        store_value(inst->get_type()->is_float_type() ? XMM0 : RAX, inst);
+}
+
+void CodeGen::gen_cast(Instruction *inst) {
+    auto src = inst->get_operand(0);
+    switch (inst->get_instr_type()) {
+    case Instruction::zext: {
+        // i1 以 32 位的 0/1 存放，零扩展只是复制
+        auto dst = result_reg(inst, RAX);
+        load_value(src, dst);
+        store_value(dst, inst);
+        break;
+    }
+    case Instruction::fptosi: {
+        auto dst = result_reg(inst, RAX);
+        emit("cvttss2si\t" + operand_or_load(src, XMM0) + ", " +
+             reg_name(dst, inst->get_type()));
+        store_value(dst, inst);
+        break;
+    }
+    default: {
+        auto op = operand(src);
+        if (op.empty() or op[0] == '$') {
+            load_value(src, RAX);
+            op = "%eax";
+        }
+        auto dst = result_reg(inst, XMM0);
+        emit("cvtsi2ssl\t" + op + ", " + reg_name(dst, inst->get_type()));
+        store_value(dst, inst);
+        break;
+    }
+    }
+}
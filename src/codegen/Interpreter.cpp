@@ -0,0 +1,776 @@
+#include "Interpreter.hpp"
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "GlobalVariable.hpp"
+#include "Instruction.hpp"
+#include "logging.hpp"
+
+extern "C" {
+#include "io.h"
+}
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <unordered_set>
+
+namespace {
+
+#define INTERP_OPS(X)                                                          \
+    X(mov)                                                                     \
+    X(add)                                                                     \
+    X(sub)                                                                     \
+    X(mul)                                                                     \
+    X(sdiv)                                                                    \
+    X(shl)                                                                     \
+    X(ashr)                                                                    \
+    X(lshr)                                                                    \
+    X(fadd)                                                                    \
+    X(fsub)                                                                    \
+    X(fmul)                                                                    \
+    X(fdiv)                                                                    \
+    X(alloca)                                                                  \
+    X(load32)                                                                  \
+    X(load64)                                                                  \
+    X(store32)                                                                 \
+    X(store64)                                                                 \
+    X(ge)                                                                      \
+    X(gt)                                                                      \
+    X(le)                                                                      \
+    X(lt)                                                                      \
+    X(eq)                                                                      \
+    X(ne)                                                                      \
+    X(fge)                                                                     \
+    X(fgt)                                                                     \
+    X(fle)                                                                     \
+    X(flt)                                                                     \
+    X(feq)                                                                     \
+    X(fne)                                                                     \
+    X(gep)                                                                     \
+    X(addp)                                                                    \
+    X(zext)                                                                    \
+    X(fptosi)                                                                  \
+    X(sitofp)                                                                  \
+    X(call)                                                                    \
+    X(input)                                                                   \
+    X(output)                                                                  \
+    X(output_float)                                                            \
+    X(neg_idx_except)                                                          \
+    X(profile_init)                                                            \
+    X(br)                                                                      \
+    X(cond_br)                                                                 \
+    X(br_ge)                                                                   \
+    X(br_gt)                                                                   \
+    X(br_le)                                                                   \
+    X(br_lt)                                                                   \
+    X(br_eq)                                                                   \
+    X(br_ne)                                                                   \
+    X(br_fge)                                                                  \
+    X(br_fgt)                                                                  \
+    X(br_fle)                                                                  \
+    X(br_flt)                                                                  \
+    X(br_feq)                                                                  \
+    X(br_fne)                                                                  \
+    X(ret)                                                                     \
+    X(ret_void)
+
+enum class Op : uint8_t {
+#define INTERP_OP_ENUM(name) name,
+    INTERP_OPS(INTERP_OP_ENUM)
+#undef INTERP_OP_ENUM
+};
+
+/* 操作数都是帧中的槽编号，各操作码对字段的使用：
+ *   二元运算、比较：dst = a op b
+ *   alloca：dst = 帧内存 + imm
+ *   load：dst = *a；store：*b = a
+ *   gep：dst = a + b * imm；addp：dst = a + imm
+ *   call：dst = funcs_[a](call_args[imm .. imm + b))，dst 为 -1 时丢弃返回值
+ *   br：跳到 imm；cond_br：a 为真跳到 dst，否则跳到 imm
+ *   br_ge 等：比较与条件跳转合并，a op b 为真跳到 dst，否则跳到 imm，
+ *   顺序与 ge 到 fne 相同
+ */
+struct Code {
+    Op op;
+    int dst;
+    int a;
+    int b;
+    int imm;
+};
+
+const size_t slot_stack_size = 1 << 20;
+const size_t mem_stack_size = 8 << 20;
+
+unsigned align_to(unsigned size, unsigned align) {
+    return (size + align - 1) / align * align;
+}
+
+} // namespace
+
+struct Interpreter::FuncCode {
+    std::vector<Code> code;
+    // 帧模板：形参与指令的槽初始为 0，常量与全局变量的槽预先填好
+    std::vector<Slot> frame;
+    std::vector<int> call_args;
+    unsigned num_args{0};
+    unsigned mem_size{0};
+};
+
+Interpreter::Interpreter(Module *m) : m_(m) {
+    unsigned globals_size = 0;
+    std::vector<std::pair<GlobalVariable *, unsigned>> offsets;
+    for (auto &gv : m_->get_global_variable()) {
+        offsets.emplace_back(&gv, globals_size);
+        globals_size += align_to(
+            gv.get_type()->get_pointer_element_type()->get_size(), 8);
+    }
+    globals_.assign(globals_size, 0);
+    for (auto [gv, offset] : offsets) {
+        global_addr_[gv] = globals_.data() + offset;
+        init_global(globals_.data() + offset, gv->get_init());
+    }
+
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        func_id_[&func] = funcs_.size();
+        funcs_.push_back(std::make_unique<FuncCode>());
+    }
+    for (auto [func, id] : func_id_) {
+        lower_function(func, *funcs_[id]);
+    }
+    slot_stack_.resize(slot_stack_size);
+    mem_stack_.resize(mem_stack_size);
+}
+
+Interpreter::~Interpreter() = default;
+
+void Interpreter::init_global(char *addr, Constant *init) {
+    if (auto const_int = dynamic_cast<ConstantInt *>(init)) {
+        int32_t val = const_int->get_value();
+        std::memcpy(addr, &val, sizeof(val));
+    } else if (auto const_fp = dynamic_cast<ConstantFP *>(init)) {
+        float val = const_fp->get_value();
+        std::memcpy(addr, &val, sizeof(val));
+    } else if (auto const_array = dynamic_cast<ConstantArray *>(init)) {
+        auto elem_size = const_array->get_type()->get_array_element_type()
+                             ->get_size();
+        for (unsigned i = 0; i < const_array->get_size_of_array(); i++) {
+            init_global(addr + i * elem_size,
+                        const_array->get_element_value(i));
+        }
+    }
+    // ConstantZero：globals_ 已经清零
+}
+
+void Interpreter::lower_function(Function *f, FuncCode &code) {
+    auto &frame = code.frame;
+    std::unordered_map<Value *, int> slot;
+    auto new_slot = [&](Slot init) {
+        frame.push_back(init);
+        return static_cast<int>(frame.size() - 1);
+    };
+    for (auto &arg : f->get_args()) {
+        slot[&arg] = new_slot({});
+    }
+    code.num_args = frame.size();
+    for (auto &bb : f->get_basic_blocks()) {
+        for (auto &inst : bb.get_instructions()) {
+            if (not inst.is_void())
+                slot[&inst] = new_slot({});
+        }
+    }
+    auto get_slot = [&](Value *val) {
+        auto it = slot.find(val);
+        if (it != slot.end())
+            return it->second;
+        Slot init{};
+        if (auto const_int = dynamic_cast<ConstantInt *>(val))
+            init.i = const_int->get_value();
+        else if (auto const_fp = dynamic_cast<ConstantFP *>(val))
+            init.f = const_fp->get_value();
+        else if (global_addr_.count(val))
+            init.p = global_addr_.at(val);
+        return slot[val] = new_slot(init);
+    };
+
+    auto &codes = code.code;
+    auto emit = [&](Op op, int dst = -1, int a = -1, int b = -1, int imm = 0) {
+        codes.push_back({op, dst, a, b, imm});
+    };
+    // 跳转目标在所有块生成之后回填，true_target 区分回填 dst 还是 imm
+    struct Fixup {
+        unsigned pc;
+        bool true_target;
+        BasicBlock *pred;
+        BasicBlock *succ;
+    };
+    std::vector<Fixup> fixups;
+    std::unordered_map<BasicBlock *, int> block_pc;
+
+    // 条件只被条件跳转使用时把比较合并进跳转，不再单独计算；
+    // 前端生成的 icmp ne/sgt (zext cmp), 0 等也穿透到里面的比较
+    std::unordered_set<Instruction *> fused;
+    auto fusable = [&](Value *val, BasicBlock *bb) -> Instruction * {
+        auto inst = dynamic_cast<Instruction *>(val);
+        if (inst and inst->get_parent() == bb and
+            inst->get_use_list().size() == 1)
+            return inst;
+        return nullptr;
+    };
+    auto find_cmp = [&](BranchInst *br, bool &negate) -> Instruction * {
+        auto bb = br->get_parent();
+        auto cmp = fusable(br->get_operand(0), bb);
+        if (cmp == nullptr or not(cmp->is_cmp() or cmp->is_fcmp()))
+            return nullptr;
+        fused.insert(cmp);
+        negate = false;
+        while (cmp->is_cmp()) {
+            // zext 的结果只有 0 和 1：ne、sgt 与 0 比较等价于原条件，eq、sle 取反
+            auto op_id = cmp->get_instr_type();
+            auto zero = dynamic_cast<ConstantInt *>(cmp->get_operand(1));
+            auto ext = fusable(cmp->get_operand(0), bb);
+            if (zero == nullptr or zero->get_value() != 0 or
+                not(op_id == Instruction::ne or op_id == Instruction::gt or
+                    op_id == Instruction::eq or op_id == Instruction::le) or
+                ext == nullptr or not ext->is_zext())
+                break;
+            auto inner = fusable(ext->get_operand(0), bb);
+            if (inner == nullptr or not(inner->is_cmp() or inner->is_fcmp()))
+                break;
+            negate ^= op_id == Instruction::eq or op_id == Instruction::le;
+            fused.insert(ext);
+            fused.insert(inner);
+            cmp = inner;
+        }
+        return cmp;
+    };
+
+    for (auto &bb : f->get_basic_blocks()) {
+        block_pc[&bb] = codes.size();
+        Instruction *br_cmp = nullptr;
+        bool negate = false;
+        auto term = bb.get_terminator();
+        if (term and term->is_br() and
+            static_cast<BranchInst *>(term)->is_cond_br())
+            br_cmp = find_cmp(static_cast<BranchInst *>(term), negate);
+        for (auto &inst1 : bb.get_instructions()) {
+            auto inst = &inst1;
+            if (fused.count(inst))
+                continue;
+            auto op = [&](unsigned i) { return get_slot(inst->get_operand(i)); };
+            int dst = inst->is_void() ? -1 : slot.at(inst);
+            auto binary = [&](Op opcode) { emit(opcode, dst, op(0), op(1)); };
+
+            switch (inst->get_instr_type()) {
+            case Instruction::ret:
+                if (static_cast<ReturnInst *>(inst)->is_void_ret())
+                    emit(Op::ret_void);
+                else
+                    emit(Op::ret, -1, op(0));
+                break;
+            case Instruction::br:
+                if (static_cast<BranchInst *>(inst)->is_cond_br()) {
+                    fixups.push_back({static_cast<unsigned>(codes.size()),
+                                      not negate, &bb,
+                                      inst->get_operand(1)->as<BasicBlock>()});
+                    fixups.push_back({static_cast<unsigned>(codes.size()),
+                                      negate, &bb,
+                                      inst->get_operand(2)->as<BasicBlock>()});
+                    if (br_cmp == nullptr) {
+                        emit(Op::cond_br, -1, op(0));
+                        break;
+                    }
+                    auto opcode = static_cast<Op>(
+                        static_cast<int>(Op::br_ge) +
+                        (br_cmp->get_instr_type() - Instruction::ge));
+                    emit(opcode, -1, get_slot(br_cmp->get_operand(0)),
+                         get_slot(br_cmp->get_operand(1)));
+                } else {
+                    fixups.push_back({static_cast<unsigned>(codes.size()),
+                                      false, &bb,
+                                      inst->get_operand(0)->as<BasicBlock>()});
+                    emit(Op::br);
+                }
+                break;
+            case Instruction::add:
+                binary(Op::add);
+                break;
+            case Instruction::sub:
+                binary(Op::sub);
+                break;
+            case Instruction::mul:
+                binary(Op::mul);
+                break;
+            case Instruction::sdiv:
+                binary(Op::sdiv);
+                break;
+            case Instruction::shl:
+                binary(Op::shl);
+                break;
+            case Instruction::ashr:
+                binary(Op::ashr);
+                break;
+            case Instruction::lshr:
+                binary(Op::lshr);
+                break;
+            case Instruction::fadd:
+                binary(Op::fadd);
+                break;
+            case Instruction::fsub:
+                binary(Op::fsub);
+                break;
+            case Instruction::fmul:
+                binary(Op::fmul);
+                break;
+            case Instruction::fdiv:
+                binary(Op::fdiv);
+                break;
+            case Instruction::ge:
+                binary(Op::ge);
+                break;
+            case Instruction::gt:
+                binary(Op::gt);
+                break;
+            case Instruction::le:
+                binary(Op::le);
+                break;
+            case Instruction::lt:
+                binary(Op::lt);
+                break;
+            case Instruction::eq:
+                binary(Op::eq);
+                break;
+            case Instruction::ne:
+                binary(Op::ne);
+                break;
+            case Instruction::fge:
+                binary(Op::fge);
+                break;
+            case Instruction::fgt:
+                binary(Op::fgt);
+                break;
+            case Instruction::fle:
+                binary(Op::fle);
+                break;
+            case Instruction::flt:
+                binary(Op::flt);
+                break;
+            case Instruction::feq:
+                binary(Op::feq);
+                break;
+            case Instruction::fne:
+                binary(Op::fne);
+                break;
+            case Instruction::alloca: {
+                // 指针可能存放在 alloca 中，统一按 8 字节对齐
+                auto size =
+                    static_cast<AllocaInst *>(inst)->get_alloca_type()->get_size();
+                code.mem_size = align_to(code.mem_size, 8);
+                emit(Op::alloca, dst, -1, -1, code.mem_size);
+                code.mem_size += size;
+                break;
+            }
+            case Instruction::load:
+                emit(inst->get_type()->is_pointer_type() ? Op::load64
+                                                         : Op::load32,
+                     dst, op(0));
+                break;
+            case Instruction::store:
+                emit(inst->get_operand(0)->get_type()->is_pointer_type()
+                         ? Op::store64
+                         : Op::store32,
+                     -1, op(0), op(1));
+                break;
+            case Instruction::phi:
+                // 由前驱末尾的复制完成
+                break;
+            case Instruction::call: {
+                auto callee = inst->get_operand(0)->as<Function>();
+                if (callee->is_declaration()) {
+                    auto name = callee->get_name();
+                    if (name == "input")
+                        emit(Op::input, dst);
+                    else if (name == "output")
+                        emit(Op::output, -1, op(1));
+                    else if (name == "outputFloat")
+                        emit(Op::output_float, -1, op(1));
+                    else if (name == "neg_idx_except")
+                        emit(Op::neg_idx_except);
+                    else if (name == "__profile_init")
+                        emit(Op::profile_init, -1, op(1), op(2));
+                    else
+                        LOG_ERROR << "unknown external function " << name;
+                    break;
+                }
+                int args_begin = code.call_args.size();
+                for (unsigned i = 1; i < inst->get_num_operand(); i++) {
+                    code.call_args.push_back(op(i));
+                }
+                emit(Op::call, dst, func_id_.at(callee),
+                     inst->get_num_operand() - 1, args_begin);
+                break;
+            }
+            case Instruction::getelementptr: {
+                // 每个非常量下标一条 gep，步长为当前所指类型的大小；
+                // 常量下标的偏移累加后用一条 addp 完成
+                auto ty =
+                    inst->get_operand(0)->get_type()->get_pointer_element_type();
+                int base = op(0);
+                int offset = 0;
+                for (unsigned i = 1; i < inst->get_num_operand(); i++) {
+                    auto idx = dynamic_cast<ConstantInt *>(inst->get_operand(i));
+                    if (idx) {
+                        offset += idx->get_value() * ty->get_size();
+                    } else {
+                        emit(Op::gep, dst, base, op(i), ty->get_size());
+                        base = dst;
+                    }
+                    if (ty->is_array_type())
+                        ty = ty->get_array_element_type();
+                }
+                if (base != dst or offset != 0)
+                    emit(Op::addp, dst, base, -1, offset);
+                break;
+            }
+            case Instruction::zext:
+                emit(Op::zext, dst, op(0));
+                break;
+            case Instruction::fptosi:
+                emit(Op::fptosi, dst, op(0));
+                break;
+            case Instruction::sitofp:
+                emit(Op::sitofp, dst, op(0));
+                break;
+            }
+        }
+    }
+
+    // 目标块有 phi 时跳到这条边专用的复制序列，末尾再跳到目标块；
+    // 目标块只有一条无条件跳转时直接跳到它的目标
+    std::map<std::pair<BasicBlock *, BasicBlock *>, int> edge_pc;
+    std::function<int(BasicBlock *, BasicBlock *, unsigned)> edge_target =
+        [&](BasicBlock *pred, BasicBlock *succ, unsigned depth) {
+        auto it = edge_pc.find({pred, succ});
+        if (it != edge_pc.end())
+            return it->second;
+        auto &succ_insts = succ->get_instructions();
+        if (depth < 8 and succ_insts.size() == 1 and
+            succ_insts.front().is_br() and
+            not static_cast<BranchInst *>(&succ_insts.front())->is_cond_br()) {
+            auto next = succ_insts.front().get_operand(0)->as<BasicBlock>();
+            if (next != succ) {
+                auto target = edge_target(succ, next, depth + 1);
+                edge_pc[{pred, succ}] = target;
+                return target;
+            }
+        }
+        std::vector<std::pair<int, int>> moves;
+        for (auto &inst : succ->get_instructions()) {
+            if (not inst.is_phi())
+                break;
+            for (auto [incoming, phi_bb] :
+                 static_cast<PhiInst *>(&inst)->get_phi_pairs()) {
+                if (phi_bb != pred)
+                    continue;
+                auto dst = slot.at(&inst);
+                auto src = get_slot(incoming);
+                if (src != dst)
+                    moves.emplace_back(dst, src);
+                break;
+            }
+        }
+        int target = block_pc.at(succ);
+        if (not moves.empty()) {
+            target = codes.size();
+            // 有复制的目标同时是其他复制的源时，先把所有源存入临时槽
+            std::unordered_set<int> dsts;
+            for (auto [dst, src] : moves) {
+                dsts.insert(dst);
+            }
+            bool overlap = false;
+            for (auto [dst, src] : moves) {
+                overlap |= dsts.count(src) > 0;
+            }
+            if (overlap) {
+                for (auto &[dst, src] : moves) {
+                    auto tmp = new_slot({});
+                    emit(Op::mov, tmp, src);
+                    src = tmp;
+                }
+            }
+            for (auto [dst, src] : moves) {
+                emit(Op::mov, dst, src);
+            }
+            emit(Op::br, -1, -1, -1, block_pc.at(succ));
+        }
+        edge_pc[{pred, succ}] = target;
+        return target;
+    };
+    for (auto &fixup : fixups) {
+        auto target = edge_target(fixup.pred, fixup.succ, 0);
+        if (fixup.true_target)
+            codes[fixup.pc].dst = target;
+        else
+            codes[fixup.pc].imm = target;
+    }
+}
+
+int Interpreter::run() {
+    for (auto [func, id] : func_id_) {
+        if (func->get_name() != "main")
+            continue;
+        auto ret = execute(*funcs_[id]);
+        // 计数器在 globals_ 中，解释器析构前写出剖析数据
+        __profile_dump();
+        std::fflush(stdout);
+        return func->get_return_type()->is_void_type() ? 0 : ret.i;
+    }
+    LOG_ERROR << "no main function to run";
+    return -1;
+}
+
+Interpreter::Slot *Interpreter::push_frame(const FuncCode &code, char *&mem) {
+    if (slot_top_ + code.frame.size() > slot_stack_.size() or
+        mem_top_ + code.mem_size > mem_stack_.size()) {
+        // 被解释程序的运行时错误，不经过默认不输出的 LOG_ERROR
+        std::fflush(stdout);
+        std::cerr << "interpreter stack overflow" << std::endl;
+        std::exit(-1);
+    }
+    Slot *regs = slot_stack_.data() + slot_top_;
+    mem = mem_stack_.data() + mem_top_;
+    std::copy(code.frame.begin(), code.frame.end(), regs);
+    slot_top_ += code.frame.size();
+    mem_top_ += align_to(code.mem_size, 8);
+    return regs;
+}
+
+void Interpreter::pop_frame(const FuncCode &code) {
+    slot_top_ -= code.frame.size();
+    mem_top_ -= align_to(code.mem_size, 8);
+}
+
+Interpreter::Slot Interpreter::execute(const FuncCode &entry) {
+    // 调用不递归进入 execute：call 把返回点压入 call_stack，
+    // 在同一个分派循环中继续执行被调函数，ret 时弹出并回到调用者
+    struct Return {
+        const FuncCode *code;
+        const Code *pc;
+        Slot *regs;
+        char *mem;
+    };
+    std::vector<Return> call_stack;
+
+    const FuncCode *func = &entry;
+    char *mem;
+    Slot *regs = push_frame(entry, mem);
+    Slot result{};
+    const Code *codes = entry.code.data();
+    const Code *pc = codes;
+
+#if defined(__GNUC__)
+#define INTERP_OP_LABEL(name) &&L_##name,
+    static const void *labels[] = {INTERP_OPS(INTERP_OP_LABEL)};
+#undef INTERP_OP_LABEL
+#define DISPATCH() goto *labels[static_cast<int>(pc->op)]
+#define CASE(name)                                                             \
+    case Op::name:                                                             \
+    L_##name
+#else
+#define DISPATCH() goto dispatch
+#define CASE(name) case Op::name
+#endif
+#define NEXT()                                                                 \
+    do {                                                                       \
+        ++pc;                                                                  \
+        DISPATCH();                                                            \
+    } while (0)
+#define BINARY(name, field, expr)                                              \
+    CASE(name) : {                                                             \
+        auto a = regs[pc->a].field, b = regs[pc->b].field;                     \
+        regs[pc->dst].field = (expr);                                          \
+        NEXT();                                                                \
+    }
+#define COMPARE(name, field, expr)                                             \
+    CASE(name) : {                                                             \
+        auto a = regs[pc->a].field, b = regs[pc->b].field;                     \
+        regs[pc->dst].i = (expr);                                              \
+        NEXT();                                                                \
+    }
+#define BRANCH(name, field, expr)                                              \
+    CASE(name) : {                                                             \
+        auto a = regs[pc->a].field, b = regs[pc->b].field;                     \
+        pc = codes + ((expr) ? pc->dst : pc->imm);                             \
+        DISPATCH();                                                            \
+    }
+
+#if not defined(__GNUC__)
+dispatch:
+#endif
+    switch (pc->op) {
+    CASE(mov) : {
+        regs[pc->dst] = regs[pc->a];
+        NEXT();
+    }
+        BINARY(add, i, static_cast<int32_t>(uint32_t(a) + uint32_t(b)))
+        BINARY(sub, i, static_cast<int32_t>(uint32_t(a) - uint32_t(b)))
+        BINARY(mul, i, static_cast<int32_t>(uint32_t(a) * uint32_t(b)))
+        BINARY(sdiv, i, a / b)
+        BINARY(shl, i, static_cast<int32_t>(uint32_t(a) << (b & 31)))
+        BINARY(ashr, i, a >> (b & 31))
+        BINARY(lshr, i, static_cast<int32_t>(uint32_t(a) >> (b & 31)))
+        BINARY(fadd, f, a + b)
+        BINARY(fsub, f, a - b)
+        BINARY(fmul, f, a * b)
+        BINARY(fdiv, f, a / b)
+    CASE(alloca) : {
+        regs[pc->dst].p = mem + pc->imm;
+        NEXT();
+    }
+    CASE(load32) : {
+        std::memcpy(&regs[pc->dst].i, regs[pc->a].p, 4);
+        NEXT();
+    }
+    CASE(load64) : {
+        std::memcpy(&regs[pc->dst].p, regs[pc->a].p, 8);
+        NEXT();
+    }
+    CASE(store32) : {
+        std::memcpy(regs[pc->b].p, &regs[pc->a].i, 4);
+        NEXT();
+    }
+    CASE(store64) : {
+        std::memcpy(regs[pc->b].p, &regs[pc->a].p, 8);
+        NEXT();
+    }
+        COMPARE(ge, i, a >= b)
+        COMPARE(gt, i, a > b)
+        COMPARE(le, i, a <= b)
+        COMPARE(lt, i, a < b)
+        COMPARE(eq, i, a == b)
+        COMPARE(ne, i, a != b)
+        // 与 lightir 的打印一致，浮点比较是无序的：有 NaN 时为真
+        COMPARE(fge, f, not(a < b))
+        COMPARE(fgt, f, not(a <= b))
+        COMPARE(fle, f, not(a > b))
+        COMPARE(flt, f, not(a >= b))
+        COMPARE(feq, f, a == b or std::isnan(a) or std::isnan(b))
+        COMPARE(fne, f, not(a == b))
+    CASE(gep) : {
+        regs[pc->dst].p =
+            regs[pc->a].p + static_cast<ptrdiff_t>(regs[pc->b].i) * pc->imm;
+        NEXT();
+    }
+    CASE(addp) : {
+        regs[pc->dst].p = regs[pc->a].p + pc->imm;
+        NEXT();
+    }
+    CASE(zext) : {
+        regs[pc->dst].i = regs[pc->a].i & 1;
+        NEXT();
+    }
+    CASE(fptosi) : {
+        regs[pc->dst].i = static_cast<int32_t>(regs[pc->a].f);
+        NEXT();
+    }
+    CASE(sitofp) : {
+        regs[pc->dst].f = static_cast<float>(regs[pc->a].i);
+        NEXT();
+    }
+    CASE(call) : {
+        auto &callee = *funcs_[pc->a];
+        auto arg_slots = func->call_args.data() + pc->imm;
+        call_stack.push_back({func, pc, regs, mem});
+        auto caller_regs = regs;
+        regs = push_frame(callee, mem);
+        for (unsigned i = 0; i < callee.num_args; i++) {
+            regs[i] = caller_regs[arg_slots[i]];
+        }
+        func = &callee;
+        codes = callee.code.data();
+        pc = codes;
+        DISPATCH();
+    }
+    CASE(input) : {
+        int val = 0;
+        if (std::scanf("%d", &val) != 1)
+            val = 0;
+        regs[pc->dst].i = val;
+        NEXT();
+    }
+    CASE(output) : {
+        std::printf("%d\n", regs[pc->a].i);
+        NEXT();
+    }
+    CASE(output_float) : {
+        std::printf("%f\n", regs[pc->a].f);
+        NEXT();
+    }
+    CASE(neg_idx_except) : {
+        std::printf("negative index exception\n");
+        std::exit(0);
+    }
+    CASE(profile_init) : {
+        __profile_init(reinterpret_cast<int *>(regs[pc->a].p),
+                       reinterpret_cast<int *>(regs[pc->b].p));
+        NEXT();
+    }
+    CASE(br) : {
+        pc = codes + pc->imm;
+        DISPATCH();
+    }
+    CASE(cond_br) : {
+        pc = codes + (regs[pc->a].i ? pc->dst : pc->imm);
+        DISPATCH();
+    }
+        BRANCH(br_ge, i, a >= b)
+        BRANCH(br_gt, i, a > b)
+        BRANCH(br_le, i, a <= b)
+        BRANCH(br_lt, i, a < b)
+        BRANCH(br_eq, i, a == b)
+        BRANCH(br_ne, i, a != b)
+        BRANCH(br_fge, f, not(a < b))
+        BRANCH(br_fgt, f, not(a <= b))
+        BRANCH(br_fle, f, not(a > b))
+        BRANCH(br_flt, f, not(a >= b))
+        BRANCH(br_feq, f, a == b or std::isnan(a) or std::isnan(b))
+        BRANCH(br_fne, f, not(a == b))
+    CASE(ret) : {
+        result = regs[pc->a];
+        goto ret;
+    }
+    CASE(ret_void) : {
+        result = {};
+        goto ret;
+    }
+    }
+
+ret:
+    pop_frame(*func);
+    if (not call_stack.empty()) {
+        auto caller = call_stack.back();
+        call_stack.pop_back();
+        func = caller.code;
+        codes = func->code.data();
+        regs = caller.regs;
+        mem = caller.mem;
+        pc = caller.pc;
+        if (pc->dst != -1)
+            regs[pc->dst] = result;
+        NEXT();
+    }
+    return result;
+
+#undef BRANCH
+#undef COMPARE
+#undef BINARY
+#undef NEXT
+#undef CASE
+#undef DISPATCH
+}
@@ -0,0 +1,84 @@
+#include "JIT.hpp"
+#include "Function.hpp"
+#include "LLVMGen.hpp"
+
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/Support/TargetSelect.h>
+
+#include <cstdio>
+#include <iostream>
+
+extern "C" {
+#include "io.h"
+}
+
+namespace {
+
+// 把出错信息写到标准错误（默认的日志级别不输出 LOG_ERROR），返回是否出错
+bool failed(llvm::Error err) {
+    if (not err)
+        return false;
+    std::cerr << "jit: " << llvm::toString(std::move(err)) << std::endl;
+    return true;
+}
+
+} // namespace
+
+int JIT::run() {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+
+    Function *main_func = nullptr;
+    for (auto &func : m_->get_functions()) {
+        if (func.get_name() == "main")
+            main_func = &func;
+    }
+    if (main_func == nullptr or main_func->is_declaration()) {
+        std::cerr << "jit: no main function to run" << std::endl;
+        return -1;
+    }
+    bool void_main = main_func->get_return_type()->is_void_type();
+
+    LLVMGen llvm_gen(m_, "cminus");
+    if (not llvm_gen.run())
+        return -1;
+    auto [llvm_module, ctx] = llvm_gen.release();
+
+    auto jit = llvm::orc::LLJITBuilder().create();
+    if (failed(jit.takeError()))
+        return -1;
+
+    auto &es = (*jit)->getExecutionSession();
+    llvm::orc::MangleAndInterner mangle(es, (*jit)->getDataLayout());
+    llvm::orc::SymbolMap runtime;
+    auto bind = [&](const char *name, auto *func) {
+        runtime[mangle(name)] = llvm::JITEvaluatedSymbol::fromPointer(
+            func, llvm::JITSymbolFlags::Exported);
+    };
+    bind("input", &input);
+    bind("output", &output);
+    bind("outputFloat", &outputFloat);
+    bind("neg_idx_except", &neg_idx_except);
+    bind("__profile_init", &__profile_init);
+    if (failed((*jit)->getMainJITDylib().define(
+            llvm::orc::absoluteSymbols(std::move(runtime)))))
+        return -1;
+
+    if (failed((*jit)->addIRModule(llvm::orc::ThreadSafeModule(
+            std::move(llvm_module), std::move(ctx)))))
+        return -1;
+    auto main_sym = (*jit)->lookup("main");
+    if (failed(main_sym.takeError()))
+        return -1;
+
+    int ret = 0;
+    auto addr = main_sym->getAddress();
+    if (void_main)
+        llvm::jitTargetAddressToFunction<void (*)()>(addr)();
+    else
+        ret = llvm::jitTargetAddressToFunction<int (*)()>(addr)();
+    // JIT 生成的代码与数据在返回后释放，剖析数据要在此之前写出
+    __profile_dump();
+    std::fflush(stdout);
+    return ret;
+}
@@ -0,0 +1,328 @@
+#include "LLVMGen.hpp"
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "GlobalVariable.hpp"
+#include "Instruction.hpp"
+
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/CFG.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/raw_os_ostream.h>
+
+#include <cassert>
+
+LLVMGen::LLVMGen(Module *m, const std::string &source_filename)
+    : m_(m), ctx_(std::make_unique<llvm::LLVMContext>()),
+      llvm_module_(std::make_unique<llvm::Module>("cminus", *ctx_)),
+      builder_(std::make_unique<llvm::IRBuilder<>>(*ctx_)) {
+    llvm_module_->setSourceFileName(source_filename);
+}
+
+bool LLVMGen::run() {
+    for (auto &gv : m_->get_global_variable()) {
+        gen_global_var(&gv);
+    }
+    // 先声明全部函数，调用可以出现在被调函数定义之前
+    for (auto &func : m_->get_functions()) {
+        auto llvm_func = llvm::Function::Create(
+            static_cast<llvm::FunctionType *>(
+                get_type(func.get_function_type())),
+            llvm::Function::ExternalLinkage, func.get_name(),
+            llvm_module_.get());
+        values_[&func] = llvm_func;
+        auto llvm_arg = llvm_func->arg_begin();
+        for (auto &arg : func.get_args()) {
+            llvm_arg->setName(arg.get_name());
+            values_[&arg] = &*llvm_arg++;
+        }
+    }
+    for (auto &func : m_->get_functions()) {
+        if (not func.is_declaration())
+            gen_function(&func);
+    }
+
+    // 校验的详细信息与结论都写到标准错误，不经过默认不输出的 LOG_ERROR
+    if (llvm::verifyModule(*llvm_module_, &llvm::errs())) {
+        llvm::errs() << "generated llvm module is broken\n";
+        return false;
+    }
+    return true;
+}
+
+void LLVMGen::write_bitcode(std::ostream &os) {
+    llvm::raw_os_ostream llvm_os(os);
+    llvm::WriteBitcodeToFile(*llvm_module_, llvm_os);
+}
+
+std::pair<std::unique_ptr<llvm::Module>, std::unique_ptr<llvm::LLVMContext>>
+LLVMGen::release() {
+    builder_.reset();
+    values_.clear();
+    return {std::move(llvm_module_), std::move(ctx_)};
+}
+
+void LLVMGen::gen_global_var(GlobalVariable *gv) {
+    auto ty = get_type(gv->get_type()->get_pointer_element_type());
+    // 前端给数组的零初始化值用的是元素类型，按变量本身的类型生成
+    auto init = dynamic_cast<ConstantZero *>(gv->get_init())
+                    ? llvm::Constant::getNullValue(ty)
+                    : get_constant(gv->get_init());
+    auto llvm_gv = new llvm::GlobalVariable(
+        *llvm_module_, ty, gv->is_const(), llvm::GlobalValue::ExternalLinkage,
+        init, gv->get_name());
+    values_[gv] = llvm_gv;
+}
+
+void LLVMGen::gen_function(Function *f) {
+    auto llvm_func = static_cast<llvm::Function *>(values_.at(f));
+    for (auto &bb : f->get_basic_blocks()) {
+        values_[&bb] =
+            llvm::BasicBlock::Create(*ctx_, bb.get_name(), llvm_func);
+    }
+    phis_.clear();
+    for (auto &bb : f->get_basic_blocks()) {
+        builder_->SetInsertPoint(
+            static_cast<llvm::BasicBlock *>(values_.at(&bb)));
+        for (auto &inst : bb.get_instructions()) {
+            gen_instr(&inst);
+        }
+    }
+    // 终结指令都已生成，LLVM 中的前驱关系此时才完整
+    for (auto phi : phis_) {
+        gen_phi_incoming(phi);
+    }
+}
+
+void LLVMGen::gen_instr(Instruction *inst) {
+    auto &builder = *builder_;
+    auto op = [&](unsigned i) { return get_value(inst->get_operand(i)); };
+    auto bb = [&](unsigned i) {
+        return static_cast<llvm::BasicBlock *>(op(i));
+    };
+
+    llvm::Value *result = nullptr;
+    switch (inst->get_instr_type()) {
+    case Instruction::ret:
+        if (static_cast<ReturnInst *>(inst)->is_void_ret())
+            builder.CreateRetVoid();
+        else
+            builder.CreateRet(op(0));
+        break;
+    case Instruction::br:
+        if (static_cast<BranchInst *>(inst)->is_cond_br())
+            builder.CreateCondBr(op(0), bb(1), bb(2));
+        else
+            builder.CreateBr(bb(0));
+        break;
+    case Instruction::add:
+        result = builder.CreateAdd(op(0), op(1));
+        break;
+    case Instruction::sub:
+        result = builder.CreateSub(op(0), op(1));
+        break;
+    case Instruction::mul:
+        result = builder.CreateMul(op(0), op(1));
+        break;
+    case Instruction::sdiv:
+        result = builder.CreateSDiv(op(0), op(1));
+        break;
+    case Instruction::shl:
+        result = builder.CreateShl(op(0), op(1));
+        break;
+    case Instruction::ashr:
+        result = builder.CreateAShr(op(0), op(1));
+        break;
+    case Instruction::lshr:
+        result = builder.CreateLShr(op(0), op(1));
+        break;
+    case Instruction::fadd:
+        result = builder.CreateFAdd(op(0), op(1));
+        break;
+    case Instruction::fsub:
+        result = builder.CreateFSub(op(0), op(1));
+        break;
+    case Instruction::fmul:
+        result = builder.CreateFMul(op(0), op(1));
+        break;
+    case Instruction::fdiv:
+        result = builder.CreateFDiv(op(0), op(1));
+        break;
+    case Instruction::alloca:
+        result = builder.CreateAlloca(
+            get_type(static_cast<AllocaInst *>(inst)->get_alloca_type()));
+        break;
+    case Instruction::load:
+        result = builder.CreateLoad(get_type(inst->get_type()), op(0));
+        break;
+    case Instruction::store:
+        builder.CreateStore(op(0), op(1));
+        break;
+    // 与文本 IR 的打印保持一致：整数比较有符号，浮点比较无序
+    case Instruction::ge:
+        result = builder.CreateICmpSGE(op(0), op(1));
+        break;
+    case Instruction::gt:
+        result = builder.CreateICmpSGT(op(0), op(1));
+        break;
+    case Instruction::le:
+        result = builder.CreateICmpSLE(op(0), op(1));
+        break;
+    case Instruction::lt:
+        result = builder.CreateICmpSLT(op(0), op(1));
+        break;
+    case Instruction::eq:
+        result = builder.CreateICmpEQ(op(0), op(1));
+        break;
+    case Instruction::ne:
+        result = builder.CreateICmpNE(op(0), op(1));
+        break;
+    case Instruction::fge:
+        result = builder.CreateFCmpUGE(op(0), op(1));
+        break;
+    case Instruction::fgt:
+        result = builder.CreateFCmpUGT(op(0), op(1));
+        break;
+    case Instruction::fle:
+        result = builder.CreateFCmpULE(op(0), op(1));
+        break;
+    case Instruction::flt:
+        result = builder.CreateFCmpULT(op(0), op(1));
+        break;
+    case Instruction::feq:
+        result = builder.CreateFCmpUEQ(op(0), op(1));
+        break;
+    case Instruction::fne:
+        result = builder.CreateFCmpUNE(op(0), op(1));
+        break;
+    case Instruction::phi:
+        result = builder.CreatePHI(get_type(inst->get_type()),
+                                   inst->get_num_operand() / 2);
+        phis_.push_back(static_cast<PhiInst *>(inst));
+        break;
+    case Instruction::call: {
+        auto callee = static_cast<llvm::Function *>(op(0));
+        std::vector<llvm::Value *> args;
+        for (unsigned i = 1; i < inst->get_num_operand(); i++) {
+            args.push_back(op(i));
+        }
+        result = builder.CreateCall(callee, args);
+        break;
+    }
+    case Instruction::getelementptr: {
+        auto ptr = inst->get_operand(0);
+        std::vector<llvm::Value *> idxs;
+        for (unsigned i = 1; i < inst->get_num_operand(); i++) {
+            idxs.push_back(op(i));
+        }
+        result = builder.CreateGEP(
+            get_type(ptr->get_type()->get_pointer_element_type()),
+            get_value(ptr), idxs);
+        break;
+    }
+    case Instruction::zext:
+        result = builder.CreateZExt(op(0), get_type(inst->get_type()));
+        break;
+    case Instruction::fptosi:
+        result = builder.CreateFPToSI(op(0), get_type(inst->get_type()));
+        break;
+    case Instruction::sitofp:
+        result = builder.CreateSIToFP(op(0), get_type(inst->get_type()));
+        break;
+    }
+
+    if (result == nullptr or inst->is_void())
+        return;
+    result->setName(inst->get_name());
+    define(inst, result);
+}
+
+void LLVMGen::gen_phi_incoming(PhiInst *phi) {
+    auto llvm_phi = static_cast<llvm::PHINode *>(values_.at(phi));
+    auto pairs = phi->get_phi_pairs();
+    // LLVM 要求每条入边各有一项，条件跳转的两个目标相同时需要两项
+    for (auto pred : llvm::predecessors(llvm_phi->getParent())) {
+        llvm::Value *incoming = llvm::UndefValue::get(llvm_phi->getType());
+        for (auto [val, pre_bb] : pairs) {
+            if (values_.at(pre_bb) == pred) {
+                incoming = get_value(val);
+                break;
+            }
+        }
+        llvm_phi->addIncoming(incoming, pred);
+    }
+}
+
+llvm::Type *LLVMGen::get_type(Type *ty) {
+    switch (ty->get_type_id()) {
+    case Type::VoidTyID:
+        return llvm::Type::getVoidTy(*ctx_);
+    case Type::LabelTyID:
+        return llvm::Type::getLabelTy(*ctx_);
+    case Type::IntegerTyID:
+        return llvm::Type::getIntNTy(
+            *ctx_, static_cast<IntegerType *>(ty)->get_num_bits());
+    case Type::FloatTyID:
+        return llvm::Type::getFloatTy(*ctx_);
+    case Type::PointerTyID:
+        return llvm::PointerType::getUnqual(
+            get_type(ty->get_pointer_element_type()));
+    case Type::ArrayTyID: {
+        auto array_ty = static_cast<ArrayType *>(ty);
+        return llvm::ArrayType::get(get_type(array_ty->get_element_type()),
+                                    array_ty->get_num_of_elements());
+    }
+    case Type::FunctionTyID: {
+        auto func_ty = static_cast<FunctionType *>(ty);
+        std::vector<llvm::Type *> params;
+        for (unsigned i = 0; i < func_ty->get_num_of_args(); i++) {
+            params.push_back(get_type(func_ty->get_param_type(i)));
+        }
+        return llvm::FunctionType::get(get_type(func_ty->get_return_type()),
+                                       params, false);
+    }
+    }
+    assert(false && "unknown type");
+    return nullptr;
+}
+
+llvm::Constant *LLVMGen::get_constant(Constant *c) {
+    auto ty = get_type(c->get_type());
+    if (auto const_int = dynamic_cast<ConstantInt *>(c))
+        return llvm::ConstantInt::get(ty, const_int->get_value(), true);
+    if (auto const_fp = dynamic_cast<ConstantFP *>(c))
+        return llvm::ConstantFP::get(ty, const_fp->get_value());
+    if (auto const_array = dynamic_cast<ConstantArray *>(c)) {
+        std::vector<llvm::Constant *> elements;
+        for (unsigned i = 0; i < const_array->get_size_of_array(); i++) {
+            elements.push_back(
+                get_constant(const_array->get_element_value(i)));
+        }
+        return llvm::ConstantArray::get(static_cast<llvm::ArrayType *>(ty),
+                                        elements);
+    }
+    assert(dynamic_cast<ConstantZero *>(c));
+    return llvm::Constant::getNullValue(ty);
+}
+
+llvm::Value *LLVMGen::get_value(Value *val) {
+    if (auto c = dynamic_cast<Constant *>(val))
+        return get_constant(c);
+    auto it = values_.find(val);
+    if (it != values_.end())
+        return it->second;
+    auto &placeholder = forward_refs_[val];
+    if (placeholder == nullptr)
+        placeholder = new llvm::Argument(get_type(val->get_type()));
+    return placeholder;
+}
+
+void LLVMGen::define(Value *val, llvm::Value *llvm_val) {
+    values_[val] = llvm_val;
+    auto it = forward_refs_.find(val);
+    if (it == forward_refs_.end())
+        return;
+    it->second->replaceAllUsesWith(llvm_val);
+    delete it->second;
+    forward_refs_.erase(it);
+}
@@ -0,0 +1,278 @@
+#include "RegAlloc.hpp"
+#include "DominatorTree.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+void RegAlloc::run(Function *f, const PhiElimination &phi_elim) {
+    vreg_type_.clear();
+    for (unsigned vreg = 0; vreg < phi_elim.get_num_vregs(f); vreg++) {
+        vreg_type_.push_back(phi_elim.get_vreg_type(f, vreg));
+    }
+    number_instrs(f, phi_elim);
+    compute_loop_depth(f);
+    build_intervals(f);
+
+    std::vector<int> int_vregs, float_vregs;
+    for (unsigned vreg = 0; vreg < intervals_.size(); vreg++) {
+        if (intervals_[vreg].end < 0)
+            continue;
+        if (vreg_type_[vreg]->is_float_type())
+            float_vregs.push_back(vreg);
+        else
+            int_vregs.push_back(vreg);
+    }
+    used_callee_saved_.clear();
+    linear_scan(classes_[0], int_vregs);
+    linear_scan(classes_[1], float_vregs);
+    resolve(f);
+}
+
+void RegAlloc::number_instrs(Function *f, const PhiElimination &phi_elim) {
+    events_.clear();
+    pos_.clear();
+    copy_begin_.clear();
+    block_begin_.clear();
+    block_end_.clear();
+    call_pos_.clear();
+
+    // alloca 的地址由后端直接算出，不占寄存器
+    auto vreg_of = [&](Value *val) {
+        if (dynamic_cast<AllocaInst *>(val))
+            return -1;
+        return phi_elim.get_vreg(val);
+    };
+
+    // 位置 0 留给形参的定值
+    int pos = 2;
+    for (auto &bb1 : f->get_basic_blocks()) {
+        auto bb = &bb1;
+        auto &events = events_[bb];
+        block_begin_[bb] = pos;
+        for (auto &inst : bb->get_instructions()) {
+            if (inst.is_phi() or inst.is_alloca())
+                continue;
+            pos_[&inst] = pos;
+            for (auto op : inst.get_operands()) {
+                auto vreg = vreg_of(op);
+                if (vreg >= 0)
+                    events.push_back({vreg, pos, false});
+            }
+            if (not inst.is_void())
+                events.push_back({vreg_of(&inst), pos + 1, true});
+            if (inst.is_call())
+                call_pos_.push_back(pos);
+            pos += 2;
+        }
+        copy_begin_[bb] = pos;
+        for (auto &copy : phi_elim.get_copies(bb)) {
+            if (copy.src != -1)
+                events.push_back({copy.src, pos, false});
+            events.push_back({copy.dst, pos + 1, true});
+            pos += 2;
+        }
+        block_end_[bb] = pos - 1;
+    }
+}
+
+void RegAlloc::compute_loop_depth(Function *f) {
+    loop_depth_.clear();
+    DomTree dom_tree;
+    dom_tree.build(f);
+    // 以回边的目标为循环头，循环体为不经过循环头就能到达回边源的块
+    std::unordered_map<BasicBlock *, std::unordered_set<BasicBlock *>> loops;
+    for (auto bb : dom_tree.get_post_order()) {
+        for (auto succ_bb : bb->get_succ_basic_blocks()) {
+            if (not dom_tree.dominates(succ_bb, bb))
+                continue;
+            auto &body = loops[succ_bb];
+            body.insert(succ_bb);
+            std::vector<BasicBlock *> work_list;
+            if (body.insert(bb).second)
+                work_list.push_back(bb);
+            while (not work_list.empty()) {
+                auto cur = work_list.back();
+                work_list.pop_back();
+                for (auto pre_bb : cur->get_pre_basic_blocks()) {
+                    if (dom_tree.is_reachable(pre_bb) and
+                        body.insert(pre_bb).second)
+                        work_list.push_back(pre_bb);
+                }
+            }
+        }
+    }
+    for (auto &[header, body] : loops) {
+        for (auto bb : body) {
+            loop_depth_[bb]++;
+        }
+    }
+}
+
+void RegAlloc::build_intervals(Function *f) {
+    unsigned num_vregs = vreg_type_.size();
+    std::unordered_map<BasicBlock *, BitVector> use, def;
+    live_in_.clear();
+    for (auto &bb1 : f->get_basic_blocks()) {
+        auto bb = &bb1;
+        BitVector bb_use(num_vregs), bb_def(num_vregs);
+        for (auto &event : events_[bb]) {
+            if (event.def)
+                bb_def.set(event.vreg);
+            else if (not bb_def.test(event.vreg))
+                bb_use.set(event.vreg);
+        }
+        use[bb] = std::move(bb_use);
+        def[bb] = std::move(bb_def);
+        live_in_[bb] = BitVector(num_vregs);
+    }
+
+    std::vector<BasicBlock *> bbs;
+    for (auto &bb : f->get_basic_blocks()) {
+        bbs.push_back(&bb);
+    }
+    std::unordered_map<BasicBlock *, BitVector> live_out;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto it = bbs.rbegin(); it != bbs.rend(); ++it) {
+            auto bb = *it;
+            BitVector out(num_vregs);
+            for (auto succ_bb : bb->get_succ_basic_blocks()) {
+                out.merge(live_in_[succ_bb]);
+            }
+            changed |= live_in_[bb].assign_transfer(use[bb], out, def[bb]);
+            live_out[bb] = std::move(out);
+        }
+    }
+
+    // 区间取所有活跃位置的包络
+    intervals_.assign(num_vregs, {});
+    auto extend = [&](int vreg, int pos) {
+        auto &interval = intervals_[vreg];
+        interval.start = std::min(interval.start, pos);
+        interval.end = std::max(interval.end, pos);
+    };
+    for (auto bb : bbs) {
+        live_in_[bb].for_each([&](unsigned vreg) {
+            extend(vreg, block_begin_[bb]);
+        });
+        live_out[bb].for_each(
+            [&](unsigned vreg) { extend(vreg, block_end_[bb]); });
+        auto weight = std::pow(10.0, std::min(loop_depth_[bb], 6));
+        for (auto &event : events_[bb]) {
+            extend(event.vreg, event.pos);
+            intervals_[event.vreg].weight += weight;
+        }
+    }
+    // 入口处活跃的值只能是形参，其定值位置为 0
+    live_in_[f->get_entry_block()].for_each(
+        [&](unsigned vreg) { extend(vreg, 0); });
+
+    for (auto &interval : intervals_) {
+        if (interval.end < 0)
+            continue;
+        interval.weight /= interval.end - interval.start + 1;
+        // 调用在 pos + 1 处破坏调用者保存的寄存器
+        for (auto pos : call_pos_) {
+            if (interval.start <= pos and interval.end >= pos + 2) {
+                interval.crosses_call = true;
+                break;
+            }
+        }
+    }
+}
+
+void RegAlloc::linear_scan(const RegClass &reg_class, std::vector<int> &vregs) {
+    std::sort(vregs.begin(), vregs.end(), [&](int a, int b) {
+        return intervals_[a].start < intervals_[b].start;
+    });
+
+    std::unordered_set<int> callee_saved(reg_class.callee_saved.begin(),
+                                         reg_class.callee_saved.end());
+    std::vector<int> active;
+    std::unordered_set<int> free_regs(reg_class.caller_saved.begin(),
+                                      reg_class.caller_saved.end());
+    free_regs.insert(reg_class.callee_saved.begin(),
+                     reg_class.callee_saved.end());
+    auto allowed = [&](Interval &interval, int reg) {
+        return not interval.crosses_call or callee_saved.count(reg);
+    };
+    auto assign = [&](int vreg, int reg) {
+        intervals_[vreg].reg = reg;
+        free_regs.erase(reg);
+        active.push_back(vreg);
+        if (callee_saved.count(reg) and
+            std::find(used_callee_saved_.begin(), used_callee_saved_.end(),
+                      reg) == used_callee_saved_.end())
+            used_callee_saved_.push_back(reg);
+    };
+
+    for (auto vreg : vregs) {
+        auto &cur = intervals_[vreg];
+        // 释放已经结束的区间占用的寄存器
+        for (auto it = active.begin(); it != active.end();) {
+            if (intervals_[*it].end < cur.start) {
+                free_regs.insert(intervals_[*it].reg);
+                it = active.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        // 优先使用调用者保存的寄存器，省去保存与恢复
+        int reg = -1;
+        for (auto candidate : reg_class.caller_saved) {
+            if (free_regs.count(candidate) and allowed(cur, candidate)) {
+                reg = candidate;
+                break;
+            }
+        }
+        for (auto candidate : reg_class.callee_saved) {
+            if (reg == -1 and free_regs.count(candidate))
+                reg = candidate;
+        }
+        if (reg != -1) {
+            assign(vreg, reg);
+            continue;
+        }
+
+        // 没有空闲寄存器：在能让出合适寄存器的区间中找代价最低的
+        auto victim = active.end();
+        for (auto it = active.begin(); it != active.end(); ++it) {
+            if (allowed(cur, intervals_[*it].reg) and
+                (victim == active.end() or
+                 intervals_[*it].weight < intervals_[*victim].weight))
+                victim = it;
+        }
+        if (victim == active.end() or
+            intervals_[*victim].weight >= cur.weight) {
+            cur.split = cur.start;
+            continue;
+        }
+        auto &spilled = intervals_[*victim];
+        spilled.split = cur.start;
+        reg = spilled.reg;
+        active.erase(victim);
+        free_regs.insert(reg);
+        assign(vreg, reg);
+    }
+}
+
+void RegAlloc::resolve(Function *f) {
+    reloads_.clear();
+    for (auto &bb : f->get_basic_blocks()) {
+        auto pre_end = block_end_[&bb];
+        for (auto succ_bb : bb.get_succ_basic_blocks()) {
+            auto succ_begin = block_begin_[succ_bb];
+            std::vector<std::pair<int, int>> reloads;
+            live_in_[succ_bb].for_each([&](unsigned vreg) {
+                auto reg = get_reg_at(vreg, succ_begin);
+                if (reg != -1 and get_reg_at(vreg, pre_end) == -1)
+                    reloads.emplace_back(vreg, reg);
+            });
+            if (not reloads.empty())
+                reloads_[{&bb, succ_bb}] = std::move(reloads);
+        }
+    }
+}
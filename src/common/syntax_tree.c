@@ -3,48 +3,136 @@
 
 #include "syntax_tree.h"
 
-syntax_tree_node *new_syntax_tree_node(const char *name) {
-    syntax_tree_node *new_node =
-        (syntax_tree_node *)malloc(sizeof(syntax_tree_node));
-    if (name)
-        strncpy(new_node->name, name, SYNTAX_TREE_NODE_NAME_MAX);
-    else
-        new_node->name[0] = '\0';
+// 第一块 4 KiB，之后每块是上一块的两倍，块数只随树的大小对数增长；
+// 块大小以 64 MiB 为上限，最后一块预留而未用的空间不超过 64 MiB
+#define ARENA_FIRST_BLOCK 4096
+#define ARENA_MAX_BLOCK ((size_t)64 << 20)
+#define ARENA_ALIGN sizeof(void *)
+
+struct arena_block {
+    struct arena_block *next;
+    size_t size;
+    size_t used;
+    char data[];
+};
+
+struct syntax_tree_arena {
+    struct arena_block *blocks;
+    // 名字的驻留表：开放定址，容量为 2 的幂，本身也分配在 arena 中
+    const char **names;
+    size_t names_cap;
+    size_t names_num;
+};
+
+static void *arena_alloc(struct syntax_tree_arena *a, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    struct arena_block *b = a->blocks;
+    if (!b || b->size - b->used < size) {
+        size_t block_size = b ? b->size * 2 : ARENA_FIRST_BLOCK;
+        if (block_size > ARENA_MAX_BLOCK)
+            block_size = ARENA_MAX_BLOCK;
+        while (block_size < size)
+            block_size *= 2;
+        b = (struct arena_block *)malloc(sizeof(*b) + block_size);
+        b->next = a->blocks;
+        b->size = block_size;
+        b->used = 0;
+        a->blocks = b;
+    }
+    void *p = b->data + b->used;
+    b->used += size;
+    return p;
+}
+
+static size_t hash_name(const char *name, size_t len) {
+    size_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void grow_names(struct syntax_tree_arena *a) {
+    size_t cap = a->names_cap ? a->names_cap * 2 : 256;
+    const char **names =
+        (const char **)arena_alloc(a, cap * sizeof(const char *));
+    memset(names, 0, cap * sizeof(const char *));
+    for (size_t i = 0; i < a->names_cap; i++) {
+        const char *name = a->names[i];
+        if (!name)
+            continue;
+        size_t j = hash_name(name, strlen(name)) & (cap - 1);
+        while (names[j])
+            j = (j + 1) & (cap - 1);
+        names[j] = name;
+    }
+    a->names = names;
+    a->names_cap = cap;
+}
+
+static const char *intern(struct syntax_tree_arena *a, const char *name,
+                          size_t len) {
+    if (a->names_num * 2 >= a->names_cap)
+        grow_names(a);
+    size_t i = hash_name(name, len) & (a->names_cap - 1);
+    while (a->names[i]) {
+        if (strncmp(a->names[i], name, len) == 0 && a->names[i][len] == '\0')
+            return a->names[i];
+        i = (i + 1) & (a->names_cap - 1);
+    }
+    char *copy = (char *)arena_alloc(a, len + 1);
+    memcpy(copy, name, len);
+    copy[len] = '\0';
+    a->names[i] = copy;
+    a->names_num++;
+    return copy;
+}
+
+syntax_tree_node *new_syntax_tree_node_n(syntax_tree *tree, const char *name,
+                                         size_t len, int children_max) {
+    syntax_tree_node *new_node = (syntax_tree_node *)arena_alloc(
+        tree->arena,
+        sizeof(syntax_tree_node) + children_max * sizeof(syntax_tree_node *));
+    new_node->children = (syntax_tree_node **)(new_node + 1);
     new_node->children_num = 0;
+    new_node->children_max = children_max;
+    new_node->name = name ? intern(tree->arena, name, len) : "";
     return new_node;
 }
 
+syntax_tree_node *new_syntax_tree_node(syntax_tree *tree, const char *name,
+                                       int children_max) {
+    return new_syntax_tree_node_n(tree, name, name ? strlen(name) : 0,
+                                  children_max);
+}
+
 int syntax_tree_add_child(syntax_tree_node *parent, syntax_tree_node *child) {
-    if (!parent || !child)
+    if (!parent || !child || parent->children_num == parent->children_max)
         return -1;
     parent->children[parent->children_num++] = child;
     return parent->children_num;
 }
 
-void del_syntax_tree_node(syntax_tree_node *node, int recursive) {
-    if (!node)
-        return;
-
-    int i;
-    if (recursive) {
-        for (i = 0; i < node->children_num; i++) {
-            del_syntax_tree_node(node->children[i], 1);
-        }
-    }
-    free(node);
-}
-
 syntax_tree *new_syntax_tree() {
-    return (syntax_tree *)malloc(sizeof(syntax_tree));
+    syntax_tree *tree = (syntax_tree *)malloc(sizeof(syntax_tree));
+    tree->root = NULL;
+    tree->arena =
+        (struct syntax_tree_arena *)calloc(1, sizeof(struct syntax_tree_arena));
+    return tree;
 }
 
 void del_syntax_tree(syntax_tree *tree) {
     if (!tree)
         return;
 
-    if (tree->root) {
-        del_syntax_tree_node(tree->root, 1);
+    struct arena_block *b = tree->arena->blocks;
+    while (b) {
+        struct arena_block *next = b->next;
+        free(b);
+        b = next;
     }
+    free(tree->arena);
     free(tree);
 }
 
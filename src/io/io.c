@@ -14,3 +14,39 @@ void neg_idx_except() {
     printf("negative index exception\n");
     exit(0);
 }
+
+static int *profile_desc;
+static int *profile_counters;
+
+// 按 ProfileData 读取的格式写出各函数的计数器，文件名由 CMINUS_PROFILE 指定；
+// 只写一次，退出时若已经写过则什么也不做
+void __profile_dump() {
+    if (!profile_desc)
+        return;
+    const char *path = getenv("CMINUS_PROFILE");
+    FILE *file = fopen(path ? path : "cminus.profdata", "w");
+    if (!file)
+        return;
+    fprintf(file, "cminus-edge-profile 1\n");
+    int *desc = profile_desc + 1;
+    int *counter = profile_counters;
+    for (int i = 0; i < profile_desc[0]; i++) {
+        fprintf(file, "function ");
+        int len = *desc++;
+        for (int j = 0; j < len; j++)
+            fputc(*desc++, file);
+        unsigned checksum = *desc++;
+        int num_counters = *desc++;
+        fprintf(file, " %u %d\n", checksum, num_counters);
+        for (int j = 0; j < num_counters; j++)
+            fprintf(file, "%u\n", (unsigned)*counter++);
+    }
+    fclose(file);
+    profile_desc = 0;
+}
+
+void __profile_init(int *desc, int *counters) {
+    profile_desc = desc;
+    profile_counters = counters;
+    atexit(__profile_dump);
+}
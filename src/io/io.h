@@ -5,3 +5,7 @@ void output(int a);
 void outputFloat(float a);
 
 void neg_idx_except();
+
+void __profile_init(int *desc, int *counters);
+
+void __profile_dump();
@@ -4,42 +4,18 @@
 #include <iostream>
 #include <memory>
 #include <sstream>
-#include <unordered_map>
-
-struct pair_hash {
-    template <typename T>
-    std::size_t operator()(const std::pair<T, Module *> val) const {
-        auto lhs = std::hash<T>()(val.first);
-        auto rhs =
-            std::hash<uintptr_t>()(reinterpret_cast<uintptr_t>(val.second));
-        return lhs ^ rhs;
-    }
-};
-
-static std::unordered_map<std::pair<int, Module *>,
-                          std::unique_ptr<ConstantInt>, pair_hash>
-    cached_int;
-static std::unordered_map<std::pair<bool, Module *>,
-                          std::unique_ptr<ConstantInt>, pair_hash>
-    cached_bool;
-static std::unordered_map<std::pair<float, Module *>,
-                          std::unique_ptr<ConstantFP>, pair_hash>
-    cached_float;
-static std::unordered_map<Type *, std::unique_ptr<ConstantZero>> cached_zero;
 
 ConstantInt *ConstantInt::get(int val, Module *m) {
-    if (cached_int.find(std::make_pair(val, m)) != cached_int.end())
-        return cached_int[std::make_pair(val, m)].get();
-    return (cached_int[std::make_pair(val, m)] = std::unique_ptr<ConstantInt>(
-                new ConstantInt(m->get_int32_type(), val)))
-        .get();
+    auto &cached = m->int_consts_[val];
+    if (not cached)
+        cached.reset(new ConstantInt(m->get_int32_type(), val));
+    return cached.get();
 }
 ConstantInt *ConstantInt::get(bool val, Module *m) {
-    if (cached_bool.find(std::make_pair(val, m)) != cached_bool.end())
-        return cached_bool[std::make_pair(val, m)].get();
-    return (cached_bool[std::make_pair(val, m)] = std::unique_ptr<ConstantInt>(
-                new ConstantInt(m->get_int1_type(), val ? 1 : 0)))
-        .get();
+    auto &cached = m->bool_consts_[val];
+    if (not cached)
+        cached.reset(new ConstantInt(m->get_int1_type(), val ? 1 : 0));
+    return cached.get();
 }
 std::string ConstantInt::print() {
     std::string const_ir;
@@ -58,7 +34,7 @@ std::string ConstantInt::print() {
 ConstantArray::ConstantArray(ArrayType *ty, const std::vector<Constant *> &val)
     : Constant(ty, "") {
     for (unsigned i = 0; i < val.size(); i++)
-        set_operand(i, val[i]);
+        add_operand(val[i]);
     this->const_array.assign(val.begin(), val.end());
 }
 
@@ -72,30 +48,27 @@ ConstantArray *ConstantArray::get(ArrayType *ty,
 }
 
 std::string ConstantArray::print() {
+    // 与其他常量一样不带自身的类型，元素则带上各自的类型
     std::string const_ir;
-    const_ir += this->get_type()->print();
-    const_ir += " ";
     const_ir += "[";
     for (unsigned i = 0; i < this->get_size_of_array(); i++) {
         Constant *element = get_element_value(i);
-        if (!dynamic_cast<ConstantArray *>(get_element_value(i))) {
-            const_ir += element->get_type()->print();
-        }
-        const_ir += element->print();
-        if (i < this->get_size_of_array()) {
+        if (i > 0) {
             const_ir += ", ";
         }
+        const_ir += element->get_type()->print();
+        const_ir += " ";
+        const_ir += element->print();
     }
     const_ir += "]";
     return const_ir;
 }
 
 ConstantFP *ConstantFP::get(float val, Module *m) {
-    if (cached_float.find(std::make_pair(val, m)) != cached_float.end())
-        return cached_float[std::make_pair(val, m)].get();
-    return (cached_float[std::make_pair(val, m)] = std::unique_ptr<ConstantFP>(
-                new ConstantFP(m->get_float_type(), val)))
-        .get();
+    auto &cached = m->float_consts_[val];
+    if (not cached)
+        cached.reset(new ConstantFP(m->get_float_type(), val));
+    return cached.get();
 }
 
 std::string ConstantFP::print() {
@@ -108,9 +81,10 @@ std::string ConstantFP::print() {
 }
 
 ConstantZero *ConstantZero::get(Type *ty, Module *m) {
-    if (not cached_zero[ty])
-        cached_zero[ty] = std::unique_ptr<ConstantZero>(new ConstantZero(ty));
-    return cached_zero[ty].get();
+    auto &cached = m->zero_consts_[ty];
+    if (not cached)
+        cached.reset(new ConstantZero(ty));
+    return cached.get();
 }
 
 std::string ConstantZero::print() { return "zeroinitializer"; }
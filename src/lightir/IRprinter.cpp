@@ -37,6 +37,12 @@ std::string print_instr_op_name(Instruction::OpID id) {
         return "mul";
     case Instruction::sdiv:
         return "sdiv";
+    case Instruction::shl:
+        return "shl";
+    case Instruction::ashr:
+        return "ashr";
+    case Instruction::lshr:
+        return "lshr";
     case Instruction::fadd:
         return "fadd";
     case Instruction::fsub:
@@ -44,6 +44,15 @@ IBinaryInst *IBinaryInst::create_mul(Value *v1, Value *v2, BasicBlock *bb) {
 IBinaryInst *IBinaryInst::create_sdiv(Value *v1, Value *v2, BasicBlock *bb) {
     return create(sdiv, v1, v2, bb);
 }
+IBinaryInst *IBinaryInst::create_shl(Value *v1, Value *v2, BasicBlock *bb) {
+    return create(shl, v1, v2, bb);
+}
+IBinaryInst *IBinaryInst::create_ashr(Value *v1, Value *v2, BasicBlock *bb) {
+    return create(ashr, v1, v2, bb);
+}
+IBinaryInst *IBinaryInst::create_lshr(Value *v1, Value *v2, BasicBlock *bb) {
+    return create(lshr, v1, v2, bb);
+}
 
 FBinaryInst::FBinaryInst(OpID id, Value *v1, Value *v2, BasicBlock *bb)
     : BaseInst<FBinaryInst>(bb->get_module()->get_float_type(), id, bb) {
@@ -366,6 +375,13 @@ Instruction *FBinaryInst::clone(BasicBlock *prt) const  {
   return new FBinaryInst(op_id_, get_operand(0), get_operand(1), prt);
 }
 
+Instruction *CallInst::clone(BasicBlock *prt) const {
+    // func_ 从未被赋值，被调函数以第一个操作数为准
+    auto func = static_cast<Function *>(get_operand(0));
+    return new CallInst(
+        func, {get_operands().begin() + 1, get_operands().end()}, prt);
+}
+
 Instruction *ICmpInst::clone(BasicBlock *prt) const  {
   return new ICmpInst(op_id_, get_operand(0), get_operand(1), prt);
 }
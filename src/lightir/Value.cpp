@@ -2,6 +2,7 @@
 #include "Type.hpp"
 #include "User.hpp"
 
+#include <algorithm>
 #include <cassert>
 
 bool Value::set_name(std::string name) {
@@ -17,8 +18,12 @@ void Value::add_use(User *user, unsigned arg_no) {
 };
 
 void Value::remove_use(User *user, unsigned arg_no) {
+    // 同一个 (user, arg_no) 在 use 链中至多出现一次，找到后即可停止；
+    // 按创建顺序删除使用者时（如 Mem2Reg 删除 load/store）目标总在链表前端
     auto target_use = Use(user, arg_no);
-    use_list_.remove_if([&](const Use &use) { return use == target_use; });
+    auto it = std::find(use_list_.begin(), use_list_.end(), target_use);
+    if (it != use_list_.end())
+        use_list_.erase(it);
 }
 
 void Value::replace_all_use_with(Value *new_val) {
@@ -7,6 +7,8 @@ int main(int argc, char **argv) {
         std::cout << "usage: " << argv[0] << " <cminus_file>" << std::endl;
     } else {
         auto s = parse(argv[1]);
+        if (s == nullptr)
+            return 1;
         auto a = AST(s);
         auto printer = ASTPrinter();
         a.run_visitor(printer);
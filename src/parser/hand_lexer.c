@@ -0,0 +1,293 @@
+/*
+ * 手写的 cminus-f 词法分析器，与 lexical_analyzer.l 接受同样的语言、
+ * 给出同样的词法单元与位置信息，可以在构建时代替 flex 生成的分析器
+ * （cmake -DCMINUSF_HAND_LEXER=ON）。
+ *
+ * 对外提供 flex 可重入接口中 syntax_analyzer.y 与 lexer.c 用到的部分，
+ * 语法分析器不需要区分两种实现。
+ *
+ * 整个输入放在一块以两个 '\0' 结尾的缓冲区中（与 yy_scan_buffer 的要求相同），
+ * next_token 只产生 (种类, 偏移, 长度) 形式的紧凑词法单元，直接引用缓冲区，
+ * 不复制文本、不分配内存，也不需要 strlen；
+ * yylex 只在返回前临时把词法单元末尾的字符换成 '\0' 作为 yytext，下次调用时恢复。
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "syntax_tree.h"
+#include "syntax_analyzer.h"
+
+struct yy_buffer_state {
+    char *base;        // 源代码，其后至少有两个 '\0'
+    size_t len;        // 不含结尾的 '\0'
+    int is_our_buffer; // 由分析器分配，销毁时释放
+};
+
+struct hand_scanner {
+    struct parse_context *extra;
+    FILE *in; // 还没有读入缓冲区的 stdio 输入
+    struct yy_buffer_state buffer;
+    int has_buffer;
+    size_t pos;
+    int in_comment;
+    char *text;     // yytext
+    char *hold_ptr; // 为 yytext 写入 '\0' 的位置与原来的字符
+    char hold_char;
+};
+
+// 紧凑的词法单元，offset 与 length 指向源缓冲区
+struct cminus_token {
+    int kind;
+    size_t offset;
+    size_t length;
+};
+
+static int is_letter(unsigned char c) {
+    return (unsigned char)((c | 0x20) - 'a') < 26;
+}
+
+static int is_digit(unsigned char c) { return (unsigned char)(c - '0') < 10; }
+
+// 与 lexical_analyzer.l 相同：等长时关键字优先于标识符
+static int keyword_kind(const char *p, size_t len) {
+    switch (len) {
+    case 2:
+        return memcmp(p, "if", 2) == 0 ? IF : IDENTIFIER;
+    case 3:
+        return memcmp(p, "int", 3) == 0 ? INT : IDENTIFIER;
+    case 4:
+        if (memcmp(p, "else", 4) == 0)
+            return ELSE;
+        return memcmp(p, "void", 4) == 0 ? VOID : IDENTIFIER;
+    case 5:
+        if (memcmp(p, "float", 5) == 0)
+            return FLOAT;
+        return memcmp(p, "while", 5) == 0 ? WHILE : IDENTIFIER;
+    case 6:
+        return memcmp(p, "return", 6) == 0 ? RETURN : IDENTIFIER;
+    default:
+        return IDENTIFIER;
+    }
+}
+
+// 单字符运算符与界符；后面可以跟 '=' 的由调用者先处理
+static int punct_kind(unsigned char c) {
+    switch (c) {
+    case '+':
+        return ADD;
+    case '-':
+        return SUB;
+    case '*':
+        return MUL;
+    case '/':
+        return DIV;
+    case '<':
+        return LT;
+    case '>':
+        return GT;
+    case '=':
+        return ASSIN;
+    case ';':
+        return SEMICOLON;
+    case ',':
+        return COMMA;
+    case '(':
+        return LPARENTHESE;
+    case ')':
+        return RPARENTHESE;
+    case '[':
+        return LBRACKET;
+    case ']':
+        return RBRACKET;
+    case '{':
+        return LBRACE;
+    case '}':
+        return RBRACE;
+    default:
+        return ERROR;
+    }
+}
+
+// 读入 stdio 输入的全部内容；每次分析只分配这一块缓冲区
+static void load_stream(struct hand_scanner *s) {
+    size_t cap = 4096, len = 0, n;
+    char *base = malloc(cap + 2);
+    while ((n = fread(base + len, 1, cap - len, s->in)) > 0) {
+        len += n;
+        if (len == cap) {
+            cap *= 2;
+            base = realloc(base, cap + 2);
+        }
+    }
+    base[len] = base[len + 1] = '\0';
+    s->buffer.base = base;
+    s->buffer.len = len;
+    s->buffer.is_our_buffer = 1;
+    s->has_buffer = 1;
+    s->pos = 0;
+}
+
+// 位置信息的更新与 lexical_analyzer.l 中的动作逐条对应
+static int next_token(struct hand_scanner *s, struct cminus_token *tok) {
+    struct parse_context *x = s->extra;
+    const char *base = s->buffer.base;
+    const char *p = base + s->pos, *end = base + s->buffer.len;
+
+    while (p < end) {
+        const char *start = p;
+        unsigned char c = *p++;
+
+        if (s->in_comment) {
+            if (c == '*' && *p == '/') {
+                p++;
+                x->pos_start = x->pos_end;
+                x->pos_end += 2;
+                s->in_comment = 0;
+            } else if (c == '\n') {
+                x->pos_start = 1;
+                x->pos_end = 1;
+                x->lines++;
+            } else {
+                x->pos_start = x->pos_end + 1;
+            }
+            continue;
+        }
+
+        int kind;
+        if (c == '\n') {
+            x->lines++;
+            x->pos_start = 1;
+            x->pos_end = 1;
+            continue;
+        } else if (c == ' ' || c == '\t') {
+            x->pos_start = x->pos_end;
+            x->pos_end += 1;
+            continue;
+        } else if (c == '/' && *p == '*') {
+            p++;
+            x->pos_start = x->pos_end;
+            x->pos_end += 2;
+            s->in_comment = 1;
+            continue;
+        } else if (is_letter(c)) {
+            while (is_letter(*p))
+                p++;
+            kind = keyword_kind(start, p - start);
+        } else if (is_digit(c)) {
+            while (is_digit(*p))
+                p++;
+            kind = INTEGER;
+            if (*p == '.') {
+                p++;
+                while (is_digit(*p))
+                    p++;
+                kind = FLOATPOINT;
+            }
+        } else if (c == '.' && is_digit(*p)) {
+            while (is_digit(*p))
+                p++;
+            kind = FLOATPOINT;
+        } else if (*p == '=' && (c == '<' || c == '>' || c == '=' ||
+                                 c == '!')) {
+            p++;
+            kind = c == '<' ? LTE : c == '>' ? GTE : c == '=' ? EQ : NEQ;
+        } else {
+            kind = punct_kind(c);
+        }
+
+        // 末尾的 '\0' 不是字母或数字，向前查看不会越过缓冲区
+        x->pos_start = x->pos_end;
+        x->pos_end += (int)(p - start);
+        tok->kind = kind;
+        tok->offset = start - base;
+        tok->length = p - start;
+        s->pos = p - base;
+        return kind;
+    }
+    s->pos = s->buffer.len;
+    return 0;
+}
+
+static void release_text(struct hand_scanner *s) {
+    if (s->hold_ptr) {
+        *s->hold_ptr = s->hold_char;
+        s->hold_ptr = NULL;
+    }
+}
+
+int yylex(YYSTYPE *yylval_param, yyscan_t yyscanner) {
+    struct hand_scanner *s = yyscanner;
+    struct cminus_token tok;
+
+    release_text(s);
+    if (!s->has_buffer)
+        load_stream(s);
+    if (!next_token(s, &tok)) {
+        s->text = s->buffer.base + s->buffer.len;
+        return 0;
+    }
+    s->text = s->buffer.base + tok.offset;
+    s->hold_ptr = s->text + tok.length;
+    s->hold_char = *s->hold_ptr;
+    *s->hold_ptr = '\0';
+    // 与 flex 版本一样，非法字符不建立结点
+    if (tok.kind != ERROR)
+        yylval_param->node =
+            new_syntax_tree_node_n(s->extra->tree, s->text, tok.length, 0);
+    return tok.kind;
+}
+
+int yylex_init_extra(struct parse_context *extra, yyscan_t *scanner) {
+    struct hand_scanner *s = calloc(1, sizeof(*s));
+    if (!s)
+        return 1;
+    s->extra = extra;
+    s->in = stdin;
+    *scanner = s;
+    return 0;
+}
+
+int yylex_destroy(yyscan_t yyscanner) {
+    struct hand_scanner *s = yyscanner;
+    release_text(s);
+    if (s->has_buffer && s->buffer.is_our_buffer)
+        free(s->buffer.base);
+    free(s);
+    return 0;
+}
+
+void yyset_in(FILE *in, yyscan_t yyscanner) {
+    ((struct hand_scanner *)yyscanner)->in = in;
+}
+
+struct parse_context *yyget_extra(yyscan_t yyscanner) {
+    return ((struct hand_scanner *)yyscanner)->extra;
+}
+
+char *yyget_text(yyscan_t yyscanner) {
+    return ((struct hand_scanner *)yyscanner)->text;
+}
+
+struct yy_buffer_state *yy_scan_buffer(char *base, size_t size,
+                                       yyscan_t yyscanner) {
+    struct hand_scanner *s = yyscanner;
+    if (size < 2 || base[size - 2] != '\0' || base[size - 1] != '\0')
+        return NULL;
+    s->buffer.base = base;
+    s->buffer.len = size - 2;
+    s->buffer.is_our_buffer = 0;
+    s->has_buffer = 1;
+    s->pos = 0;
+    return &s->buffer;
+}
+
+struct yy_buffer_state *yy_scan_bytes(const char *bytes, int len,
+                                      yyscan_t yyscanner) {
+    char *base = malloc((size_t)len + 2);
+    memcpy(base, bytes, len);
+    base[len] = base[len + 1] = '\0';
+    struct yy_buffer_state *b = yy_scan_buffer(base, (size_t)len + 2, yyscanner);
+    b->is_our_buffer = 1;
+    return b;
+}
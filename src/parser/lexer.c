@@ -4,17 +4,11 @@
 #include <syntax_analyzer.h>
 
 ///
-extern int lines;
-extern int pos_start;
-extern int pos_end;
-
-///
-extern FILE *yyin;
-extern char *yytext;
-extern int yylex();
-
-// Mac-only hack.
-YYSTYPE yylval;
+extern int yylex(YYSTYPE *yylval_param, yyscan_t yyscanner);
+extern int yylex_init_extra(struct parse_context *extra, yyscan_t *scanner);
+extern int yylex_destroy(yyscan_t yyscanner);
+extern void yyset_in(FILE *in, yyscan_t yyscanner);
+extern char *yyget_text(yyscan_t yyscanner);
 
 ///
 int main(int argc, const char **argv) {
@@ -24,18 +18,27 @@ int main(int argc, const char **argv) {
     }
 
     const char *input_file = argv[1];
-    yyin = fopen(input_file, "r");
-    if (!yyin) {
+    FILE *input = fopen(input_file, "r");
+    if (!input) {
         fprintf(stderr, "cannot open file: %s\n", input_file);
         return 1;
     }
 
+    struct parse_context ctx = {1, 1, 1, new_syntax_tree()};
+    yyscan_t scanner;
+    yylex_init_extra(&ctx, &scanner);
+    yyset_in(input, scanner);
+
+    YYSTYPE lval;
     int token;
     printf("%5s\t%10s\t%s\t%s\n", "Token", "Text", "Line",
            "Column (Start,End)");
-    while ((token = yylex())) {
-        printf("%-5d\t%10s\t%d\t(%d,%d)\n", token, yytext, lines, pos_start,
-               pos_end);
+    while ((token = yylex(&lval, scanner))) {
+        printf("%-5d\t%10s\t%d\t(%d,%d)\n", token, yyget_text(scanner),
+               ctx.lines, ctx.pos_start, ctx.pos_end);
     }
+    yylex_destroy(scanner);
+    del_syntax_tree(ctx.tree);
+    fclose(input);
     return 0;
 }
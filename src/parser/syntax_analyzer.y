@@ -3,30 +3,58 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "syntax_tree.h"
+%}
 
-// external functions from lex
-extern int yylex();
-extern int yyparse();
-extern int yyrestart();
-extern FILE * yyin;
+%code requires {
+#include "syntax_tree.h"
 
-// external variables from lexical_analyzer module
-extern int lines;
-extern char * yytext;
-extern int pos_end;
-extern int pos_start;
+typedef void *yyscan_t;
 
-// Global syntax tree
-syntax_tree *gt;
+/* 一次分析的全部状态，通过 flex 的 yyextra 在词法与语法分析之间共享 */
+struct parse_context {
+    int lines;
+    int pos_start;
+    int pos_end;
+    syntax_tree *tree;
+};
+}
+
+%code {
+// external functions from reentrant lex
+int yylex(YYSTYPE *yylval_param, yyscan_t yyscanner);
+int yylex_init_extra(struct parse_context *extra, yyscan_t *scanner);
+int yylex_destroy(yyscan_t yyscanner);
+void yyset_in(FILE *in, yyscan_t yyscanner);
+struct parse_context *yyget_extra(yyscan_t yyscanner);
+struct yy_buffer_state *yy_scan_bytes(const char *bytes, int len,
+                                      yyscan_t yyscanner);
+struct yy_buffer_state *yy_scan_buffer(char *base, size_t size,
+                                       yyscan_t yyscanner);
+
+// Entry points other than parse()
+syntax_tree *parse_stream(FILE *input);
+syntax_tree *parse_buffer(const char *buffer, size_t len);
+syntax_tree *parse_buffer_inplace(char *buffer, size_t size);
 
 // Error reporting
-void yyerror(const char *s);
+void yyerror(yyscan_t scanner, const char *s);
 
 // Helper functions written for you with love
-syntax_tree_node *node(const char *node_name, int children_num, ...);
-%}
+syntax_tree_node *new_node(syntax_tree *tree, const char *node_name,
+                           int children_num, ...);
+// 语法动作中的 scanner 即 %parse-param，结点建在本次分析的语法树中
+#define node(...) new_node(yyget_extra(scanner)->tree, __VA_ARGS__)
+}
+
+%define api.pure full
+%lex-param {yyscan_t scanner}
+%parse-param {yyscan_t scanner}
 
 /* TODO: Complete this definition. */
 %union {
@@ -76,7 +104,7 @@ syntax_tree_node *node(const char *node_name, int children_num, ...);
 %%
 /* TODO: Your rules here. */
 
-program : 	declaration-list {$$ = node( "program", 1, $1); gt->root = $$;}
+program : 	declaration-list {$$ = node( "program", 1, $1); yyget_extra(scanner)->tree->root = $$;}
 		;
 
 declaration-list 	: 	declaration-list declaration {$$ = node( "declaration-list", 2, $1, $2);}
@@ -209,45 +237,150 @@ arg-list 	: 	arg-list COMMA expression {$$ = node( "arg-list", 3, $1, $2, $3);}
 %%
 
 /// The error reporting function.
-void yyerror(const char * s)
+void yyerror(yyscan_t scanner, const char * s)
 {
     // TO STUDENTS: This is just an example.
     // You can customize it as you like.
-    fprintf(stderr, "error at line %d column %d: %s\n", lines, pos_start, s);
+    struct parse_context *ctx = yyget_extra(scanner);
+    fprintf(stderr, "error at line %d column %d: %s\n", ctx->lines,
+            ctx->pos_start, s);
 }
 
-/// Parse input from file `input_path`, and prints the parsing results
-/// to stdout.  If input_path is NULL, read from stdin.
+/// Run the parser on a scanner whose input has been set up.
+/// Returns NULL after a syntax error, which yyerror has already reported.
 ///
-/// This function initializes essential states before running yyparse().
+/// All state lives in `ctx` and the scanner, so several parses may run
+/// at the same time on different threads.
+static syntax_tree *run_parser(struct parse_context *ctx, yyscan_t scanner)
+{
+    int failed = yyparse(scanner);
+    yylex_destroy(scanner);
+    if (failed || ctx->tree->root == NULL) {
+        del_syntax_tree(ctx->tree);
+        return NULL;
+    }
+    return ctx->tree;
+}
+
+static void init_context(struct parse_context *ctx)
+{
+    ctx->lines = ctx->pos_start = ctx->pos_end = 1;
+    ctx->tree = new_syntax_tree();
+}
+
+/// Map `size` bytes of the file `fd` followed by at least two '\0' bytes,
+/// as flex's yy_scan_buffer requires. Returns NULL if mmap fails.
+///
+/// The file is mapped over an anonymous mapping one byte-pair longer: the
+/// rest of the last file page reads as zeros, and if the file ends exactly
+/// on a page boundary the anonymous page after it supplies the '\0's.
+/// The mapping is private and writable because flex temporarily writes a
+/// '\0' after each token; the file itself is never modified.
+static char *map_source(int fd, size_t size, size_t *map_len)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t len = (size + 2 + page - 1) / page * page;
+    char *base = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+        return NULL;
+    if (mmap(base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd,
+             0) == MAP_FAILED) {
+        munmap(base, len);
+        return NULL;
+    }
+    *map_len = len;
+    return base;
+}
+
+/// Parse input from file `input_path`, and returns the syntax tree.
+/// If input_path is NULL, read from stdin.
+/// Returns NULL if the file cannot be opened or does not parse; the error
+/// is printed to stderr and the caller decides whether to go on.
+///
+/// Non-empty regular files are memory-mapped and scanned in place;
+/// pipes, empty files and stdin go through flex's stdio input.
 syntax_tree *parse(const char *input_path)
 {
-    if (input_path != NULL) {
-        if (!(yyin = fopen(input_path, "r"))) {
-            fprintf(stderr, "[ERR] Open input file %s failed.\n", input_path);
-            exit(1);
-        }
-    } else {
-        yyin = stdin;
+    if (input_path == NULL)
+        return parse_stream(stdin);
+
+    int fd = open(input_path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "[ERR] Open input file %s failed.\n", input_path);
+        return NULL;
     }
+    struct stat st;
+    char *base = NULL;
+    size_t map_len = 0;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+        base = map_source(fd, (size_t)st.st_size, &map_len);
+    if (base == NULL) {
+        FILE *input = fdopen(fd, "r");
+        syntax_tree *tree = parse_stream(input);
+        fclose(input);
+        return tree;
+    }
+    close(fd);
+    syntax_tree *tree = parse_buffer_inplace(base, (size_t)st.st_size + 2);
+    munmap(base, map_len);
+    return tree;
+}
 
-    lines = pos_start = pos_end = 1;
-    gt = new_syntax_tree();
-    yyrestart(yyin);
-    yyparse();
-    return gt;
+/// Parse everything read from `input`. The stream is not closed.
+syntax_tree *parse_stream(FILE *input)
+{
+    struct parse_context ctx;
+    yyscan_t scanner;
+    init_context(&ctx);
+    yylex_init_extra(&ctx, &scanner);
+    yyset_in(input, scanner);
+    return run_parser(&ctx, scanner);
+}
+
+/// Parse the `len` bytes at `buffer`, which need not be NUL-terminated.
+/// The bytes are copied into a buffer owned by the scanner.
+syntax_tree *parse_buffer(const char *buffer, size_t len)
+{
+    struct parse_context ctx;
+    yyscan_t scanner;
+    init_context(&ctx);
+    yylex_init_extra(&ctx, &scanner);
+    yy_scan_bytes(buffer, (int)len, scanner);
+    return run_parser(&ctx, scanner);
+}
+
+/// Parse `buffer` in place without copying it. The last two of its `size`
+/// bytes must be '\0' and are not part of the source. The buffer must be
+/// writable (flex temporarily writes into it) and stay alive until this
+/// returns; its contents are restored by then.
+syntax_tree *parse_buffer_inplace(char *buffer, size_t size)
+{
+    struct parse_context ctx;
+    yyscan_t scanner;
+    init_context(&ctx);
+    yylex_init_extra(&ctx, &scanner);
+    if (!yy_scan_buffer(buffer, size, scanner)) {
+        yylex_destroy(scanner);
+        fprintf(stderr, "[ERR] Input buffer is not terminated by two NULs.\n");
+        return NULL;
+    }
+    return run_parser(&ctx, scanner);
 }
 
-/// A helper function to quickly construct a tree node.
+/// A helper function to quickly construct a tree node in `tree`.
+/// Grammar actions call it through the `node` macro.
 ///
 /// e.g. $$ = node("program", 1, $1);
-syntax_tree_node *node(const char *name, int children_num, ...)
+syntax_tree_node *new_node(syntax_tree *tree, const char *name,
+                           int children_num, ...)
 {
-    syntax_tree_node *p = new_syntax_tree_node(name);
+    syntax_tree_node *p =
+        new_syntax_tree_node(tree, name, children_num ? children_num : 1);
     syntax_tree_node *child;
 	// 这里表示 epsilon结点是通过 children_num == 0 来判断的
     if (children_num == 0) {
-        child = new_syntax_tree_node("epsilon");
+        child = new_syntax_tree_node(tree, "epsilon", 0);
         syntax_tree_add_child(p, child);
     } else {
         va_list ap;
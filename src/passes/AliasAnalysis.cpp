@@ -0,0 +1,154 @@
+#include "AliasAnalysis.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "GlobalVariable.hpp"
+#include "IRprinter.hpp"
+
+#include <algorithm>
+#include <vector>
+
+void AliasAnalysis::run() {
+    cache_.clear();
+    escaped_.clear();
+    for (auto &f : m_->get_functions()) {
+        for (auto &bb : f.get_basic_blocks()) {
+            for (auto &inst : bb.get_instructions()) {
+                if (inst.is_alloca())
+                    is_escaped(static_cast<AllocaInst *>(&inst));
+            }
+        }
+    }
+}
+
+AliasAnalysis::PtrInfo AliasAnalysis::decompose(Value *ptr) {
+    PtrInfo info{ptr, 0, true};
+    while (auto gep = dynamic_cast<GetElementPtrInst *>(info.base)) {
+        auto base = gep->get_operand(0);
+        // 第一个下标以指针指向的类型为步长，之后每层下标剥去一层数组
+        Type *ty = base->get_type()->get_pointer_element_type();
+        for (unsigned i = 1; i < gep->get_num_operand(); i++) {
+            if (i > 1)
+                ty = ty->get_array_element_type();
+            auto idx = dynamic_cast<ConstantInt *>(gep->get_operand(i));
+            if (idx == nullptr)
+                info.const_offset = false;
+            else
+                info.offset += idx->get_value() * static_cast<int>(ty->get_size());
+        }
+        info.base = base;
+    }
+    return info;
+}
+
+bool AliasAnalysis::is_identified_object(Value *base) {
+    if (dynamic_cast<GlobalVariable *>(base))
+        return true;
+    auto inst = dynamic_cast<Instruction *>(base);
+    return inst and inst->is_alloca();
+}
+
+bool AliasAnalysis::is_escaped(AllocaInst *alloca) {
+    auto it = escaped_.find(alloca);
+    if (it != escaped_.end())
+        return it->second;
+    bool escaped = compute_escaped(alloca);
+    escaped_[alloca] = escaped;
+    return escaped;
+}
+
+bool AliasAnalysis::compute_escaped(Value *addr) {
+    for (auto &use : addr->get_use_list()) {
+        auto user = dynamic_cast<Instruction *>(use.val_);
+        if (user == nullptr)
+            return true;
+        if (user->is_load())
+            continue;
+        // 只有作为 store 的地址操作数不会传出地址
+        if (user->is_store() and use.arg_no_ == 1)
+            continue;
+        if (user->is_gep() and use.arg_no_ == 0) {
+            if (compute_escaped(user))
+                return true;
+            continue;
+        }
+        return true;
+    }
+    return false;
+}
+
+AliasResult AliasAnalysis::alias(Value *ptr1, Value *ptr2) {
+    if (ptr1 == ptr2)
+        return AliasResult::MustAlias;
+    if (ptr2 < ptr1)
+        std::swap(ptr1, ptr2);
+    auto key = std::make_pair(ptr1, ptr2);
+    auto it = cache_.find(key);
+    if (it != cache_.end())
+        return it->second;
+    auto result = compute_alias(ptr1, ptr2);
+    cache_.emplace(key, result);
+    return result;
+}
+
+AliasResult AliasAnalysis::compute_alias(Value *ptr1, Value *ptr2) {
+    auto info1 = decompose(ptr1);
+    auto info2 = decompose(ptr2);
+
+    if (info1.base == info2.base) {
+        if (not info1.const_offset or not info2.const_offset)
+            return AliasResult::MayAlias;
+        int size1 = ptr1->get_type()->get_pointer_element_type()->get_size();
+        int size2 = ptr2->get_type()->get_pointer_element_type()->get_size();
+        if (info1.offset == info2.offset and size1 == size2)
+            return AliasResult::MustAlias;
+        if (info1.offset + size1 <= info2.offset or
+            info2.offset + size2 <= info1.offset)
+            return AliasResult::NoAlias;
+        return AliasResult::MayAlias;
+    }
+
+    // 两个不同的 alloca / 全局变量一定不重叠
+    if (is_identified_object(info1.base) and
+        is_identified_object(info2.base))
+        return AliasResult::NoAlias;
+
+    // 形参在本函数的栈帧建立之前就已存在，不可能指向本函数的 alloca；
+    // 其余来源的指针只有在 alloca 地址被传出时才可能指向它
+    for (auto [self, other] : {std::make_pair(info1.base, info2.base),
+                               std::make_pair(info2.base, info1.base)}) {
+        auto alloca = dynamic_cast<AllocaInst *>(self);
+        if (alloca == nullptr)
+            continue;
+        if (dynamic_cast<Argument *>(other))
+            return AliasResult::NoAlias;
+        if (not is_escaped(alloca))
+            return AliasResult::NoAlias;
+    }
+    return AliasResult::MayAlias;
+}
+
+std::string AliasAnalysis::print(Function *f) {
+    f->get_parent()->set_print_name();
+    std::vector<Value *> ptrs;
+    for (auto &bb : f->get_basic_blocks()) {
+        for (auto &inst : bb.get_instructions()) {
+            Value *ptr = nullptr;
+            if (inst.is_load())
+                ptr = inst.get_operand(0);
+            else if (inst.is_store())
+                ptr = inst.get_operand(1);
+            if (ptr and std::find(ptrs.begin(), ptrs.end(), ptr) == ptrs.end())
+                ptrs.push_back(ptr);
+        }
+    }
+    const char *names[] = {"NoAlias", "MayAlias", "MustAlias"};
+    std::string output = "function " + f->get_name() + "\n";
+    for (unsigned i = 0; i < ptrs.size(); i++) {
+        for (unsigned j = i + 1; j < ptrs.size(); j++) {
+            output += "  " + print_as_op(ptrs[i], false) + ", " +
+                      print_as_op(ptrs[j], false) + ": " +
+                      names[static_cast<int>(alias(ptrs[i], ptrs[j]))] + "\n";
+        }
+    }
+    return output;
+}
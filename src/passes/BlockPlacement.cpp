@@ -0,0 +1,207 @@
+#include "BlockPlacement.hpp"
+#include "DominatorTree.hpp"
+#include "EdgeProfile.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <memory>
+
+namespace {
+
+std::vector<BasicBlock *> distinct_succs(BasicBlock *bb) {
+    std::vector<BasicBlock *> succs;
+    for (auto succ_bb : bb->get_succ_basic_blocks()) {
+        if (std::find(succs.begin(), succs.end(), succ_bb) == succs.end())
+            succs.push_back(succ_bb);
+    }
+    return succs;
+}
+
+} // namespace
+
+void BlockPlacement::run() {
+    for (auto &func : m_->get_functions()) {
+        if (func.get_num_basic_blocks() < 2)
+            continue;
+        func.reset_bbs();
+        blocks_.clear();
+        cold_.clear();
+        weight_.clear();
+        for (auto &bb : func.get_basic_blocks()) {
+            blocks_.push_back(&bb);
+        }
+        if (func.get_entry_block()->get_profile_count() >= 0)
+            estimate_profile(&func);
+        else
+            estimate_static(&func);
+        place(&func);
+    }
+}
+
+void BlockPlacement::estimate_profile(Function *f) {
+    for (auto bb : blocks_) {
+        auto count = bb->get_profile_count();
+        if (count == 0)
+            cold_.insert(bb);
+        auto succs = distinct_succs(bb);
+        for (auto succ_bb : succs) {
+            // 剖析之后新建的边没有计数，按前驱的次数平均分配
+            double weight = bb->get_edge_count(succ_bb);
+            if (weight < 0)
+                weight = count < 0 ? 0 : double(count) / succs.size();
+            weight_[{bb, succ_bb}] = weight;
+        }
+    }
+}
+
+void BlockPlacement::estimate_static(Function *f) {
+    DomTree dom_tree;
+    dom_tree.build(f);
+
+    // 自然循环：以同一个块为头的回边合并为一个循环
+    std::map<BasicBlock *, std::unordered_set<BasicBlock *>> loops;
+    for (auto bb : blocks_) {
+        if (not dom_tree.is_reachable(bb)) {
+            cold_.insert(bb);
+            continue;
+        }
+        for (auto succ_bb : bb->get_succ_basic_blocks()) {
+            if (not dom_tree.dominates(succ_bb, bb))
+                continue;
+            auto &body = loops[succ_bb];
+            body.insert(succ_bb);
+            std::vector<BasicBlock *> work{bb};
+            while (not work.empty()) {
+                auto cur = work.back();
+                work.pop_back();
+                if (not body.insert(cur).second)
+                    continue;
+                for (auto pre_bb : cur->get_pre_basic_blocks()) {
+                    if (dom_tree.is_reachable(pre_bb))
+                        work.push_back(pre_bb);
+                }
+            }
+        }
+    }
+    std::unordered_map<BasicBlock *, int> depth;
+    for (auto &[header, body] : loops) {
+        for (auto bb : body) {
+            depth[bb]++;
+        }
+    }
+    for (auto bb : blocks_) {
+        for (auto &inst : bb->get_instructions()) {
+            if (EdgeProfile::is_noreturn_call(&inst))
+                cold_.insert(bb);
+        }
+    }
+
+    auto is_exit = [&](BasicBlock *src, BasicBlock *dst) {
+        for (auto &[header, body] : loops) {
+            if (body.count(src) and not body.count(dst))
+                return true;
+        }
+        return false;
+    };
+    for (auto bb : blocks_) {
+        auto succs = distinct_succs(bb);
+        if (succs.empty())
+            continue;
+        double freq = std::pow(8.0, std::min(depth[bb], 5));
+        // 冷后继概率为 0；离开循环的一边与留在循环中的一边按 1 : 7 分配
+        std::vector<double> prob;
+        for (auto succ_bb : succs) {
+            if (cold_.count(succ_bb))
+                prob.push_back(0);
+            else if (is_exit(bb, succ_bb))
+                prob.push_back(1);
+            else
+                prob.push_back(7);
+        }
+        double sum = 0;
+        for (auto p : prob) {
+            sum += p;
+        }
+        for (unsigned i = 0; i < succs.size(); i++) {
+            weight_[{bb, succs[i]}] =
+                sum == 0 ? 0 : freq * prob[i] / sum;
+        }
+    }
+}
+
+void BlockPlacement::place(Function *f) {
+    auto entry = f->get_entry_block();
+
+    // 按权重从大到小合并链，同权重时保持原来的边顺序
+    std::vector<std::pair<BasicBlock *, BasicBlock *>> edges;
+    for (auto bb : blocks_) {
+        for (auto succ_bb : distinct_succs(bb)) {
+            edges.emplace_back(bb, succ_bb);
+        }
+    }
+    std::stable_sort(edges.begin(), edges.end(),
+                     [&](const auto &a, const auto &b) {
+                         return weight_[a] > weight_[b];
+                     });
+    std::unordered_map<BasicBlock *, std::list<BasicBlock *> *> chain_of;
+    std::vector<std::unique_ptr<std::list<BasicBlock *>>> chains;
+    for (auto bb : blocks_) {
+        chains.emplace_back(new std::list<BasicBlock *>{bb});
+        chain_of[bb] = chains.back().get();
+    }
+    for (auto [src, dst] : edges) {
+        auto src_chain = chain_of[src], dst_chain = chain_of[dst];
+        if (src_chain == dst_chain or src_chain->back() != src or
+            dst_chain->front() != dst or dst == entry or
+            cold_.count(src) != cold_.count(dst))
+            continue;
+        for (auto bb : *dst_chain) {
+            chain_of[bb] = src_chain;
+        }
+        src_chain->splice(src_chain->end(), *dst_chain);
+    }
+
+    // 从入口所在的链开始，每次接上与已放置的块联系最紧密的热链
+    std::vector<std::list<BasicBlock *> *> pending;
+    for (auto &chain : chains) {
+        if (not chain->empty() and chain.get() != chain_of[entry])
+            pending.push_back(chain.get());
+    }
+    std::vector<BasicBlock *> order(chain_of[entry]->begin(),
+                                    chain_of[entry]->end());
+    std::unordered_set<BasicBlock *> placed(order.begin(), order.end());
+    while (true) {
+        std::list<BasicBlock *> *best = nullptr;
+        double best_weight = -1;
+        for (auto chain : pending) {
+            if (cold_.count(chain->front()))
+                continue;
+            double weight = 0;
+            for (auto bb : *chain) {
+                for (auto pre_bb : bb->get_pre_basic_blocks()) {
+                    if (placed.count(pre_bb))
+                        weight += weight_[{pre_bb, bb}];
+                }
+            }
+            if (weight > best_weight) {
+                best = chain;
+                best_weight = weight;
+            }
+        }
+        if (best == nullptr)
+            break;
+        order.insert(order.end(), best->begin(), best->end());
+        placed.insert(best->begin(), best->end());
+        pending.erase(std::find(pending.begin(), pending.end(), best));
+    }
+    for (auto chain : pending) {
+        if (cold_.count(chain->front()))
+            order.insert(order.end(), chain->begin(), chain->end());
+    }
+
+    auto &bbs = f->get_basic_blocks();
+    for (auto bb : order) {
+        bbs.splice(bbs.end(), bbs, bb->getIterator());
+    }
+}
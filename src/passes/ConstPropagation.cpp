@@ -20,6 +20,19 @@ ConstantInt *ConstFolder::compute(Instruction::OpID op, ConstantInt *value1, Con
     case Instruction::sdiv:
         return ConstantInt::get(static_cast<int>(c_value1 / c_value2), module_);
         break;
+    case Instruction::shl:
+        return ConstantInt::get(
+            static_cast<int>(static_cast<unsigned>(c_value1) << (c_value2 & 31)),
+            module_);
+        break;
+    case Instruction::ashr:
+        return ConstantInt::get(c_value1 >> (c_value2 & 31), module_);
+        break;
+    case Instruction::lshr:
+        return ConstantInt::get(
+            static_cast<int>(static_cast<unsigned>(c_value1) >> (c_value2 & 31)),
+            module_);
+        break;
     case Instruction::eq:
         return ConstantInt::get(c_value1 == c_value2, module_);
         break;
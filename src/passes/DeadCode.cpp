@@ -11,7 +11,13 @@ void DeadCode::run() {
         for (auto &F : m_->get_functions()) {
             auto *func = &F;
             changed |= clear_basic_blocks(func);
+            if (aggressive && !func->is_declaration()) {
+                post_dom_tree.build(func);
+                live_blocks.clear();
+            }
             mark(func);
+            if (aggressive)
+                changed |= rewrite_dead_branches(func);
             changed |= sweep(func);
         }
         sweep_globally();
@@ -65,14 +71,49 @@ void DeadCode::mark(Instruction *ins) {
             continue;
         if (def->get_function() != ins->get_function())
             continue;
-        if (marked.count(def))
-            continue;
-        marked[def] = true;
-        work_list.push_back(def);
+        mark_live(def);
+    }
+    if (!aggressive)
+        return;
+
+    // 活跃指令所在的块控制依赖的条件跳转同样活跃
+    auto *block = ins->get_parent();
+    if (live_blocks.insert(block).second && post_dom_tree.is_reachable(block)) {
+        for (auto *cd_block : post_dom_tree.get_frontier(block)) {
+            mark_live(cd_block->get_terminator());
+        }
+    }
+    // phi 需要保留每条入边
+    if (ins->is_phi()) {
+        for (auto [val, pre_bb] : static_cast<PhiInst *>(ins)->get_phi_pairs()) {
+            mark_live(pre_bb->get_terminator());
+        }
     }
 }
 
+void DeadCode::mark_live(Instruction *ins) {
+    if (marked.count(ins))
+        return;
+    marked[ins] = true;
+    work_list.push_back(ins);
+}
+
 bool DeadCode::is_critical(Instruction *ins) {
+    if (aggressive && ins->is_br()) {
+        // 无法到达出口的块（死循环）没有后必经信息，其中的跳转保持活跃
+        auto *block = ins->get_parent();
+        if (!post_dom_tree.is_reachable(block))
+            return true;
+        for (auto *succ : block->get_succ_basic_blocks()) {
+            if (!post_dom_tree.is_reachable(succ))
+                return true;
+        }
+        return false;
+    }
+    if (aggressive && ins->is_phi()) {
+        return false;
+    }
+
     const bool isExitOrControl = ins->is_ret() || ins->is_br();
     const bool isMemWriteOrPhi = ins->is_store() || ins->is_phi();
     
@@ -93,7 +134,34 @@ bool DeadCode::is_critical(Instruction *ins) {
     }
     
     const bool isReferenced = ins->get_use_list().size() > 0;
-    return isReferenced;
+    return !aggressive && isReferenced;
+}
+
+bool DeadCode::rewrite_dead_branches(Function *func) {
+    bool changed = false;
+    for (auto &bb : func->get_basic_blocks()) {
+        if (!bb.is_terminated() || !bb.get_terminator()->is_br())
+            continue;
+        auto *br = static_cast<BranchInst *>(bb.get_terminator());
+        if (marked.count(br))
+            continue;
+        if (!br->is_cond_br()) {
+            marked[br] = true;
+            continue;
+        }
+        // 死的条件跳转改为跳到最近的活跃后必经块
+        auto *target = post_dom_tree.get_idom(&bb);
+        while (target != nullptr && !live_blocks.count(target))
+            target = post_dom_tree.get_idom(target);
+        if (target == nullptr) {
+            marked[br] = true;
+            continue;
+        }
+        bb.erase_instr(br);
+        marked[BranchInst::create_br(target, &bb)] = true;
+        changed = true;
+    }
+    return changed;
 }
 
 bool DeadCode::sweep(Function *func) {
@@ -17,90 +17,32 @@ void Dominators::run_on_func(Function *f) {
     dom_dfs_order_.clear();
     for(auto &bb1 : f->get_basic_blocks()) {
         auto bb = &bb1;
-        idom_.insert({bb, nullptr});
-        dom_frontier_.insert({bb, {}});
-        dom_tree_succ_blocks_.insert({bb, {}});
+        idom_[bb] = nullptr;
+        dom_frontier_[bb].clear();
+        dom_tree_succ_blocks_[bb].clear();
     }
-    create_reverse_post_order(f);
-    create_idom(f);
-    create_dominance_frontier(f);
+    DomTree tree;
+    tree.build(f);
+    create_idom(f, tree);
+    create_dominance_frontier(f, tree);
     create_dom_tree_succ(f);
     create_dom_dfs_order(f);
 }
 
-BasicBlock *Dominators::intersect(BasicBlock *b1, BasicBlock *b2) {
-    while (b1 != b2) {
-        while (get_post_order(b1) < get_post_order(b2)) {
-            b1 = get_idom(b1);
-        }
-        while (get_post_order(b2) < get_post_order(b1)) {
-            b2 = get_idom(b2);
-        }
-    }
-    return b1;
-}
-
-void Dominators::create_reverse_post_order(Function *f) {
-    BBSet visited;
-    dfs(f->get_entry_block(), visited);
-}
-
-void Dominators::dfs(BasicBlock *bb, std::set<BasicBlock *> &visited) {
-    visited.insert(bb);
-    for (auto &succ : bb->get_succ_basic_blocks()) {
-        if (visited.find(succ) == visited.end()) {
-            dfs(succ, visited);
-        }
+void Dominators::create_idom(Function *f, const DomTree &tree) {
+    // 入口块的 idom 约定为自身，不可达的块为 nullptr
+    for (auto bb : tree.get_post_order()) {
+        auto idom = tree.get_idom(bb);
+        set_idom(bb, idom == nullptr ? bb : idom);
     }
-    post_order_vec_.push_back(bb);
-    post_order_.insert({bb, post_order_.size()});
-}
-
-void Dominators::create_idom(Function *f) {
-    // 分析得到 f 中各个基本块的 idom
-    idom_[f->get_entry_block()] = f->get_entry_block();
-    bool changed;
-    do {
-        changed = false;
-        for (auto it = post_order_vec_.rbegin(); it != post_order_vec_.rend();
-             it++) {
-            auto bb = *it;
-            if (bb == f->get_entry_block())
-                continue;
-            if (bb->get_pre_basic_blocks().empty())
-                continue;
-            BasicBlock *first_pred = bb->get_pre_basic_blocks().front();
-            BasicBlock *new_idom = first_pred;
-            for (auto &pred : bb->get_pre_basic_blocks()) {
-                if (pred == first_pred)
-                    continue;
-                if (get_idom(pred) != nullptr) {
-                    new_idom = intersect(pred, new_idom);
-                }
-            }
-            if (new_idom != get_idom(bb)) {
-                changed = true;
-                idom_[bb] = new_idom;
-            }
-        }
-    } while (changed);
 }
 
-void Dominators::create_dominance_frontier(Function *f) {
-    // 分析得到 f 中各个基本块的支配边界集合
-    for (auto &bb1 : f->get_basic_blocks()) {
-        auto bb = &bb1;
-        if (bb->get_pre_basic_blocks().size() >= 2) {
-            for (auto &pred : bb->get_pre_basic_blocks()) {
-                auto runner = pred;
-                while (runner != get_idom(bb)) {
-                    dom_frontier_[runner].insert(bb);
-                    runner = get_idom(runner);
-                }
-            }
-        }
+void Dominators::create_dominance_frontier(Function *f, const DomTree &tree) {
+    for (auto bb : tree.get_post_order()) {
+        auto &df = tree.get_frontier(bb);
+        BBSet df_set(df.begin(), df.end());
+        set_dominance_frontier(bb, df_set);
     }
-
 }
 
 void Dominators::create_dom_tree_succ(Function *f) {
@@ -115,16 +57,25 @@ void Dominators::create_dom_tree_succ(Function *f) {
 
 void Dominators::create_dom_dfs_order(Function *f) {
     // 分析得到 f 中各个基本块的支配树上的dfs序L,R
+    // 用显式栈代替递归：长链或深层嵌套的 if 会得到很深的支配树
     unsigned int order = 0;
-    std::function<void(BasicBlock *)> dfs = [&](BasicBlock *bb) {
+    std::vector<std::pair<BasicBlock *, BBSet::iterator>> stack;
+    auto visit = [&](BasicBlock *bb) {
         dom_tree_L_[bb] = ++ order;
         dom_dfs_order_.push_back(bb);
-        for (auto &succ : dom_tree_succ_blocks_[bb]) {
-            dfs(succ);
-        }
-        dom_tree_R_[bb] = order;
+        stack.emplace_back(bb, dom_tree_succ_blocks_[bb].begin());
     };
-    dfs(f->get_entry_block());
+    visit(f->get_entry_block());
+    while (not stack.empty()) {
+        auto &[bb, it] = stack.back();
+        if (it == dom_tree_succ_blocks_[bb].end()) {
+            dom_tree_R_[bb] = order;
+            stack.pop_back();
+            continue;
+        }
+        auto succ = *it++;
+        visit(succ);
+    }
     dom_post_order_ =
         std::vector(dom_dfs_order_.rbegin(), dom_dfs_order_.rend());
 }
@@ -0,0 +1,394 @@
+#include "EdgeProfile.hpp"
+#include "Constant.hpp"
+#include "DominatorTree.hpp"
+#include "Instruction.hpp"
+#include "SimplifyCFG.hpp"
+#include "logging.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <numeric>
+#include <sstream>
+
+namespace {
+
+// 出边的目标，按跳转中出现的顺序去重
+std::vector<BasicBlock *> distinct_succs(BasicBlock *bb) {
+    std::vector<BasicBlock *> succs;
+    for (auto succ_bb : bb->get_succ_basic_blocks()) {
+        if (std::find(succs.begin(), succs.end(), succ_bb) == succs.end())
+            succs.push_back(succ_bb);
+    }
+    return succs;
+}
+
+Instruction *first_non_phi(BasicBlock *bb) {
+    for (auto &inst : bb->get_instructions()) {
+        if (not inst.is_phi())
+            return &inst;
+    }
+    return nullptr;
+}
+
+void fnv_hash(unsigned &hash, unsigned val) {
+    for (int i = 0; i < 4; i++) {
+        hash ^= (val >> (8 * i)) & 0xff;
+        hash *= 16777619u;
+    }
+}
+
+} // namespace
+
+bool EdgeProfile::is_noreturn_call(Instruction *inst) {
+    return inst->is_call() and
+           inst->get_operand(0)->get_name() == "neg_idx_except";
+}
+
+EdgeProfile::EdgeProfile(Function *f) : f_(f) {
+    std::unordered_map<BasicBlock *, unsigned> index;
+    for (auto &bb : f->get_basic_blocks()) {
+        index.emplace(&bb, index.size());
+    }
+    unsigned exit_index = index.size();
+
+    edges_.push_back({nullptr, f->get_entry_block()});
+    for (auto &bb1 : f->get_basic_blocks()) {
+        auto bb = &bb1;
+        for (auto succ_bb : distinct_succs(bb)) {
+            edges_.push_back({bb, succ_bb});
+        }
+        bool exits = bb->is_terminated() and bb->get_terminator()->is_ret();
+        for (auto &inst : bb->get_instructions()) {
+            exits |= is_noreturn_call(&inst);
+        }
+        if (exits)
+            edges_.push_back({bb, nullptr});
+    }
+
+    checksum_ = 2166136261u;
+    fnv_hash(checksum_, exit_index);
+    auto node = [&](BasicBlock *bb) {
+        return bb == nullptr ? exit_index : index.at(bb);
+    };
+    for (auto &edge : edges_) {
+        fnv_hash(checksum_, node(edge.src));
+        fnv_hash(checksum_, node(edge.dst));
+    }
+
+    // 优先把执行得多或插桩代价高的边放进生成树：
+    // EXIT -> 入口无法插桩，回边通常最热，关键边插桩需要切分
+    DomTree dom_tree;
+    dom_tree.build(f);
+    std::unordered_map<BasicBlock *, unsigned> num_preds;
+    for (auto &edge : edges_) {
+        if (edge.dst)
+            num_preds[edge.dst]++;
+    }
+    auto priority = [&](const Edge &edge) {
+        if (edge.src == nullptr)
+            return 3;
+        if (edge.dst == nullptr)
+            return 0;
+        if (dom_tree.is_reachable(edge.src) and
+            dom_tree.dominates(edge.dst, edge.src))
+            return 2;
+        if (distinct_succs(edge.src).size() > 1 and num_preds[edge.dst] > 1)
+            return 1;
+        return 0;
+    };
+    std::vector<int> priorities;
+    for (auto &edge : edges_) {
+        priorities.push_back(priority(edge));
+    }
+    std::vector<unsigned> order(edges_.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](unsigned a, unsigned b) {
+        return priorities[a] > priorities[b];
+    });
+
+    std::vector<unsigned> parent(exit_index + 1);
+    std::iota(parent.begin(), parent.end(), 0);
+    std::function<unsigned(unsigned)> find = [&](unsigned x) {
+        return parent[x] == x ? x : parent[x] = find(parent[x]);
+    };
+    std::vector<bool> in_tree(edges_.size(), false);
+    for (auto i : order) {
+        auto a = find(node(edges_[i].src)), b = find(node(edges_[i].dst));
+        if (a == b)
+            continue;
+        parent[a] = b;
+        in_tree[i] = true;
+    }
+    for (unsigned i = 0; i < edges_.size(); i++) {
+        counter_.push_back(in_tree[i] ? -1 : num_counters_++);
+    }
+}
+
+std::vector<long long>
+EdgeProfile::reconstruct(const std::vector<long long> &counters) const {
+    std::vector<long long> count(edges_.size(), 0);
+    std::vector<bool> known(edges_.size(), false);
+    // 每个结点（EXIT 为 nullptr）关联的入边与出边
+    std::unordered_map<BasicBlock *, std::vector<unsigned>> in_edges, out_edges;
+    std::vector<BasicBlock *> nodes{nullptr};
+    for (auto &bb : f_->get_basic_blocks()) {
+        nodes.push_back(&bb);
+    }
+    for (unsigned i = 0; i < edges_.size(); i++) {
+        in_edges[edges_[i].dst].push_back(i);
+        out_edges[edges_[i].src].push_back(i);
+        if (counter_[i] >= 0) {
+            count[i] = counters[counter_[i]];
+            known[i] = true;
+        }
+    }
+
+    // 只剩一条未知边的结点，由入边之和等于出边之和求出这条边
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto node : nodes) {
+            auto &ins = in_edges[node];
+            auto &outs = out_edges[node];
+            int unknown = -1, num_unknown = 0;
+            long long in_sum = 0, out_sum = 0;
+            for (auto i : ins) {
+                if (known[i])
+                    in_sum += count[i];
+                else if (unknown != int(i))
+                    unknown = i, num_unknown++;
+            }
+            for (auto i : outs) {
+                if (known[i])
+                    out_sum += count[i];
+                else if (unknown != int(i))
+                    unknown = i, num_unknown++;
+            }
+            if (num_unknown != 1)
+                continue;
+            bool is_in = edges_[unknown].dst == node;
+            count[unknown] = std::max(0LL, is_in ? out_sum - in_sum
+                                                 : in_sum - out_sum);
+            known[unknown] = true;
+            changed = true;
+        }
+    }
+    return count;
+}
+
+void EdgeProfiler::run() {
+    std::vector<std::pair<Function *, EdgeProfile>> profiles;
+    unsigned num_counters = 0;
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        profiles.emplace_back(&func, EdgeProfile(&func));
+        num_counters += profiles.back().second.get_num_counters();
+    }
+
+    auto int32_type = m_->get_int32_type();
+    counters_ = GlobalVariable::create(
+        "__profile_counters", m_,
+        ArrayType::get(int32_type, std::max(num_counters, 1u)), false,
+        ConstantZero::get(int32_type, m_));
+
+    // 描述：函数个数，再对每个函数依次为名字长度、名字的各个字符、校验和、计数器个数
+    std::vector<Constant *> desc{ConstantInt::get(int(profiles.size()), m_)};
+    unsigned base = 0;
+    for (auto &[func, profile] : profiles) {
+        auto name = func->get_name();
+        desc.push_back(ConstantInt::get(int(name.size()), m_));
+        for (auto ch : name) {
+            desc.push_back(ConstantInt::get(int(ch), m_));
+        }
+        desc.push_back(ConstantInt::get(int(profile.get_checksum()), m_));
+        desc.push_back(ConstantInt::get(int(profile.get_num_counters()), m_));
+        instrument(func, profile, base);
+        base += profile.get_num_counters();
+    }
+    auto desc_type = ArrayType::get(int32_type, desc.size());
+    auto desc_var = GlobalVariable::create("__profile_desc", m_, desc_type,
+                                           true,
+                                           ConstantArray::get(desc_type, desc));
+
+    Function *main_func = nullptr;
+    for (auto &[func, profile] : profiles) {
+        if (func->get_name() == "main")
+            main_func = func;
+    }
+    if (main_func == nullptr)
+        return;
+    auto int32_ptr_type = m_->get_int32_ptr_type();
+    auto init = Function::create(
+        FunctionType::get(m_->get_void_type(),
+                          {int32_ptr_type, int32_ptr_type}),
+        "__profile_init", m_);
+    auto entry = main_func->get_entry_block();
+    auto pos = first_non_phi(entry);
+    auto zero = ConstantInt::get(0, m_);
+    auto desc_ptr = GetElementPtrInst::create_gep(desc_var, {zero, zero}, entry);
+    auto counters_ptr =
+        GetElementPtrInst::create_gep(counters_, {zero, zero}, entry);
+    auto call = CallInst::create_call(init, {desc_ptr, counters_ptr}, entry);
+    for (Instruction *inst : {static_cast<Instruction *>(desc_ptr),
+                              static_cast<Instruction *>(counters_ptr),
+                              static_cast<Instruction *>(call)}) {
+        entry->remove_instr(inst);
+        entry->insert_before(pos->getIterator(), inst);
+    }
+}
+
+void EdgeProfiler::instrument(Function *f, const EdgeProfile &profile,
+                              unsigned base) {
+    // 插桩位置按插桩前的控制流图决定
+    auto &edges = profile.get_edges();
+    std::unordered_map<BasicBlock *, unsigned> num_preds, num_succs;
+    for (auto &edge : edges) {
+        num_preds[edge.dst]++;
+        num_succs[edge.src]++;
+    }
+    for (unsigned i = 0; i < edges.size(); i++) {
+        auto counter = profile.get_counter(i);
+        if (counter < 0)
+            continue;
+        auto idx = base + counter;
+        auto [src, dst] = edges[i];
+        if (src == nullptr) {
+            insert_increment(dst, first_non_phi(dst), idx);
+        } else if (dst == nullptr) {
+            // 调用 neg_idx_except 的块在调用之前计数
+            Instruction *pos = src->get_terminator();
+            for (auto &inst : src->get_instructions()) {
+                if (EdgeProfile::is_noreturn_call(&inst)) {
+                    pos = &inst;
+                    break;
+                }
+            }
+            insert_increment(src, pos, idx);
+        } else if (num_succs[src] == 1) {
+            insert_increment(src, src->get_terminator(), idx);
+        } else if (num_preds[dst] == 1) {
+            insert_increment(dst, first_non_phi(dst), idx);
+        } else {
+            auto bb = SimplifyCFG::split_edge(src, dst);
+            insert_increment(bb, bb->get_terminator(), idx);
+        }
+    }
+}
+
+void EdgeProfiler::insert_increment(BasicBlock *bb, Instruction *pos,
+                                    unsigned idx) {
+    auto ptr = GetElementPtrInst::create_gep(
+        counters_, {ConstantInt::get(0, m_), ConstantInt::get(int(idx), m_)},
+        bb);
+    auto val = LoadInst::create_load(ptr, bb);
+    auto inc = IBinaryInst::create_add(val, ConstantInt::get(1, m_), bb);
+    auto store = StoreInst::create_store(inc, ptr, bb);
+    if (pos == nullptr)
+        return;
+    for (Instruction *inst : {static_cast<Instruction *>(ptr),
+                              static_cast<Instruction *>(val),
+                              static_cast<Instruction *>(inc),
+                              static_cast<Instruction *>(store)}) {
+        bb->remove_instr(inst);
+        bb->insert_before(pos->getIterator(), inst);
+    }
+}
+
+bool ProfileData::read(const std::string &path) {
+    std::ifstream in(path);
+    std::string magic;
+    int version;
+    if (not(in >> magic >> version) or magic != "cminus-edge-profile" or
+        version != 1)
+        return false;
+    std::string keyword, name;
+    unsigned checksum, num_counters;
+    while (in >> keyword >> name >> checksum >> num_counters) {
+        if (keyword != "function")
+            return false;
+        auto &func = funcs_[name];
+        func.checksum = checksum;
+        func.counters.resize(num_counters);
+        for (auto &counter : func.counters) {
+            unsigned long long val;
+            if (not(in >> val))
+                return false;
+            counter = val;
+        }
+    }
+    return in.eof();
+}
+
+bool ProfileData::get_counts(
+    Function *f, std::unordered_map<BasicBlock *, long long> &block_count,
+    std::map<std::pair<BasicBlock *, BasicBlock *>, long long> &edge_count)
+    const {
+    auto it = funcs_.find(f->get_name());
+    if (it == funcs_.end())
+        return false;
+    EdgeProfile profile(f);
+    if (profile.get_checksum() != it->second.checksum or
+        profile.get_num_counters() != it->second.counters.size())
+        return false;
+
+    auto count = profile.reconstruct(it->second.counters);
+    auto &edges = profile.get_edges();
+    for (auto &bb : f->get_basic_blocks()) {
+        block_count[&bb] = 0;
+    }
+    for (unsigned i = 0; i < edges.size(); i++) {
+        if (edges[i].dst)
+            block_count[edges[i].dst] += count[i];
+        if (edges[i].src and edges[i].dst)
+            edge_count[{edges[i].src, edges[i].dst}] = count[i];
+    }
+    return true;
+}
+
+std::string ProfileData::print(Module *m) const {
+    std::ostringstream out;
+    for (auto &func : m->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        std::unordered_map<BasicBlock *, long long> block_count;
+        std::map<std::pair<BasicBlock *, BasicBlock *>, long long> edge_count;
+        if (not get_counts(&func, block_count, edge_count)) {
+            out << "function " << func.get_name() << ": no matching profile\n";
+            continue;
+        }
+        // 与 Module::print 一样先给未命名的块编号，输出的块名与 -emit-llvm 一致
+        func.set_instr_name();
+        out << "function " << func.get_name() << "\n";
+        for (auto &bb : func.get_basic_blocks()) {
+            out << "  " << bb.get_name() << ": " << block_count[&bb] << "\n";
+            for (auto succ_bb : distinct_succs(&bb)) {
+                out << "    -> " << succ_bb->get_name() << ": "
+                    << edge_count[{&bb, succ_bb}] << "\n";
+            }
+        }
+    }
+    return out.str();
+}
+
+std::vector<std::string> ProfileData::annotate(Module *m) const {
+    std::vector<std::string> unmatched;
+    for (auto &func : m->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        std::unordered_map<BasicBlock *, long long> block_count;
+        std::map<std::pair<BasicBlock *, BasicBlock *>, long long> edge_count;
+        if (not get_counts(&func, block_count, edge_count)) {
+            unmatched.push_back(func.get_name());
+            continue;
+        }
+        for (auto [bb, count] : block_count) {
+            bb->set_profile_count(count);
+        }
+        for (auto [edge, count] : edge_count) {
+            edge.first->set_edge_count(edge.second, count);
+        }
+    }
+    return unmatched;
+}
@@ -5,6 +5,7 @@
 #include "Instruction.hpp"
 #include "Value.hpp"
 #include "logging.hpp"
+#include <algorithm>
 #include <cassert>
 #include <utility>
 #include <vector>
@@ -12,7 +13,14 @@
 void FunctionInline::run() { inline_all_functions(); }
 
 void FunctionInline::inline_all_functions() {
-    
+    long long max_count = 0;
+    for (auto &func : m_->get_functions()) {
+        for (auto &bb : func.get_basic_blocks()) {
+            max_count = std::max(max_count, bb.get_profile_count());
+        }
+    }
+    hot_count_ = std::max(1LL, max_count / 100);
+
     std::set<Function *> recursive_func;
     for (auto &func : m_->get_functions()) {
         for (auto &bb : func.get_basic_blocks()) {
@@ -46,7 +54,7 @@ void FunctionInline::inline_all_functions() {
                     if (outside_func.find(func1->get_name()) !=
                         outside_func.end())
                         continue;
-                    if(func1->get_basic_blocks().size() >=6){
+                    if (not should_inline(call, func1)) {
                         continue;
                     }
                     inline_function(call, func1);
@@ -57,6 +65,28 @@ void FunctionInline::inline_all_functions() {
     }
 }
 
+bool FunctionInline::should_inline(Instruction *call, Function *func) {
+    // 有多个 ret 的非 void 函数尚不支持内联，无论是否有剖析数据
+    if (not func->get_return_type()->is_void_type()) {
+        int num_rets = 0;
+        for (auto &bb : func->get_basic_blocks()) {
+            if (bb.is_terminated() and bb.get_terminator()->is_ret())
+                num_rets++;
+        }
+        if (num_rets != 1)
+            return false;
+    }
+    auto size = func->get_basic_blocks().size();
+    auto count = call->get_parent()->get_profile_count();
+    if (count < 0)
+        return size < 6;
+    if (count == 0)
+        return false;
+    if (count >= hot_count_)
+        return size < 24;
+    return size < 6;
+}
+
 void FunctionInline::inline_function(Instruction *call, Function *origin) {
     std::map<Value *, Value *> v_map;
     std::vector<BasicBlock *> bb_list;
@@ -67,10 +97,19 @@ void FunctionInline::inline_function(Instruction *call, Function *origin) {
     }
     auto call_bb = call->get_parent();
     auto call_func = call_bb->get_parent();
+    // 被内联的块按调用点次数占被调函数调用次数的比例缩放计数
+    auto call_count = call_bb->get_profile_count();
+    auto entry_count = origin->get_entry_block()->get_profile_count();
+    auto scale = [&](long long count) {
+        if (count < 0 or call_count < 0 or entry_count <= 0)
+            return -1LL;
+        return count * call_count / entry_count;
+    };
     std::vector<BasicBlock *> ret_void_bbs;
     for (auto &bb : origin->get_basic_blocks()) {
         auto bb_new =
             BasicBlock::create(call_func->get_parent(), "", call_func);
+        bb_new->set_profile_count(scale(bb.get_profile_count()));
         v_map.insert(std::make_pair(static_cast<Value *>(&bb),
                                     static_cast<Value *>(bb_new)));
         bb_list.push_back(bb_new);
@@ -101,6 +140,13 @@ void FunctionInline::inline_function(Instruction *call, Function *origin) {
             }
         }
     }
+    for (auto &bb : origin->get_basic_blocks()) {
+        auto bb_new = static_cast<BasicBlock *>(v_map[&bb]);
+        for (auto succ_bb : bb.get_succ_basic_blocks()) {
+            bb_new->set_edge_count(static_cast<BasicBlock *>(v_map[succ_bb]),
+                                   scale(bb.get_edge_count(succ_bb)));
+        }
+    }
     for (auto bb : bb_list) {
         for (auto &inst : bb->get_instructions()) {
             for (int i = 0; i < inst.get_num_operand(); i++) {
@@ -117,6 +163,12 @@ void FunctionInline::inline_function(Instruction *call, Function *origin) {
     Value *ret_val = nullptr; // 返回值
     bool is_terminated = false;
     auto bb_new = BasicBlock::create(call_func->get_parent(), "", call_func);
+    // 调用之后的指令连同跳转一起移到 bb_new，出边的计数也随之转移
+    bb_new->set_profile_count(call_count);
+    for (auto succ_bb : call_bb->get_succ_basic_blocks()) {
+        bb_new->set_edge_count(succ_bb, call_bb->get_edge_count(succ_bb));
+    }
+    call_bb->set_edge_count(bb_list.front(), call_count);
     if (!origin->get_return_type()->is_void_type()) {
         // 
         if (ret_list.size() == 1) {
@@ -125,6 +177,7 @@ void FunctionInline::inline_function(Instruction *call, Function *origin) {
             auto ret_bb = ret->get_parent();
             ret_bb->remove_instr(ret);
             BranchInst::create_br(bb_new, ret_bb);
+            ret_bb->set_edge_count(bb_new, ret_bb->get_profile_count());
         } else {
             // TODO: 处理多个返回值的情况
             // 提示：
@@ -145,6 +198,7 @@ void FunctionInline::inline_function(Instruction *call, Function *origin) {
         assert(ret_void_bbs.size() > 0);
         for (auto bb : ret_void_bbs) {
             BranchInst::create_br(bb_new, bb);
+            bb->set_edge_count(bb_new, bb->get_profile_count());
         }
     }
     std::vector<Instruction *> del_list;
@@ -0,0 +1,451 @@
+#include "InstCombine.hpp"
+#include "BasicBlock.hpp"
+#include "Function.hpp"
+#include "logging.hpp"
+
+#include <climits>
+
+namespace {
+
+// 右操作数为常量 C 时的代数恒等式：x op C => x 或 x op C => C
+struct IntIdentity {
+    Instruction::OpID op;
+    int constant;
+    bool result_is_lhs; // false 表示结果就是常量本身
+};
+
+const IntIdentity int_identities[] = {
+    {Instruction::add, 0, true},  {Instruction::mul, 1, true},
+    {Instruction::mul, 0, false}, {Instruction::sdiv, 1, true},
+    {Instruction::shl, 0, true},  {Instruction::ashr, 0, true},
+    {Instruction::lshr, 0, true},
+};
+
+// 浮点只保留对所有输入（含 -0.0、NaN）都精确成立的恒等式
+struct FloatIdentity {
+    Instruction::OpID op;
+    float constant;
+};
+
+const FloatIdentity float_identities[] = {
+    {Instruction::fsub, 0.0f},
+    {Instruction::fmul, 1.0f},
+    {Instruction::fdiv, 1.0f},
+};
+
+bool is_commutative(Instruction::OpID op) {
+    switch (op) {
+    case Instruction::add:
+    case Instruction::mul:
+    case Instruction::fadd:
+    case Instruction::fmul:
+    case Instruction::eq:
+    case Instruction::ne:
+    case Instruction::feq:
+    case Instruction::fne:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// 交换比较的两个操作数后应使用的谓词
+Instruction::OpID mirror_cmp(Instruction::OpID op) {
+    switch (op) {
+    case Instruction::gt:
+        return Instruction::lt;
+    case Instruction::lt:
+        return Instruction::gt;
+    case Instruction::ge:
+        return Instruction::le;
+    case Instruction::le:
+        return Instruction::ge;
+    case Instruction::fgt:
+        return Instruction::flt;
+    case Instruction::flt:
+        return Instruction::fgt;
+    case Instruction::fge:
+        return Instruction::fle;
+    case Instruction::fle:
+        return Instruction::fge;
+    default:
+        return op;
+    }
+}
+
+// 整数比较取反后的谓词
+Instruction::OpID inverse_icmp(Instruction::OpID op) {
+    switch (op) {
+    case Instruction::eq:
+        return Instruction::ne;
+    case Instruction::ne:
+        return Instruction::eq;
+    case Instruction::gt:
+        return Instruction::le;
+    case Instruction::le:
+        return Instruction::gt;
+    case Instruction::ge:
+        return Instruction::lt;
+    case Instruction::lt:
+        return Instruction::ge;
+    default:
+        assert(false && "not an integer compare");
+        return op;
+    }
+}
+
+bool eval_icmp(Instruction::OpID op, int lhs, int rhs) {
+    switch (op) {
+    case Instruction::eq:
+        return lhs == rhs;
+    case Instruction::ne:
+        return lhs != rhs;
+    case Instruction::gt:
+        return lhs > rhs;
+    case Instruction::ge:
+        return lhs >= rhs;
+    case Instruction::lt:
+        return lhs < rhs;
+    case Instruction::le:
+        return lhs <= rhs;
+    default:
+        assert(false && "not an integer compare");
+        return false;
+    }
+}
+
+// IR 中的 fcmp 是无序比较：任一操作数为 NaN 时结果为真
+bool eval_fcmp(Instruction::OpID op, float lhs, float rhs) {
+    if (lhs != lhs or rhs != rhs)
+        return true;
+    switch (op) {
+    case Instruction::feq:
+        return lhs == rhs;
+    case Instruction::fne:
+        return lhs != rhs;
+    case Instruction::fgt:
+        return lhs > rhs;
+    case Instruction::fge:
+        return lhs >= rhs;
+    case Instruction::flt:
+        return lhs < rhs;
+    case Instruction::fle:
+        return lhs <= rhs;
+    default:
+        assert(false && "not a float compare");
+        return false;
+    }
+}
+
+// 若 value 为 2 的正整数次幂，返回指数，否则返回 -1
+int log2_of(int value) {
+    if (value <= 1 or (value & (value - 1)) != 0)
+        return -1;
+    int k = 0;
+    while ((1 << k) != value)
+        k++;
+    return k;
+}
+
+} // namespace
+
+void InstCombine::run() {
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        run_on_func(&func);
+    }
+    LOG_INFO << "inst combine pass combined " << combined_count_
+             << " instructions";
+}
+
+void InstCombine::run_on_func(Function *func) {
+    work_list_.clear();
+    in_work_list_.clear();
+    for (auto &bb : func->get_basic_blocks()) {
+        for (auto &inst : bb.get_instructions()) {
+            push(&inst);
+        }
+    }
+
+    while (not work_list_.empty()) {
+        auto inst = work_list_.front();
+        work_list_.pop_front();
+        // 已被删除或重复入队的指令
+        if (in_work_list_.erase(inst) == 0)
+            continue;
+
+        if (is_trivially_dead(inst)) {
+            erase(inst);
+            continue;
+        }
+
+        auto result = combine(inst);
+        if (result == nullptr)
+            continue;
+        combined_count_++;
+        push_users(inst);
+        if (result == inst) {
+            push(inst);
+            continue;
+        }
+        inst->replace_all_use_with(result);
+        push(result);
+        erase(inst);
+    }
+}
+
+Value *InstCombine::combine(Instruction *inst) {
+    if (inst->is_phi())
+        return simplify_phi(inst);
+    if (auto folded = fold_constant(inst))
+        return folded;
+    if (inst->is_zext() or inst->is_fp2si() or inst->is_si2fp())
+        return simplify_cast(inst);
+    if (not inst->isBinary() and not inst->is_cmp() and not inst->is_fcmp())
+        return nullptr;
+
+    bool changed = canonicalize(inst);
+    Value *result = nullptr;
+    if ((result = simplify_identity(inst)) or
+        (result = simplify_same_operands(inst)) or
+        (result = reassociate(inst)) or (result = simplify_cmp_of_zext(inst)) or
+        (result = strength_reduce(inst)))
+        return result;
+    return changed ? inst : nullptr;
+}
+
+Value *InstCombine::fold_constant(Instruction *inst) {
+    auto op = inst->get_instr_type();
+    if (inst->is_add() or inst->is_sub() or inst->is_mul() or
+        inst->is_div() or inst->is_shift() or inst->is_cmp()) {
+        auto lhs = cast_constantint(inst->get_operand(0));
+        auto rhs = cast_constantint(inst->get_operand(1));
+        if (lhs == nullptr or rhs == nullptr)
+            return nullptr;
+        // 除零与溢出是未定义行为，留给运行时
+        if (op == Instruction::sdiv and
+            (rhs->get_value() == 0 or
+             (lhs->get_value() == INT_MIN and rhs->get_value() == -1)))
+            return nullptr;
+        return folder_.compute(op, lhs, rhs);
+    }
+    if (inst->is_fadd() or inst->is_fsub() or inst->is_fmul() or
+        inst->is_fdiv()) {
+        auto lhs = cast_constantfp(inst->get_operand(0));
+        auto rhs = cast_constantfp(inst->get_operand(1));
+        if (lhs == nullptr or rhs == nullptr)
+            return nullptr;
+        return folder_.compute(op, lhs, rhs);
+    }
+    if (inst->is_fcmp()) {
+        auto lhs = cast_constantfp(inst->get_operand(0));
+        auto rhs = cast_constantfp(inst->get_operand(1));
+        if (lhs == nullptr or rhs == nullptr)
+            return nullptr;
+        return ConstantInt::get(
+            eval_fcmp(op, lhs->get_value(), rhs->get_value()), m_);
+    }
+    if (inst->is_zext()) {
+        if (auto val = cast_constantint(inst->get_operand(0)))
+            return ConstantInt::get(val->get_value(), m_);
+    } else if (inst->is_si2fp()) {
+        if (auto val = cast_constantint(inst->get_operand(0)))
+            return folder_.compute(op, val);
+    } else if (inst->is_fp2si()) {
+        if (auto val = cast_constantfp(inst->get_operand(0)))
+            return folder_.compute(op, val);
+    }
+    return nullptr;
+}
+
+bool InstCombine::canonicalize(Instruction *inst) {
+    auto lhs = inst->get_operand(0);
+    auto rhs = inst->get_operand(1);
+    auto op = inst->get_instr_type();
+    if (dynamic_cast<Constant *>(lhs) == nullptr or
+        dynamic_cast<Constant *>(rhs) != nullptr)
+        return false;
+    if (not is_commutative(op) and mirror_cmp(op) == op)
+        return false;
+    inst->set_operand(0, rhs);
+    inst->set_operand(1, lhs);
+    inst->op_id_ = mirror_cmp(op);
+    return true;
+}
+
+Value *InstCombine::simplify_identity(Instruction *inst) {
+    auto op = inst->get_instr_type();
+    auto lhs = inst->get_operand(0);
+    if (auto rhs = cast_constantint(inst->get_operand(1))) {
+        for (auto &identity : int_identities) {
+            if (identity.op == op and identity.constant == rhs->get_value())
+                return identity.result_is_lhs ? lhs : rhs;
+        }
+    } else if (auto rhs = cast_constantfp(inst->get_operand(1))) {
+        for (auto &identity : float_identities) {
+            if (identity.op == op and identity.constant == rhs->get_value())
+                return lhs;
+        }
+    }
+    return nullptr;
+}
+
+Value *InstCombine::simplify_same_operands(Instruction *inst) {
+    if (inst->get_operand(0) != inst->get_operand(1))
+        return nullptr;
+    if (inst->is_sub())
+        return ConstantInt::get(0, m_);
+    if (inst->is_cmp())
+        return ConstantInt::get(
+            eval_icmp(inst->get_instr_type(), 0, 0), m_);
+    return nullptr;
+}
+
+Value *InstCombine::reassociate(Instruction *inst) {
+    auto rhs = cast_constantint(inst->get_operand(1));
+    if (rhs == nullptr)
+        return nullptr;
+    // sub x, C => add x, -C
+    if (inst->is_sub() and rhs->get_value() != INT_MIN) {
+        inst->set_operand(1, ConstantInt::get(-rhs->get_value(), m_));
+        inst->op_id_ = Instruction::add;
+        return inst;
+    }
+    // (x + C1) + C2 => x + (C1 + C2)
+    if (inst->is_add()) {
+        auto inner = dynamic_cast<Instruction *>(inst->get_operand(0));
+        if (inner == nullptr or not inner->is_add())
+            return nullptr;
+        auto inner_rhs = cast_constantint(inner->get_operand(1));
+        if (inner_rhs == nullptr)
+            return nullptr;
+        inst->set_operand(0, inner->get_operand(0));
+        inst->set_operand(
+            1, folder_.compute(Instruction::add, inner_rhs, rhs));
+        push(inner);
+        return inst;
+    }
+    return nullptr;
+}
+
+Value *InstCombine::strength_reduce(Instruction *inst) {
+    auto rhs = cast_constantint(inst->get_operand(1));
+    if (rhs == nullptr or not(inst->is_mul() or inst->is_div()))
+        return nullptr;
+    auto lhs = inst->get_operand(0);
+    auto bb = inst->get_parent();
+    if (rhs->get_value() == -1)
+        return insert_before(
+            inst, IBinaryInst::create_sub(ConstantInt::get(0, m_), lhs, bb));
+    int k = log2_of(rhs->get_value());
+    if (k < 0)
+        return nullptr;
+    if (inst->is_mul())
+        return insert_before(
+            inst, IBinaryInst::create_shl(lhs, ConstantInt::get(k, m_), bb));
+    // sdiv 向零取整：负数先加上 2^k - 1 再算术右移
+    auto sign = insert_before(
+        inst, IBinaryInst::create_ashr(lhs, ConstantInt::get(31, m_), bb));
+    auto bias = insert_before(
+        inst, IBinaryInst::create_lshr(sign, ConstantInt::get(32 - k, m_), bb));
+    auto sum = insert_before(inst, IBinaryInst::create_add(lhs, bias, bb));
+    return insert_before(
+        inst, IBinaryInst::create_ashr(sum, ConstantInt::get(k, m_), bb));
+}
+
+Value *InstCombine::simplify_cmp_of_zext(Instruction *inst) {
+    // icmp (zext i1 %c), K：分别代入 %c = 0/1 求出比较结果
+    if (not inst->is_cmp())
+        return nullptr;
+    auto zext = dynamic_cast<Instruction *>(inst->get_operand(0));
+    auto rhs = cast_constantint(inst->get_operand(1));
+    if (zext == nullptr or not zext->is_zext() or rhs == nullptr)
+        return nullptr;
+    auto cond = zext->get_operand(0);
+    if (not cond->get_type()->is_int1_type())
+        return nullptr;
+    auto op = inst->get_instr_type();
+    bool if_false = eval_icmp(op, 0, rhs->get_value());
+    bool if_true = eval_icmp(op, 1, rhs->get_value());
+    if (if_false == if_true)
+        return ConstantInt::get(if_true, m_);
+    if (if_true)
+        return cond;
+    // 结果为 !%c：仅当 %c 是只被这条 zext 使用的整数比较时原地取反
+    auto cmp = dynamic_cast<Instruction *>(cond);
+    if (cmp == nullptr or not cmp->is_cmp() or
+        cmp->get_use_list().size() != 1 or zext->get_use_list().size() != 1)
+        return nullptr;
+    cmp->op_id_ = inverse_icmp(cmp->get_instr_type());
+    push_users(cmp);
+    return cmp;
+}
+
+Value *InstCombine::simplify_cast(Instruction *inst) {
+    auto src = dynamic_cast<Instruction *>(inst->get_operand(0));
+    if (src == nullptr)
+        return nullptr;
+    // fptosi(sitofp(x)) => x：float 的尾数只有 24 位，
+    // 因此只对取值范围确定很小的 x（由 i1 扩展而来）成立
+    if (inst->is_fp2si() and src->is_si2fp()) {
+        auto origin = dynamic_cast<Instruction *>(src->get_operand(0));
+        if (origin and origin->is_zext())
+            return origin;
+    }
+    return nullptr;
+}
+
+Value *InstCombine::simplify_phi(Instruction *inst) {
+    Value *same = nullptr;
+    auto phi = static_cast<PhiInst *>(inst);
+    auto pairs = phi->get_phi_pairs();
+    // Mem2Reg 不为没有定值的前驱生成参数（打印为 undef），此时不能化简
+    if (pairs.size() != inst->get_parent()->get_pre_basic_blocks().size())
+        return nullptr;
+    for (auto [val, pre_bb] : pairs) {
+        if (val == inst or val == same)
+            continue;
+        if (same != nullptr)
+            return nullptr;
+        same = val;
+    }
+    return same;
+}
+
+Instruction *InstCombine::insert_before(Instruction *pos, Instruction *inst) {
+    auto bb = pos->get_parent();
+    bb->remove_instr(inst);
+    bb->insert_before(pos->getIterator(), inst);
+    return inst;
+}
+
+bool InstCombine::is_trivially_dead(Instruction *inst) {
+    if (not inst->get_use_list().empty())
+        return false;
+    return inst->isBinary() or inst->is_cmp() or inst->is_fcmp() or
+           inst->is_zext() or inst->is_fp2si() or inst->is_si2fp() or
+           inst->is_gep() or inst->is_phi();
+}
+
+void InstCombine::push(Value *val) {
+    auto inst = dynamic_cast<Instruction *>(val);
+    if (inst == nullptr or inst->get_parent() == nullptr)
+        return;
+    if (in_work_list_.insert(inst).second)
+        work_list_.push_back(inst);
+}
+
+void InstCombine::push_users(Value *val) {
+    for (auto &use : val->get_use_list()) {
+        push(use.val_);
+    }
+}
+
+void InstCombine::erase(Instruction *inst) {
+    for (auto op : inst->get_operands()) {
+        push(op);
+    }
+    in_work_list_.erase(inst);
+    inst->get_parent()->erase_instr(inst);
+}
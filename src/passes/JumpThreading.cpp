@@ -0,0 +1,321 @@
+#include "JumpThreading.hpp"
+#include "BasicBlock.hpp"
+#include "Function.hpp"
+#include "SimplifyCFG.hpp"
+#include "logging.hpp"
+
+#include <algorithm>
+
+void JumpThreading::run() {
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        // 每一轮只会减少可线程化的入边，限制轮数以控制复制带来的代码膨胀
+        for (int round = 0; round < 8 and run_on_func(&func); round++)
+            ;
+    }
+    LOG_INFO << "jump threading pass threaded " << threaded_count_
+             << " edges";
+}
+
+bool JumpThreading::run_on_func(Function *func) {
+    find_loop_headers(func);
+    std::vector<BasicBlock *> bbs;
+    for (auto &bb : func->get_basic_blocks()) {
+        bbs.push_back(&bb);
+    }
+
+    bool changed = false;
+    for (auto bb : bbs) {
+        if (loop_headers_.count(bb) or not can_duplicate(bb))
+            continue;
+        auto br = static_cast<BranchInst *>(bb->get_terminator());
+        std::vector<BasicBlock *> pre_bbs(bb->get_pre_basic_blocks().begin(),
+                                          bb->get_pre_basic_blocks().end());
+        for (auto pre_bb : pre_bbs) {
+            auto &succ_bbs = pre_bb->get_succ_basic_blocks();
+            if (pre_bb == bb or
+                std::count(succ_bbs.begin(), succ_bbs.end(), bb) != 1)
+                continue;
+            auto cond = eval_on_edge(br->get_condition(), bb, pre_bb, 4);
+            if (cond == nullptr)
+                continue;
+            auto target = static_cast<BasicBlock *>(
+                br->get_operand(cond->get_value() ? 1 : 2));
+            if (target == bb)
+                continue;
+            thread_edge(pre_bb, bb, target);
+            threaded_count_++;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+void JumpThreading::find_loop_headers(Function *func) {
+    // 深度优先遍历中回边的目标即为循环头
+    loop_headers_.clear();
+    std::unordered_map<BasicBlock *, bool> on_stack;
+    std::vector<std::pair<BasicBlock *, std::list<BasicBlock *>::iterator>>
+        stack;
+    auto entry = func->get_entry_block();
+    on_stack[entry] = true;
+    stack.emplace_back(entry, entry->get_succ_basic_blocks().begin());
+    while (not stack.empty()) {
+        auto &[bb, it] = stack.back();
+        if (it == bb->get_succ_basic_blocks().end()) {
+            on_stack[bb] = false;
+            stack.pop_back();
+            continue;
+        }
+        auto succ_bb = *it++;
+        auto visited = on_stack.find(succ_bb);
+        if (visited == on_stack.end()) {
+            on_stack[succ_bb] = true;
+            stack.emplace_back(succ_bb, succ_bb->get_succ_basic_blocks().begin());
+        } else if (visited->second) {
+            loop_headers_.insert(succ_bb);
+        }
+    }
+}
+
+ConstantInt *JumpThreading::eval_on_edge(Value *val, BasicBlock *bb,
+                                         BasicBlock *pred, int depth) {
+    if (auto constant = dynamic_cast<ConstantInt *>(val))
+        return constant;
+    auto inst = dynamic_cast<Instruction *>(val);
+    if (inst == nullptr or inst->get_parent() != bb)
+        return nullptr;
+    if (inst->is_phi()) {
+        for (auto [incoming, pre_bb] :
+             static_cast<PhiInst *>(inst)->get_phi_pairs()) {
+            if (pre_bb == pred)
+                return dynamic_cast<ConstantInt *>(incoming);
+        }
+        return nullptr;
+    }
+    if (depth == 0)
+        return nullptr;
+    if (inst->is_zext()) {
+        auto src = eval_on_edge(inst->get_operand(0), bb, pred, depth - 1);
+        return src ? ConstantInt::get(src->get_value(), m_) : nullptr;
+    }
+    if (inst->is_cmp() or inst->is_add() or inst->is_sub() or
+        inst->is_mul()) {
+        auto lhs = eval_on_edge(inst->get_operand(0), bb, pred, depth - 1);
+        auto rhs = eval_on_edge(inst->get_operand(1), bb, pred, depth - 1);
+        if (lhs == nullptr or rhs == nullptr)
+            return nullptr;
+        return folder_.compute(inst->get_instr_type(), lhs, rhs);
+    }
+    return nullptr;
+}
+
+bool JumpThreading::can_duplicate(BasicBlock *bb) {
+    if (not bb->is_terminated() or not bb->get_terminator()->is_br() or
+        not static_cast<BranchInst *>(bb->get_terminator())->is_cond_br())
+        return false;
+    int size = 0;
+    for (auto &inst : bb->get_instructions()) {
+        if (inst.is_alloca())
+            return false;
+        if (not inst.is_phi() and not inst.is_br())
+            size++;
+    }
+    return size <= dup_threshold;
+}
+
+void JumpThreading::thread_edge(BasicBlock *pred, BasicBlock *bb,
+                                BasicBlock *target) {
+    auto dup_bb = BasicBlock::create(m_, "", bb->get_parent());
+
+    // phi 取这条边上的参数，其余指令复制到新块并替换操作数
+    std::unordered_map<Value *, Value *> value_map;
+    for (auto &inst : bb->get_instructions()) {
+        if (inst.is_phi()) {
+            for (auto [incoming, pre_bb] :
+                 static_cast<PhiInst *>(&inst)->get_phi_pairs()) {
+                if (pre_bb == pred)
+                    value_map[&inst] = incoming;
+            }
+            continue;
+        }
+        if (inst.is_br())
+            break;
+        auto new_inst = inst.clone(dup_bb);
+        for (unsigned i = 0; i < new_inst->get_num_operand(); i++) {
+            auto it = value_map.find(new_inst->get_operand(i));
+            if (it != value_map.end())
+                new_inst->set_operand(i, it->second);
+        }
+        value_map[&inst] = new_inst;
+    }
+    BranchInst::create_br(target, dup_bb);
+
+    for (auto &inst : target->get_instructions()) {
+        if (not inst.is_phi())
+            break;
+        auto phi = static_cast<PhiInst *>(&inst);
+        for (auto [incoming, pre_bb] : phi->get_phi_pairs()) {
+            if (pre_bb != bb)
+                continue;
+            auto it = value_map.find(incoming);
+            phi->add_phi_pair_operand(
+                it == value_map.end() ? incoming : it->second, dup_bb);
+            break;
+        }
+    }
+
+    SimplifyCFG::remove_phi_incoming(bb, pred);
+    SimplifyCFG::redirect_edge(pred, bb, dup_bb);
+
+    // 最后一条入边也被线程化时 bb 已不可达，先断开它的出边，
+    // 以免重建 SSA 时把不可达路径上的原值当作可能的定值
+    bool dead = bb->get_pre_basic_blocks().empty();
+    if (dead) {
+        std::vector<BasicBlock *> succ_bbs(bb->get_succ_basic_blocks().begin(),
+                                           bb->get_succ_basic_blocks().end());
+        for (auto succ_bb : succ_bbs) {
+            SimplifyCFG::remove_phi_incoming(succ_bb, bb);
+        }
+        bb->erase_instr(bb->get_terminator());
+    }
+
+    for (auto &inst : bb->get_instructions()) {
+        if (inst.is_br())
+            break;
+        auto it = value_map.find(&inst);
+        // pred 上没有定值的 phi（undef）无法在副本中表示，保持原样
+        if (it == value_map.end())
+            continue;
+        update_ssa(&inst, it->second, bb, dup_bb);
+    }
+
+    if (dead) {
+        for (auto &inst : bb->get_instructions()) {
+            inst.remove_all_operands();
+        }
+        bb->erase_from_parent();
+    }
+}
+
+void JumpThreading::update_ssa(Instruction *orig, Value *copy, BasicBlock *bb,
+                               BasicBlock *dup_bb) {
+    std::vector<std::pair<Instruction *, unsigned>> uses;
+    for (auto &use : orig->get_use_list()) {
+        auto user = static_cast<Instruction *>(use.val_);
+        if (user->is_phi() or user->get_parent() != bb)
+            uses.emplace_back(user, use.arg_no_);
+    }
+    if (uses.empty())
+        return;
+
+    orig_ = orig;
+    copy_ = copy;
+    bb_ = bb;
+    dup_bb_ = dup_bb;
+    entry_val_.clear();
+    new_phis_.clear();
+    pending_phis_.clear();
+    for (auto [user, arg_no] : uses) {
+        Value *val;
+        if (user->is_phi())
+            val = read_at_exit(
+                static_cast<BasicBlock *>(user->get_operand(arg_no + 1)));
+        else
+            val = read_at_entry(user->get_parent());
+        fill_pending_phis();
+        if (val != orig)
+            user->set_operand(arg_no, val);
+    }
+
+    // 删除只有一个不同参数或无人使用的新 phi
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto &phi : new_phis_) {
+            if (phi == nullptr)
+                continue;
+            Value *same = nullptr;
+            bool trivial = true;
+            for (auto [incoming, pre_bb] : phi->get_phi_pairs()) {
+                if (incoming == phi or incoming == same)
+                    continue;
+                if (same != nullptr)
+                    trivial = false;
+                same = incoming;
+            }
+            if (not trivial or same == nullptr) {
+                if (not phi->get_use_list().empty())
+                    continue;
+            } else {
+                phi->replace_all_use_with(same);
+            }
+            phi->remove_all_operands();
+            phi->get_parent()->erase_instr(phi);
+            phi = nullptr;
+            changed = true;
+        }
+    }
+}
+
+Value *JumpThreading::read_at_exit(BasicBlock *block) {
+    if (block == bb_)
+        return orig_;
+    if (block == dup_bb_)
+        return copy_;
+    return read_at_entry(block);
+}
+
+// 沿单前驱链向上找到入口处的定值，链上的块共享这个值；多前驱的块先放一个
+// 没有参数的 phi 并记入 pending_phis_，由 fill_pending_phis 补齐参数。
+// 整个查找不随 CFG 的深度递归
+Value *JumpThreading::read_at_entry(BasicBlock *block) {
+    std::vector<BasicBlock *> chain;
+    Value *val = nullptr;
+    while (val == nullptr) {
+        auto it = entry_val_.find(block);
+        if (it != entry_val_.end()) {
+            val = it->second;
+            break;
+        }
+        auto &pre_bbs = block->get_pre_basic_blocks();
+        if (pre_bbs.size() != 1) {
+            // 不可达的块取原值即可
+            if (pre_bbs.empty()) {
+                val = orig_;
+            } else {
+                auto phi = PhiInst::create_phi(orig_->get_type(), block);
+                block->add_instr_begin(phi);
+                new_phis_.push_back(phi);
+                pending_phis_.push_back(phi);
+                val = phi;
+            }
+            entry_val_[block] = val;
+            break;
+        }
+        // 先占位，不可达的单前驱环会回到这里并取原值
+        entry_val_[block] = orig_;
+        chain.push_back(block);
+        auto pre_bb = pre_bbs.front();
+        if (pre_bb == bb_)
+            val = orig_;
+        else if (pre_bb == dup_bb_)
+            val = copy_;
+        else
+            block = pre_bb;
+    }
+    for (auto chain_bb : chain)
+        entry_val_[chain_bb] = val;
+    return val;
+}
+
+void JumpThreading::fill_pending_phis() {
+    while (not pending_phis_.empty()) {
+        auto phi = pending_phis_.back();
+        pending_phis_.pop_back();
+        for (auto pre_bb : phi->get_parent()->get_pre_basic_blocks()) {
+            phi->add_phi_pair_operand(read_at_exit(pre_bb), pre_bb);
+        }
+    }
+}
@@ -0,0 +1,175 @@
+#include "Liveness.hpp"
+#include "DominatorTree.hpp"
+#include "Function.hpp"
+
+void Liveness::run() {
+    value_id_.clear();
+    values_.clear();
+    use_.clear();
+    def_.clear();
+    phi_use_.clear();
+    live_in_.clear();
+    live_out_.clear();
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        run_on_func(&func);
+    }
+}
+
+void Liveness::run_on_func(Function *f) {
+    number_values(f);
+    compute_local(f);
+
+    unsigned size = get_num_values(f);
+    for (auto &bb : f->get_basic_blocks()) {
+        live_in_[&bb] = BitVector(size);
+        live_out_[&bb] = phi_use_[&bb];
+    }
+
+    // 逆向数据流问题，按正向后序访问时后继大多已先于当前块更新；
+    // 集合只增不减，live_out 可以直接在原值上合并
+    DomTree tree;
+    tree.build(f);
+    auto post_order = tree.get_post_order();
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto bb : post_order) {
+            auto &live_out = live_out_[bb];
+            for (auto succ_bb : bb->get_succ_basic_blocks()) {
+                changed |= live_out.merge(live_in_[succ_bb]);
+            }
+            changed |=
+                live_in_[bb].assign_transfer(use_[bb], live_out, def_[bb]);
+        }
+    }
+}
+
+void Liveness::number_values(Function *f) {
+    auto &values = values_[f];
+    values.clear();
+    auto add_value = [&](Value *val) {
+        value_id_[val] = values.size();
+        values.push_back(val);
+    };
+    for (auto &arg : f->get_args()) {
+        add_value(&arg);
+    }
+    for (auto &bb : f->get_basic_blocks()) {
+        for (auto &inst : bb.get_instructions()) {
+            if (not inst.is_void())
+                add_value(&inst);
+        }
+    }
+}
+
+void Liveness::compute_local(Function *f) {
+    unsigned size = get_num_values(f);
+    for (auto &bb1 : f->get_basic_blocks()) {
+        auto bb = &bb1;
+        BitVector use(size), def(size), phi_use(size);
+        for (auto &inst : bb->get_instructions()) {
+            // phi 的参数在前驱末尾使用，不计入本块的向上暴露使用
+            if (not inst.is_phi()) {
+                for (auto op : inst.get_operands()) {
+                    auto id = get_value_id(op);
+                    if (id >= 0 and not def.test(id))
+                        use.set(id);
+                }
+            }
+            auto id = get_value_id(&inst);
+            if (id >= 0)
+                def.set(id);
+        }
+        for (auto succ_bb : bb->get_succ_basic_blocks()) {
+            for (auto &inst : succ_bb->get_instructions()) {
+                if (not inst.is_phi())
+                    break;
+                for (auto [incoming, pre_bb] :
+                     static_cast<PhiInst *>(&inst)->get_phi_pairs()) {
+                    auto id = get_value_id(incoming);
+                    if (pre_bb == bb and id >= 0)
+                        phi_use.set(id);
+                }
+            }
+        }
+        use_[bb] = std::move(use);
+        def_[bb] = std::move(def);
+        phi_use_[bb] = std::move(phi_use);
+    }
+}
+
+bool Liveness::is_live_in(Value *val, BasicBlock *bb) {
+    auto id = get_value_id(val);
+    return id >= 0 and live_in_.at(bb).test(id);
+}
+
+bool Liveness::is_live_out(Value *val, BasicBlock *bb) {
+    auto id = get_value_id(val);
+    return id >= 0 and live_out_.at(bb).test(id);
+}
+
+void Liveness::step_backward(Instruction *inst, BitVector &live) {
+    auto id = get_value_id(inst);
+    if (id >= 0)
+        live.reset(id);
+    if (inst->is_phi())
+        return;
+    for (auto op : inst->get_operands()) {
+        auto op_id = get_value_id(op);
+        if (op_id >= 0)
+            live.set(op_id);
+    }
+}
+
+BitVector Liveness::get_live_after(Instruction *inst) {
+    auto bb = inst->get_parent();
+    auto live = live_out_.at(bb);
+    auto &instrs = bb->get_instructions();
+    for (auto it = instrs.rbegin(); &*it != inst; ++it) {
+        step_backward(&*it, live);
+    }
+    return live;
+}
+
+BitVector Liveness::get_live_before(Instruction *inst) {
+    auto live = get_live_after(inst);
+    step_backward(inst, live);
+    return live;
+}
+
+bool Liveness::is_live_after(Value *val, Instruction *inst) {
+    auto id = get_value_id(val);
+    return id >= 0 and get_live_after(inst).test(id);
+}
+
+bool Liveness::is_live_before(Value *val, Instruction *inst) {
+    auto id = get_value_id(val);
+    return id >= 0 and get_live_before(inst).test(id);
+}
+
+std::vector<Value *> Liveness::to_values(Function *f,
+                                         const BitVector &set) const {
+    std::vector<Value *> result;
+    auto &values = values_.at(f);
+    set.for_each([&](unsigned id) { result.push_back(values[id]); });
+    return result;
+}
+
+std::string Liveness::print(Function *f) {
+    std::string result;
+    auto print_set = [&](const BitVector &set) {
+        for (auto val : to_values(f, set)) {
+            result += " %" + val->get_name();
+        }
+    };
+    for (auto &bb : f->get_basic_blocks()) {
+        result += bb.get_name() + ":\n  live-in:";
+        print_set(live_in_.at(&bb));
+        result += "\n  live-out:";
+        print_set(live_out_.at(&bb));
+        result += "\n";
+    }
+    return result;
+}
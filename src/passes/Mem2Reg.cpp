@@ -14,146 +14,231 @@ void Mem2Reg::run() {
         if (f.is_declaration())
             continue;
         func_ = &f;
-        var_val_stack.clear();
-        phi_lval.clear();
+        phi_var_.clear();
         if (func_->get_basic_blocks().size() >= 1) {
             // 对应伪代码中 phi 指令插入的阶段
             generate_phi();
             // 对应伪代码中重命名阶段
-            rename(func_->get_entry_block());
+            rename();
         }
         // 后续 DeadCode 将移除冗余的局部变量的分配空间
     }
 }
 
+void Mem2Reg::number_vars() {
+    var_id_.clear();
+    vars_.clear();
+    bb_id_.clear();
+    bbs_.clear();
+    for (auto &bb : func_->get_basic_blocks()) {
+        bb_id_[&bb] = bbs_.size();
+        bbs_.push_back(&bb);
+        for (auto &instr : bb.get_instructions()) {
+            Value *l_val;
+            if (instr.is_store())
+                l_val = static_cast<StoreInst *>(&instr)->get_lval();
+            else if (instr.is_load())
+                l_val = static_cast<LoadInst *>(&instr)->get_lval();
+            else
+                continue;
+            if (is_valid_ptr(l_val) and not var_id_.count(l_val)) {
+                var_id_[l_val] = vars_.size();
+                vars_.push_back(l_val);
+            }
+        }
+    }
+}
+
+std::vector<BitVector>
+Mem2Reg::compute_live_in(const std::vector<BitVector> &upward_use,
+                         const std::vector<BitVector> &kill) {
+    // 逆向数据流，按块的逆序迭代到不动点
+    std::vector<BitVector> live_in(upward_use);
+    BitVector live_out(vars_.size());
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (unsigned i = bbs_.size(); i-- > 0;) {
+            live_out = BitVector(vars_.size());
+            for (auto succ_bb : bbs_[i]->get_succ_basic_blocks()) {
+                live_out.merge(live_in[bb_id_.at(succ_bb)]);
+            }
+            changed |=
+                live_in[i].assign_transfer(upward_use[i], live_out, kill[i]);
+        }
+    }
+    return live_in;
+}
+
 void Mem2Reg::generate_phi() {
     // global_live_var_name 是全局名字集合，以 alloca 出的局部变量来统计。
     // 步骤一：找到活跃在多个 block 的全局名字集合，以及它们所属的 bb 块
-    std::set<Value *> global_live_var_name;
-    std::map<Value *, std::set<BasicBlock *>> live_var_2blocks;
-    for (auto &bb : func_->get_basic_blocks()) {
-        std::set<Value *> var_is_killed;
-        for (auto &instr : bb.get_instructions()) {
-            if (instr.is_store()) {
+    // 只在块内先 store 后 load 的变量不需要 phi（semi-pruned SSA）
+    number_vars();
+    BitVector global_live_var_name(vars_.size());
+    std::vector<std::vector<unsigned>> live_var_2blocks(vars_.size());
+    std::vector<BitVector> upward_use, var_is_killed;
+    for (auto bb : bbs_) {
+        BitVector use(vars_.size()), killed(vars_.size());
+        for (auto &instr : bb->get_instructions()) {
+            if (instr.is_load()) {
+                auto l_val = static_cast<LoadInst *>(&instr)->get_lval();
+                if (is_valid_ptr(l_val)) {
+                    auto var = var_id_.at(l_val);
+                    if (not killed.test(var)) {
+                        global_live_var_name.set(var);
+                        use.set(var);
+                    }
+                }
+            } else if (instr.is_store()) {
                 // store i32 a, i32 *b
                 // a is r_val, b is l_val
                 auto l_val = static_cast<StoreInst *>(&instr)->get_lval();
                 if (is_valid_ptr(l_val)) {
-                    global_live_var_name.insert(l_val);
-                    live_var_2blocks[l_val].insert(&bb);
+                    auto var = var_id_.at(l_val);
+                    if (not killed.test(var))
+                        live_var_2blocks[var].push_back(bb_id_.at(bb));
+                    killed.set(var);
                 }
             }
         }
+        upward_use.push_back(std::move(use));
+        var_is_killed.push_back(std::move(killed));
     }
+    std::vector<BitVector> live_in;
+    if (pruned_)
+        live_in = compute_live_in(upward_use, var_is_killed);
 
     // 步骤二：从支配树获取支配边界信息，并在对应位置插入 phi 指令
-    std::map<std::pair<BasicBlock *, Value *>, bool>
-        bb_has_var_phi; // bb has phi for var
-    for (auto var : global_live_var_name) {
-        std::vector<BasicBlock *> work_list;
-        work_list.assign(live_var_2blocks[var].begin(),
-                         live_var_2blocks[var].end());
+    global_live_var_name.for_each([&](unsigned var) {
+        auto l_val = vars_[var];
+        BitVector bb_has_var_phi(bbs_.size()), in_work_list(bbs_.size());
+        std::vector<unsigned> work_list = live_var_2blocks[var];
+        for (auto bb : work_list) {
+            in_work_list.set(bb);
+        }
         for (unsigned i = 0; i < work_list.size(); i++) {
-            auto bb = work_list[i];
+            auto bb = bbs_[work_list[i]];
             for (auto bb_dominance_frontier_bb :
                  dominators_->get_dominance_frontier(bb)) {
-                if (bb_has_var_phi.find({bb_dominance_frontier_bb, var}) ==
-                    bb_has_var_phi.end()) {
-                    // generate phi for bb_dominance_frontier_bb & add
-                    // bb_dominance_frontier_bb to work list
-                    auto phi = PhiInst::create_phi(
-                        var->get_type()->get_pointer_element_type(),
-                        bb_dominance_frontier_bb);
-                    phi_lval.emplace(phi, var);
-                    bb_dominance_frontier_bb->add_instr_begin(phi);
-                    work_list.push_back(bb_dominance_frontier_bb);
-                    bb_has_var_phi[{bb_dominance_frontier_bb, var}] = true;
+                auto df_id = bb_id_.at(bb_dominance_frontier_bb);
+                if (bb_has_var_phi.test(df_id))
+                    continue;
+                // pruned SSA：变量在该块入口不活跃时 phi 必然无用
+                if (pruned_ and not live_in[df_id].test(var))
+                    continue;
+                // generate phi for bb_dominance_frontier_bb & add
+                // bb_dominance_frontier_bb to work list
+                auto phi = PhiInst::create_phi(
+                    l_val->get_type()->get_pointer_element_type(),
+                    bb_dominance_frontier_bb);
+                phi_var_.emplace(phi, var);
+                bb_dominance_frontier_bb->add_instr_begin(phi);
+                bb_has_var_phi.set(df_id);
+                if (not in_work_list.test(df_id)) {
+                    in_work_list.set(df_id);
+                    work_list.push_back(df_id);
                 }
             }
         }
-    }
+    });
 }
 
-void Mem2Reg::rename(BasicBlock *bb) {
+void Mem2Reg::rename() {
     // 步骤一：将 phi 指令作为 lval 的最新定值，lval 即是为局部变量
     // alloca出的地址空间 步骤二：用 lval 最新的定值替代对应的load指令
     // 步骤三：将store 指令的 rval，也即被存入内存的值，作为 lval 的最新定值
     // 步骤四：为lval 对应的 phi 指令参数补充完整
-    // 步骤五：对 bb在支配树上的所有后继节点，递归执行 re_name 操作
-    // 步骤六：pop出 lval的最新定值
-    // 步骤七：清除冗余的指令
+    // 步骤五：对 bb在支配树上的所有后继节点执行 rename 操作
+    // 步骤六：按撤销日志恢复进入 bb 之前各变量的定值
+    var_val_.assign(vars_.size(), nullptr);
+    undo_log_.clear();
+
+    struct Frame {
+        BasicBlock *bb;
+        Dominators::BBSet::const_iterator next_child;
+        size_t undo_mark;
+    };
+    std::vector<Frame> stack;
+    auto enter = [&](BasicBlock *bb) {
+        auto mark = undo_log_.size();
+        rename_block(bb);
+        stack.push_back(
+            {bb, dominators_->get_dom_tree_succ_blocks(bb).begin(), mark});
+    };
+    enter(func_->get_entry_block());
+    while (not stack.empty()) {
+        auto &frame = stack.back();
+        if (frame.next_child !=
+            dominators_->get_dom_tree_succ_blocks(frame.bb).end()) {
+            enter(*frame.next_child++);
+            continue;
+        }
+        // 步骤六：回滚 bb 中产生的定值
+        while (undo_log_.size() > frame.undo_mark) {
+            auto [var, old_val] = undo_log_.back();
+            var_val_[var] = old_val;
+            undo_log_.pop_back();
+        }
+        stack.pop_back();
+    }
+}
+
+void Mem2Reg::rename_block(BasicBlock *bb) {
     std::vector<Instruction *> wait_delete;
 
-    // 步骤三：将 phi 指令作为 lval 的最新定值，lval 即是为局部变量 alloca
-    // 出的地址空间
+    // 步骤一：将 phi 指令作为 lval 的最新定值
     for (auto &instr : bb->get_instructions()) {
-        if (instr.is_phi()) {
-            auto l_val = phi_lval.at(static_cast<PhiInst *>(&instr));
-            var_val_stack[l_val].push_back(&instr);
-        }
+        if (not instr.is_phi())
+            break;
+        auto it = phi_var_.find(static_cast<PhiInst *>(&instr));
+        if (it != phi_var_.end())
+            define(it->second, &instr);
     }
 
     for (auto &instr : bb->get_instructions()) {
-        // 步骤四：用 lval 最新的定值替代对应的load指令
+        // 步骤二：用 lval 最新的定值替代对应的load指令
         if (instr.is_load()) {
             auto l_val = static_cast<LoadInst *>(&instr)->get_lval();
             if (is_valid_ptr(l_val)) {
-                if (var_val_stack.find(l_val) != var_val_stack.end()) {
+                auto val = var_val_[var_id_.at(l_val)];
+                // 没有到达定值（未初始化的变量）时保留 load
+                if (val != nullptr) {
                     // 此处指令替换会维护 UD 链与 DU 链
-                    instr.replace_all_use_with(var_val_stack[l_val].back());
+                    instr.replace_all_use_with(val);
                     wait_delete.push_back(&instr);
                 }
             }
         }
-        // 步骤五：将 store 指令的 rval，也即被存入内存的值，作为 lval
+        // 步骤三：将 store 指令的 rval，也即被存入内存的值，作为 lval
         // 的最新定值
         if (instr.is_store()) {
             auto l_val = static_cast<StoreInst *>(&instr)->get_lval();
             auto r_val = static_cast<StoreInst *>(&instr)->get_rval();
             if (is_valid_ptr(l_val)) {
-                var_val_stack[l_val].push_back(r_val);
+                define(var_id_.at(l_val), r_val);
                 wait_delete.push_back(&instr);
             }
         }
     }
 
-    // 步骤六：为 lval 对应的 phi 指令参数补充完整
+    // 步骤四：为 lval 对应的 phi 指令参数补充完整
     for (auto succ_bb : bb->get_succ_basic_blocks()) {
         for (auto &instr : succ_bb->get_instructions()) {
-            if (instr.is_phi()) {
-                auto l_val = phi_lval.at(static_cast<PhiInst *>(&instr));
-                if (var_val_stack.find(l_val) != var_val_stack.end() &&
-                    var_val_stack[l_val].size() != 0) {
-                    static_cast<PhiInst *>(&instr)->add_phi_pair_operand(
-                        var_val_stack[l_val].back(), bb);
-                }
-                // 对于 phi 参数只有一个前驱定值的情况，将会输出 [ undef, bb ]
-                // 的参数格式
-            }
-        }
-    }
-
-    // 步骤七：对 bb 在支配树上的所有后继节点，递归执行 re_name 操作
-    for (auto dom_succ_bb : dominators_->get_dom_tree_succ_blocks(bb)) {
-        rename(dom_succ_bb);
-    }
-
-    // 步骤八：pop出 lval 的最新定值
-    for (auto &instr : bb->get_instructions()) {
-        if (instr.is_store()) {
-            auto l_val = static_cast<StoreInst *>(&instr)->get_lval();
-            if (is_valid_ptr(l_val)) {
-                var_val_stack[l_val].pop_back();
-            }
-        } else if (instr.is_phi()) {
-            auto l_val = phi_lval.at(static_cast<PhiInst *>(&instr));
-            if (var_val_stack.find(l_val) != var_val_stack.end()) {
-                var_val_stack[l_val].pop_back();
-            }
+            if (not instr.is_phi())
+                break;
+            auto phi = static_cast<PhiInst *>(&instr);
+            auto it = phi_var_.find(phi);
+            if (it == phi_var_.end())
+                continue;
+            // 对于 phi 参数只有一个前驱定值的情况，将会输出 [ undef, bb ]
+            // 的参数格式
+            if (auto val = var_val_[it->second])
+                phi->add_phi_pair_operand(val, bb);
         }
     }
 
-    // 清除冗余的指令
+    // 定值已记录在 var_val_ 中，被替换的 load 与 store 可以立即删除
     for (auto instr : wait_delete) {
         bb->erase_instr(instr);
     }
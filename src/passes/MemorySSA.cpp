@@ -0,0 +1,293 @@
+#include "MemorySSA.hpp"
+#include "Function.hpp"
+
+#include <climits>
+#include <set>
+
+void MemorySSA::run() {
+    func_info_->run();
+    alias_ = std::make_unique<AliasAnalysis>(m_);
+    alias_->run();
+    dominators_ = std::make_unique<Dominators>(m_);
+    dominators_->run();
+
+    accesses_.clear();
+    live_on_entry_.clear();
+    inst_access_.clear();
+    block_phi_.clear();
+    block_accesses_.clear();
+    clobber_cache_.clear();
+    visiting_.clear();
+    for (auto &f : m_->get_functions()) {
+        if (f.is_declaration())
+            continue;
+        run_on_func(&f);
+    }
+}
+
+void MemorySSA::run_on_func(Function *f) {
+    next_id_ = 0;
+    accesses_.emplace_back(std::make_unique<MemoryAccess>(
+        MemoryAccess::LiveOnEntry, f->get_entry_block(), next_id_++));
+    live_on_entry_[f] = accesses_.back().get();
+    create_accesses(f);
+    insert_phis(f);
+    rename(f);
+}
+
+bool MemorySSA::is_mem_def(Instruction *inst) {
+    if (inst->is_store())
+        return true;
+    if (inst->is_call()) {
+        // 运行时库函数（input/output/neg_idx_except）只做 IO，不访问程序内存
+        auto callee = dynamic_cast<Function *>(inst->get_operand(0));
+        if (callee and callee->is_declaration())
+            return false;
+        return callee == nullptr or not func_info_->is_pure_function(callee);
+    }
+    return false;
+}
+
+// 纯函数不读写非局部内存，因此只有 load 是内存使用
+bool MemorySSA::is_mem_use(Instruction *inst) { return inst->is_load(); }
+
+bool MemorySSA::clobbers(MemoryUseOrDef *def, Value *loc) {
+    auto inst = def->get_instruction();
+    if (inst->is_store())
+        return alias_->may_alias(static_cast<StoreInst *>(inst)->get_lval(),
+                                 loc);
+    return true;
+}
+
+void MemorySSA::create_accesses(Function *f) {
+    for (auto &bb : f->get_basic_blocks()) {
+        auto &accesses = block_accesses_[&bb];
+        for (auto &inst : bb.get_instructions()) {
+            MemoryAccess::AccessKind kind;
+            if (is_mem_def(&inst))
+                kind = MemoryAccess::Def;
+            else if (is_mem_use(&inst))
+                kind = MemoryAccess::Use;
+            else
+                continue;
+            auto access =
+                std::make_unique<MemoryUseOrDef>(kind, &inst, next_id_++);
+            inst_access_[&inst] = access.get();
+            accesses.push_back(access.get());
+            accesses_.push_back(std::move(access));
+        }
+    }
+}
+
+void MemorySSA::insert_phis(Function *f) {
+    // 与 Mem2Reg 相同：在所有定值块的迭代支配边界处放置 phi
+    std::vector<BasicBlock *> work_list;
+    for (auto &bb : f->get_basic_blocks()) {
+        for (auto access : block_accesses_[&bb]) {
+            if (access->is_def()) {
+                work_list.push_back(&bb);
+                break;
+            }
+        }
+    }
+    for (unsigned i = 0; i < work_list.size(); i++) {
+        auto bb = work_list[i];
+        for (auto df_bb : dominators_->get_dominance_frontier(bb)) {
+            if (block_phi_.count(df_bb))
+                continue;
+            auto phi = std::make_unique<MemoryPhi>(df_bb, next_id_++);
+            block_phi_[df_bb] = phi.get();
+            auto &accesses = block_accesses_[df_bb];
+            accesses.insert(accesses.begin(), phi.get());
+            accesses_.push_back(std::move(phi));
+            work_list.push_back(df_bb);
+        }
+    }
+}
+
+void MemorySSA::rename(Function *f) {
+    auto rename_block = [&](BasicBlock *bb, MemoryAccess *cur) {
+        for (auto access : block_accesses_[bb]) {
+            if (access->is_phi()) {
+                cur = access;
+                continue;
+            }
+            auto use_or_def = static_cast<MemoryUseOrDef *>(access);
+            use_or_def->set_defining_access(cur);
+            if (access->is_def())
+                cur = access;
+        }
+        for (auto succ_bb : bb->get_succ_basic_blocks()) {
+            if (auto phi = get_memory_phi(succ_bb))
+                phi->add_incoming(cur, bb);
+        }
+        return cur;
+    };
+
+    // 沿支配树先序遍历，显式栈中保存进入该块时的最新内存定值
+    std::set<BasicBlock *> visited;
+    std::vector<std::pair<BasicBlock *, MemoryAccess *>> stack;
+    stack.emplace_back(f->get_entry_block(), live_on_entry_.at(f));
+    while (not stack.empty()) {
+        auto [bb, cur] = stack.back();
+        stack.pop_back();
+        visited.insert(bb);
+        cur = rename_block(bb, cur);
+        for (auto dom_succ_bb : dominators_->get_dom_tree_succ_blocks(bb)) {
+            stack.emplace_back(dom_succ_bb, cur);
+        }
+    }
+
+    // 从入口不可达的块不在支配树上（例如两个分支都 return 的 if 之后的语句），
+    // 与 LLVM 一样让其中的访问从 liveOnEntry 开始，避免留下空的定值
+    for (auto &bb : f->get_basic_blocks()) {
+        if (not visited.count(&bb))
+            rename_block(&bb, live_on_entry_.at(f));
+    }
+}
+
+MemoryAccess *MemorySSA::get_clobbering_access(Instruction *inst) {
+    auto access = get_memory_access(inst);
+    if (access == nullptr)
+        return nullptr;
+    if (inst->is_load())
+        return get_clobbering_access(access->get_defining_access(),
+                                     static_cast<LoadInst *>(inst)->get_lval());
+    if (inst->is_store())
+        return get_clobbering_access(access->get_defining_access(),
+                                     static_cast<StoreInst *>(inst)->get_lval());
+    return access->get_defining_access();
+}
+
+MemoryAccess *MemorySSA::get_clobbering_access(MemoryAccess *start,
+                                               Value *loc) {
+    if (start == nullptr)
+        return nullptr;
+    unsigned low = UINT_MAX;
+    return walk(start, loc, low);
+}
+
+// 返回 nullptr 表示沿这条路径回到了正在求解的 MemoryPhi（环路上没有定值）；
+// low 记录结果所依赖的、仍在求解中的 phi 的最小深度，依赖未决时不缓存
+MemoryAccess *MemorySSA::walk(MemoryAccess *start, Value *loc,
+                              unsigned &low) {
+    std::vector<MemoryAccess *> path;
+    MemoryAccess *cur = start;
+    MemoryAccess *result = nullptr;
+    unsigned my_low = UINT_MAX;
+    while (true) {
+        auto it = clobber_cache_.find({cur, loc});
+        if (it != clobber_cache_.end()) {
+            result = it->second;
+            break;
+        }
+        if (cur->is_live_on_entry()) {
+            result = cur;
+            break;
+        }
+        if (cur->is_phi()) {
+            auto phi = static_cast<MemoryPhi *>(cur);
+            auto visiting = visiting_.find(phi);
+            if (visiting != visiting_.end()) {
+                my_low = std::min(my_low, visiting->second);
+                result = nullptr;
+            } else {
+                result = resolve_phi(phi, loc, my_low);
+            }
+            break;
+        }
+        auto def = static_cast<MemoryUseOrDef *>(cur);
+        if (clobbers(def, loc)) {
+            result = cur;
+            break;
+        }
+        path.push_back(cur);
+        cur = def->get_defining_access();
+        if (cur == nullptr)
+            break;
+    }
+
+    if (my_low == UINT_MAX) {
+        for (auto access : path)
+            clobber_cache_[{access, loc}] = result;
+    } else {
+        low = std::min(low, my_low);
+    }
+    return result;
+}
+
+MemoryAccess *MemorySSA::resolve_phi(MemoryPhi *phi, Value *loc,
+                                     unsigned &low) {
+    unsigned depth = visiting_.size();
+    visiting_[phi] = depth;
+    unsigned my_low = UINT_MAX;
+    MemoryAccess *result = nullptr;
+    bool conflict = false;
+    for (auto [access, pre_bb] : phi->get_incoming()) {
+        auto clobber = walk(access, loc, my_low);
+        if (clobber == nullptr)
+            continue;
+        if (result == nullptr) {
+            result = clobber;
+        } else if (result != clobber) {
+            conflict = true;
+            break;
+        }
+    }
+    visiting_.erase(phi);
+
+    // 各前驱给出的定值不一致时 phi 本身就是答案，这与环路假设无关
+    if (conflict or result == nullptr) {
+        clobber_cache_[{phi, loc}] = phi;
+        return phi;
+    }
+    if (my_low >= depth)
+        clobber_cache_[{phi, loc}] = result;
+    else
+        low = std::min(low, my_low);
+    return result;
+}
+
+std::string MemorySSA::access_name(MemoryAccess *access) {
+    if (access == nullptr)
+        return "null";
+    if (access->is_live_on_entry())
+        return "liveOnEntry";
+    return std::to_string(access->get_id());
+}
+
+std::string MemorySSA::print(Function *f) {
+    f->get_parent()->set_print_name();
+    std::string output;
+    for (auto &bb : f->get_basic_blocks()) {
+        output += bb.get_name() + ":\n";
+        if (auto phi = get_memory_phi(&bb)) {
+            output += "  ; " + access_name(phi) + " = MemoryPhi(";
+            bool first = true;
+            for (auto [access, pre_bb] : phi->get_incoming()) {
+                if (not first)
+                    output += ", ";
+                first = false;
+                output += "{" + pre_bb->get_name() + ", " +
+                          access_name(access) + "}";
+            }
+            output += ")\n";
+        }
+        for (auto &inst : bb.get_instructions()) {
+            if (auto access = get_memory_access(&inst)) {
+                if (access->is_def())
+                    output += "  ; " + access_name(access) + " = MemoryDef(";
+                else
+                    output += "  ; MemoryUse(";
+                output += access_name(access->get_defining_access()) + ")";
+                // load 另外给出 walker 跳过无关定值后真正的 clobber
+                if (access->is_use())
+                    output += " clobber=" +
+                              access_name(get_clobbering_access(&inst));
+                output += "\n";
+            }
+            output += "  " + inst.print() + "\n";
+        }
+    }
+    return output;
+}
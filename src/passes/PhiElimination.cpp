@@ -0,0 +1,236 @@
+#include "PhiElimination.hpp"
+#include "Function.hpp"
+#include "SimplifyCFG.hpp"
+#include "logging.hpp"
+
+#include <unordered_set>
+
+void PhiElimination::run() {
+    vreg_.clear();
+    vreg_type_.clear();
+    copies_.clear();
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        run_on_func(&func);
+    }
+    LOG_INFO << "phi elimination split " << split_count_ << " edges, coalesced "
+             << coalesced_count_ << " values, inserted " << copy_count_
+             << " copies";
+}
+
+void PhiElimination::run_on_func(Function *f) {
+    split_critical_edges(f);
+    liveness_.run_on_func(f);
+    coalesce(f);
+
+    // 以并查集的根为代表压缩编号
+    auto &types = vreg_type_[f];
+    types.clear();
+    std::unordered_map<int, int> root_vreg;
+    for (unsigned id = 0; id < liveness_.get_num_values(f); id++) {
+        auto root = find(id);
+        auto it = root_vreg.find(root);
+        if (it == root_vreg.end()) {
+            it = root_vreg.emplace(root, types.size()).first;
+            types.push_back(liveness_.get_value(f, root)->get_type());
+        }
+        vreg_[liveness_.get_value(f, id)] = it->second;
+    }
+
+    for (auto &bb : f->get_basic_blocks()) {
+        for (auto pre_bb : bb.get_pre_basic_blocks()) {
+            if (copies_.count(pre_bb))
+                continue;
+            std::vector<Copy> parallel;
+            for (auto &inst : bb.get_instructions()) {
+                if (not inst.is_phi())
+                    break;
+                // 同一前驱对应多个参数时（条件跳转的两个目标相同）取第一个；
+                // 没有参数的前驱上 phi 取 undef，不需要复制
+                for (auto [incoming, phi_bb] :
+                     static_cast<PhiInst *>(&inst)->get_phi_pairs()) {
+                    if (phi_bb != pre_bb)
+                        continue;
+                    auto dst = get_vreg(&inst);
+                    auto src = get_vreg(incoming);
+                    if (src == -1)
+                        parallel.push_back({dst, -1, incoming});
+                    else if (src != dst)
+                        parallel.push_back({dst, src});
+                    break;
+                }
+            }
+            if (not parallel.empty()) {
+                copies_[pre_bb] = sequentialize(parallel, vreg_type_.at(f));
+                copy_count_ += copies_[pre_bb].size();
+            }
+        }
+    }
+}
+
+void PhiElimination::split_critical_edges(Function *f) {
+    std::vector<std::pair<BasicBlock *, BasicBlock *>> edges;
+    for (auto &bb : f->get_basic_blocks()) {
+        if (bb.get_instructions().empty() or
+            not bb.get_instructions().front().is_phi())
+            continue;
+        std::unordered_set<BasicBlock *> pre_bbs;
+        for (auto pre_bb : bb.get_pre_basic_blocks()) {
+            std::unordered_set<BasicBlock *> succ_bbs(
+                pre_bb->get_succ_basic_blocks().begin(),
+                pre_bb->get_succ_basic_blocks().end());
+            if (succ_bbs.size() > 1 and pre_bbs.insert(pre_bb).second)
+                edges.emplace_back(pre_bb, &bb);
+        }
+    }
+
+    for (auto [pre_bb, bb] : edges) {
+        SimplifyCFG::split_edge(pre_bb, bb);
+    }
+    split_count_ += edges.size();
+}
+
+void PhiElimination::coalesce(Function *f) {
+    unsigned num_values = liveness_.get_num_values(f);
+    parent_.resize(num_values);
+    members_.assign(num_values, {});
+    for (unsigned id = 0; id < num_values; id++) {
+        parent_[id] = id;
+        members_[id].push_back(liveness_.get_value(f, id));
+    }
+
+    for (auto &bb : f->get_basic_blocks()) {
+        for (auto &inst : bb.get_instructions()) {
+            if (not inst.is_phi())
+                break;
+            for (auto [incoming, pre_bb] :
+                 static_cast<PhiInst *>(&inst)->get_phi_pairs()) {
+                auto id = liveness_.get_value_id(incoming);
+                if (id < 0)
+                    continue;
+                auto phi_root = find(liveness_.get_value_id(&inst));
+                auto root = find(id);
+                if (phi_root == root)
+                    continue;
+                // 两个集合中任意一对值冲突都不能合并
+                bool conflict = false;
+                for (auto a : members_[phi_root]) {
+                    for (auto b : members_[root]) {
+                        if (interfere(a, b)) {
+                            conflict = true;
+                            break;
+                        }
+                    }
+                    if (conflict)
+                        break;
+                }
+                if (conflict)
+                    continue;
+                parent_[root] = phi_root;
+                members_[phi_root].insert(members_[phi_root].end(),
+                                          members_[root].begin(),
+                                          members_[root].end());
+                members_[root].clear();
+                coalesced_count_++;
+            }
+        }
+    }
+}
+
+bool PhiElimination::interfere(Value *a, Value *b) {
+    auto inst_a = dynamic_cast<Instruction *>(a);
+    auto inst_b = dynamic_cast<Instruction *>(b);
+    // 形参都在入口定值；同一块中的 phi 同时定值，保守地认为冲突
+    if (inst_a == nullptr and inst_b == nullptr)
+        return true;
+    if (inst_a and inst_b and inst_a->is_phi() and inst_b->is_phi() and
+        inst_a->get_parent() == inst_b->get_parent())
+        return true;
+    return live_at_def(a, b) or live_at_def(b, a);
+}
+
+bool PhiElimination::live_at_def(Value *a, Value *b) {
+    auto inst = dynamic_cast<Instruction *>(b);
+    if (inst == nullptr) {
+        auto entry = static_cast<Argument *>(b)->get_parent()->get_entry_block();
+        return liveness_.is_live_in(a, entry);
+    }
+    if (inst->is_phi())
+        return liveness_.is_live_in(a, inst->get_parent());
+    return liveness_.is_live_after(a, inst);
+}
+
+std::vector<PhiElimination::Copy>
+PhiElimination::sequentialize(const std::vector<Copy> &parallel,
+                              std::vector<Type *> &types) {
+    // loc[a]：a 原来的值当前所在的寄存器；pred[b]：b 需要的值原来所在的寄存器
+    std::vector<Copy> result;
+    std::unordered_map<int, int> loc, pred;
+    std::vector<int> ready, todo;
+    for (auto &copy : parallel) {
+        if (copy.src == -1)
+            continue;
+        loc[copy.src] = copy.src;
+        pred[copy.dst] = copy.src;
+        todo.push_back(copy.dst);
+    }
+    // 不被其他复制读取的目标可以直接写入
+    for (auto &copy : parallel) {
+        if (copy.src != -1 and not loc.count(copy.dst))
+            ready.push_back(copy.dst);
+    }
+
+    while (not todo.empty()) {
+        while (not ready.empty()) {
+            auto b = ready.back();
+            ready.pop_back();
+            auto a = pred[b];
+            auto c = loc[a];
+            result.push_back({b, c});
+            loc[a] = b;
+            // a 原来的值已经有了副本，a 本身可以被覆盖
+            if (a == c and pred.count(a))
+                ready.push_back(a);
+        }
+        auto b = todo.back();
+        todo.pop_back();
+        // b 的原值仍然只在 b 中且 b 尚未写入，说明剩下的复制成环：
+        // 先把 b 存入临时寄存器。已经写入的目标（例如同一个源复制给多个
+        // phi 时）loc 中没有它自己或已指向别处，不需要临时寄存器
+        auto it = loc.find(b);
+        if (it != loc.end() and it->second == b) {
+            int tmp = types.size();
+            types.push_back(types[b]);
+            result.push_back({tmp, b});
+            it->second = tmp;
+            ready.push_back(b);
+        }
+    }
+
+    // 常量不占寄存器，最后写入不会破坏其他复制的源
+    for (auto &copy : parallel) {
+        if (copy.src == -1)
+            result.push_back(copy);
+    }
+    return result;
+}
+
+std::string PhiElimination::print(Function *f) {
+    std::string result;
+    for (auto &bb : f->get_basic_blocks()) {
+        auto &copies = get_copies(&bb);
+        if (copies.empty())
+            continue;
+        result += bb.get_name() + ":\n";
+        for (auto &copy : copies) {
+            result += "  v" + std::to_string(copy.dst) + " = ";
+            if (copy.src == -1)
+                result += copy.src_val->print();
+            else
+                result += "v" + std::to_string(copy.src);
+            result += "\n";
+        }
+    }
+    return result;
+}
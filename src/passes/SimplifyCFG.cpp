@@ -0,0 +1,267 @@
+#include "SimplifyCFG.hpp"
+#include "Constant.hpp"
+#include "logging.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
+void SimplifyCFG::run() {
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        while (run_on_func(&func))
+            ;
+    }
+    LOG_INFO << "simplify cfg pass changed " << changed_count_ << " times";
+}
+
+bool SimplifyCFG::run_on_func(Function *func) {
+    bool changed = remove_unreachable(func);
+    std::vector<BasicBlock *> bbs;
+    for (auto &bb : func->get_basic_blocks()) {
+        bbs.push_back(&bb);
+    }
+    // merge_into_pred 只会删除当前块，快照中其余的块仍然有效
+    for (auto bb : bbs) {
+        changed |= fold_branch(bb);
+        if (merge_into_pred(bb)) {
+            changed = true;
+            continue;
+        }
+        changed |= forward_empty_block(bb);
+    }
+    return changed;
+}
+
+void SimplifyCFG::redirect_edge(BasicBlock *pred, BasicBlock *old_succ,
+                                BasicBlock *new_succ) {
+    auto br = pred->get_terminator();
+    int edge_count = 0;
+    for (unsigned i = 0; i < br->get_num_operand(); i++) {
+        if (br->get_operand(i) == old_succ) {
+            br->set_operand(i, new_succ);
+            edge_count++;
+        }
+    }
+    old_succ->remove_pre_basic_block(pred);
+    pred->remove_succ_basic_block(old_succ);
+    for (int i = 0; i < edge_count; i++) {
+        pred->add_succ_basic_block(new_succ);
+        new_succ->add_pre_basic_block(pred);
+    }
+}
+
+BasicBlock *SimplifyCFG::split_edge(BasicBlock *pred, BasicBlock *succ) {
+    auto mid_bb =
+        BasicBlock::create(pred->get_module(), "", pred->get_parent());
+    redirect_edge(pred, succ, mid_bb);
+    BranchInst::create_br(succ, mid_bb);
+    // 新块沿用这条边的剖析计数
+    auto count = pred->get_edge_count(succ);
+    mid_bb->set_profile_count(count);
+    pred->set_edge_count(mid_bb, count);
+    mid_bb->set_edge_count(succ, count);
+    for (auto &inst : succ->get_instructions()) {
+        if (not inst.is_phi())
+            break;
+        for (unsigned i = 1; i < inst.get_num_operand(); i += 2) {
+            if (inst.get_operand(i) == pred)
+                inst.set_operand(i, mid_bb);
+        }
+    }
+    return mid_bb;
+}
+
+void SimplifyCFG::remove_phi_incoming(BasicBlock *bb, BasicBlock *pred) {
+    for (auto &inst : bb->get_instructions()) {
+        if (not inst.is_phi())
+            break;
+        static_cast<PhiInst *>(&inst)->remove_phi_operand(pred);
+    }
+}
+
+bool SimplifyCFG::remove_unreachable(Function *func) {
+    std::unordered_set<BasicBlock *> reachable;
+    std::vector<BasicBlock *> stack{func->get_entry_block()};
+    reachable.insert(func->get_entry_block());
+    while (not stack.empty()) {
+        auto bb = stack.back();
+        stack.pop_back();
+        for (auto succ_bb : bb->get_succ_basic_blocks()) {
+            if (reachable.insert(succ_bb).second)
+                stack.push_back(succ_bb);
+        }
+    }
+
+    std::vector<BasicBlock *> dead_bbs;
+    for (auto &bb : func->get_basic_blocks()) {
+        if (not reachable.count(&bb))
+            dead_bbs.push_back(&bb);
+    }
+    if (dead_bbs.empty())
+        return false;
+
+    // 每条出边对应后继 phi 中的一个参数
+    for (auto bb : dead_bbs) {
+        for (auto succ_bb : bb->get_succ_basic_blocks()) {
+            if (reachable.count(succ_bb))
+                remove_phi_incoming(succ_bb, bb);
+        }
+    }
+    // 不可达块中的值只会被不可达块使用，先断开全部使用关系再删除
+    for (auto bb : dead_bbs) {
+        for (auto &inst : bb->get_instructions()) {
+            inst.remove_all_operands();
+        }
+    }
+    for (auto bb : dead_bbs) {
+        bb->erase_from_parent();
+    }
+    changed_count_ += dead_bbs.size();
+    return true;
+}
+
+bool SimplifyCFG::fold_branch(BasicBlock *bb) {
+    if (not bb->is_terminated() or not bb->get_terminator()->is_br())
+        return false;
+    auto br = static_cast<BranchInst *>(bb->get_terminator());
+    if (not br->is_cond_br())
+        return false;
+    auto true_bb = static_cast<BasicBlock *>(br->get_operand(1));
+    auto false_bb = static_cast<BasicBlock *>(br->get_operand(2));
+    BasicBlock *target = nullptr;
+
+    if (true_bb == false_bb) {
+        // 两条边合为一条，phi 中来自 bb 的重复参数只保留一个
+        target = true_bb;
+        for (auto &inst : target->get_instructions()) {
+            if (not inst.is_phi())
+                break;
+            auto phi = static_cast<PhiInst *>(&inst);
+            auto pairs = phi->get_phi_pairs();
+            if (std::count_if(pairs.begin(), pairs.end(), [&](auto &pair) {
+                    return pair.second == bb;
+                }) > 1)
+                phi->remove_phi_operand(bb);
+        }
+    } else if (auto cond = dynamic_cast<ConstantInt *>(br->get_condition())) {
+        target = cond->get_value() ? true_bb : false_bb;
+        remove_phi_incoming(cond->get_value() ? false_bb : true_bb, bb);
+    } else {
+        return false;
+    }
+
+    bb->erase_instr(br);
+    BranchInst::create_br(target, bb);
+    changed_count_++;
+    return true;
+}
+
+bool SimplifyCFG::forward_empty_block(BasicBlock *bb) {
+    if (bb == bb->get_parent()->get_entry_block() or
+        bb->get_num_of_instr() != 1)
+        return false;
+    auto br = static_cast<BranchInst *>(bb->get_terminator());
+    if (not br->is_br() or br->is_cond_br())
+        return false;
+    auto succ_bb = static_cast<BasicBlock *>(br->get_operand(0));
+    if (succ_bb == bb)
+        return false;
+
+    std::vector<BasicBlock *> pre_bbs;
+    for (auto pre_bb : bb->get_pre_basic_blocks()) {
+        if (pre_bb != bb and
+            std::find(pre_bbs.begin(), pre_bbs.end(), pre_bb) == pre_bbs.end())
+            pre_bbs.push_back(pre_bb);
+    }
+    if (pre_bbs.empty())
+        return false;
+
+    // succ_bb 的 phi 在 bb 处取的值要改由各个前驱提供；
+    // 若前驱本来就是 succ_bb 的前驱，两条边上的取值必须一致
+    std::vector<PhiInst *> phis;
+    for (auto &inst : succ_bb->get_instructions()) {
+        if (not inst.is_phi())
+            break;
+        auto phi = static_cast<PhiInst *>(&inst);
+        phis.push_back(phi);
+        Value *bb_val = nullptr;
+        for (auto [val, pre_bb] : phi->get_phi_pairs()) {
+            if (pre_bb == bb)
+                bb_val = val;
+        }
+        for (auto [val, pre_bb] : phi->get_phi_pairs()) {
+            if (pre_bb != bb and
+                std::find(pre_bbs.begin(), pre_bbs.end(), pre_bb) !=
+                    pre_bbs.end() and
+                val != bb_val)
+                return false;
+        }
+    }
+
+    for (auto pre_bb : pre_bbs) {
+        auto edge_count =
+            std::count(pre_bb->get_succ_basic_blocks().begin(),
+                       pre_bb->get_succ_basic_blocks().end(), bb);
+        redirect_edge(pre_bb, bb, succ_bb);
+        for (auto phi : phis) {
+            for (auto [val, phi_bb] : phi->get_phi_pairs()) {
+                if (phi_bb != bb)
+                    continue;
+                for (int i = 0; i < edge_count; i++)
+                    phi->add_phi_pair_operand(val, pre_bb);
+                break;
+            }
+        }
+    }
+    // bb 已没有前驱，phi 中来自它的参数在删除不可达块时一并清除
+    changed_count_++;
+    return true;
+}
+
+bool SimplifyCFG::merge_into_pred(BasicBlock *bb) {
+    if (bb == bb->get_parent()->get_entry_block() or
+        bb->get_pre_basic_blocks().size() != 1)
+        return false;
+    auto pred = bb->get_pre_basic_blocks().front();
+    if (pred == bb)
+        return false;
+    auto br = static_cast<BranchInst *>(pred->get_terminator());
+    if (br->is_cond_br())
+        return false;
+
+    std::vector<PhiInst *> phis;
+    for (auto &inst : bb->get_instructions()) {
+        if (not inst.is_phi())
+            break;
+        if (inst.get_num_operand() != 2)
+            return false;
+        phis.push_back(static_cast<PhiInst *>(&inst));
+    }
+    for (auto phi : phis) {
+        phi->replace_all_use_with(phi->get_operand(0));
+        bb->erase_instr(phi);
+    }
+
+    pred->erase_instr(br);
+    auto &instrs = bb->get_instructions();
+    while (not instrs.empty()) {
+        auto inst = &instrs.front();
+        bb->remove_instr(inst);
+        inst->set_parent(pred);
+        pred->add_instruction(inst);
+    }
+
+    for (auto succ_bb : bb->get_succ_basic_blocks()) {
+        auto &succ_pre_bbs = succ_bb->get_pre_basic_blocks();
+        std::replace(succ_pre_bbs.begin(), succ_pre_bbs.end(), bb, pred);
+    }
+    pred->get_succ_basic_blocks() = bb->get_succ_basic_blocks();
+    // 后继 phi 中以 bb 为来源的参数改为 pred
+    bb->replace_all_use_with(pred);
+    bb->reset();
+    bb->erase_from_parent();
+    changed_count_++;
+    return true;
+}
@@ -0,0 +1,29 @@
+#!/usr/bin/env python3
+# 运行一条命令，把它的标准输出与期望文件逐字比较，不同时打印 diff 并返回 1，由 ctest 调用：
+#   check_output.py <expected-file> <command...>
+import difflib
+import subprocess
+import sys
+
+
+def check(expected_path, cmd):
+    result = subprocess.run(cmd, stdout=subprocess.PIPE, timeout=60)
+    actual = result.stdout.decode()
+    with open(expected_path) as fexp:
+        expected = fexp.read()
+    if result.returncode != 0:
+        print("command exited with %d: %s" % (result.returncode, " ".join(cmd)))
+        return 1
+    if actual != expected:
+        sys.stdout.writelines(difflib.unified_diff(
+            expected.splitlines(True), actual.splitlines(True),
+            expected_path, "actual"))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 3:
+        print("usage: check_output.py <expected-file> <command...>")
+        sys.exit(2)
+    sys.exit(check(sys.argv[1], sys.argv[2:]))
@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+# 用 cminusfc 的 -run/-interpret 在进程内执行 autogen 测试用例，逐个与 answers 比较，
+# 不需要 clang 与 cminus_io 库，由 ctest 调用：
+#   eval_driver.py <cminusfc> <cminusfc 选项...>
+# 给出 --link <cc> <libcminus_io> 时改为用 -S 生成汇编，链接后执行本机代码：
+#   eval_driver.py <cminusfc> --link <cc> <libcminus_io> <cminusfc 选项...>
+# 任何一个用例失败时返回 1
+import os
+import subprocess
+import sys
+import tempfile
+
+BASE_PATH = os.path.dirname(os.path.abspath(__file__))
+TEST_BASE_PATH = os.path.join(BASE_PATH, "testcases")
+ANSWER_BASE_PATH = os.path.join(BASE_PATH, "answers")
+
+
+# 生成汇编并链接成可执行文件，返回运行它的命令；失败时返回出错原因
+def build_native(exe_path, opt_flags, source, link, work_dir):
+    cc, io_lib = link
+    asm = os.path.join(work_dir, "case.s")
+    binary = os.path.join(work_dir, "case")
+    result = subprocess.run([exe_path, "-S"] + opt_flags +
+                            ["-o", asm, source], stderr=subprocess.PIPE,
+                            timeout=10)
+    if result.returncode != 0:
+        return None, "compile failed"
+    result = subprocess.run([cc, "-no-pie", asm, io_lib, "-o", binary],
+                            stderr=subprocess.PIPE, timeout=30)
+    if result.returncode != 0:
+        return None, "link failed"
+    return [binary], None
+
+
+def eval(exe_path, opt_flags, link=None):
+    work_dir = tempfile.mkdtemp() if link else None
+    failed = []
+    total = 0
+    for level_name in sorted(os.listdir(TEST_BASE_PATH)):
+        level_path = os.path.join(TEST_BASE_PATH, level_name)
+        for name in sorted(os.listdir(level_path)):
+            if not name.endswith(".cminus"):
+                continue
+            case = name[:-len(".cminus")]
+            answer_path = os.path.join(ANSWER_BASE_PATH, level_name, case)
+            if not os.path.exists(answer_path + ".out"):
+                continue
+            total += 1
+
+            input_option = b""
+            if os.path.exists(answer_path + ".in"):
+                with open(answer_path + ".in", "rb") as fin:
+                    input_option = fin.read()
+            source = os.path.join(level_path, name)
+            if link:
+                cmd, reason = build_native(exe_path, opt_flags, source, link,
+                                           work_dir)
+                if cmd is None:
+                    failed.append((level_name, case, reason))
+                    continue
+            else:
+                cmd = [exe_path] + opt_flags + [source]
+            try:
+                result = subprocess.run(cmd, input=input_option,
+                                        stdout=subprocess.PIPE,
+                                        stderr=subprocess.PIPE, timeout=10)
+            except subprocess.TimeoutExpired:
+                failed.append((level_name, case, "timeout"))
+                continue
+            if result.returncode < 0:
+                failed.append((level_name, case,
+                               "killed by signal %d" % -result.returncode))
+                continue
+            with open(answer_path + ".out", "rb") as fout:
+                if result.stdout != fout.read():
+                    failed.append((level_name, case, "wrong output"))
+
+    if work_dir:
+        for name in os.listdir(work_dir):
+            os.unlink(os.path.join(work_dir, name))
+        os.rmdir(work_dir)
+    for level_name, case, reason in failed:
+        print("%s/%s: %s" % (level_name, case, reason))
+    print("%d/%d passed with: %s" %
+          (total - len(failed), total,
+           " ".join((["-S"] if link else []) + opt_flags)))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print("usage: eval_driver.py <cminusfc> [--link <cc> <libcminus_io>] "
+              "[options...]")
+        sys.exit(2)
+    if sys.argv[2:3] == ["--link"]:
+        if len(sys.argv) < 5:
+            print("usage: eval_driver.py <cminusfc> --link <cc> <libcminus_io> "
+                  "[options...]")
+            sys.exit(2)
+        sys.exit(eval(sys.argv[1], sys.argv[5:], (sys.argv[3], sys.argv[4])))
+    sys.exit(eval(sys.argv[1], sys.argv[2:]))
@@ -116,10 +116,22 @@ def eval():
         for arg in sys.argv[1:]:
             if arg == "dce":
                 opt_flags.append("-dce")
+            elif arg == "adce":
+                opt_flags.append("-adce")
             elif arg == "func-inline":
                 opt_flags.append("-func-inline")
             elif arg == "const-prop":
                 opt_flags.append("-const-prop")
+            elif arg == "mem2reg":
+                opt_flags.append("-mem2reg")
+            elif arg == "pruned-ssa":
+                opt_flags.append("-pruned-ssa")
+            elif arg == "instcombine":
+                opt_flags.append("-instcombine")
+            elif arg == "simplifycfg":
+                opt_flags.append("-simplifycfg")
+            elif arg == "jump-threading":
+                opt_flags.append("-jump-threading")
 
     f = open("eval_result", 'w')
     EXE_PATH = "../../../build/cminusfc"
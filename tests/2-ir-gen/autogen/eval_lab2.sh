@@ -6,8 +6,14 @@ show_usage() {
     echo "Options:"
     echo "  none        - Run without optimization"
     echo "  dce         - Run with Dead Code Elimination"
+    echo "  adce        - Make Dead Code Elimination aggressive (needs dce)"
     echo "  func-inline - Run with Function Inline"
     echo "  const-prop  - Run with Constant Propagation"
+    echo "  mem2reg     - Run with Mem2Reg"
+    echo "  pruned-ssa  - Build pruned SSA in Mem2Reg (needs mem2reg)"
+    echo "  instcombine - Run with Instruction Combine"
+    echo "  simplifycfg - Run with CFG Simplification"
+    echo "  jump-threading - Run with Jump Threading"
     echo "Example:"
     echo "  $0 dce func-inline      - Run with both DCE and Function Inline"
     echo "  $0 dce const-prop       - Run with both DCE and Constant Propagation"
@@ -26,7 +32,7 @@ fi
 opts=""
 for arg in "$@"; do
     case $arg in
-        "dce"|"func-inline"|"const-prop")
+        "dce"|"adce"|"func-inline"|"const-prop"|"mem2reg"|"pruned-ssa"|"instcombine"|"simplifycfg"|"jump-threading")
             opts="$opts $arg"
             ;;
         *)
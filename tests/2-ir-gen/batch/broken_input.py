@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+# 批量编译时某个输入打不开或有语法错误，其余文件照常生成输出，
+# 整体以非零值退出且不被信号终止，由 ctest 调用：
+#   broken_input.py <cminusfc> [cminusfc 选项...]
+import os
+import subprocess
+import sys
+import tempfile
+
+GOOD = "int main(void) {\n    output(1);\n    return 0;\n}\n"
+SYNTAX_ERROR = "int main(void) {\n    output(1)\n    return 0;\n}\n"
+
+
+def run(exe_path, opt_flags):
+    with tempfile.TemporaryDirectory() as work_dir:
+        inputs = []
+        for name, source in [("a", GOOD), ("broken", SYNTAX_ERROR),
+                             ("b", GOOD), ("missing", None), ("c", GOOD)]:
+            path = os.path.join(work_dir, name + ".cminus")
+            if source is not None:
+                with open(path, "w") as fsrc:
+                    fsrc.write(source)
+            inputs.append(path)
+        # 输出写在当前目录下
+        result = subprocess.run([os.path.abspath(exe_path), "-emit-llvm"] +
+                                opt_flags + inputs, cwd=work_dir,
+                                stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                                timeout=60)
+        if result.returncode < 0:
+            print("killed by signal %d" % -result.returncode)
+            return 1
+        if result.returncode == 0:
+            print("expected a nonzero exit code")
+            return 1
+        missing = [name for name in ["a", "b", "c"] if not os.path.exists(
+            os.path.join(work_dir, name + ".ll"))]
+        if missing:
+            print("no output for: %s" % " ".join(missing))
+            return 1
+        for name in ["broken", "missing"]:
+            if (name + ".cminus: compilation failed").encode() not in \
+                    result.stderr:
+                print("%s was not reported as failed" % name)
+                return 1
+    return 0
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print("usage: broken_input.py <cminusfc> [options...]")
+        sys.exit(2)
+    sys.exit(run(sys.argv[1], sys.argv[2:]))
@@ -0,0 +1,60 @@
+// PhiElimination::sequentialize 的单元检查：顺序执行给出的复制后，每个目标
+// 得到的必须是并行复制前源中的值，并且只在确有环时使用临时虚拟寄存器
+#include "PhiElimination.hpp"
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using Copy = PhiElimination::Copy;
+
+int check(const std::string &name, const std::vector<Copy> &parallel,
+          int num_vregs, unsigned expected_copies, int expected_temps) {
+    std::vector<Type *> types(num_vregs, nullptr);
+    auto copies = PhiElimination::sequentialize(parallel, types);
+
+    // 每个寄存器的初值是它自己的编号
+    std::unordered_map<int, int> regs;
+    for (int vreg = 0; vreg < num_vregs; vreg++)
+        regs[vreg] = vreg;
+    for (auto &copy : copies)
+        regs[copy.dst] = regs.at(copy.src);
+
+    int failed = 0;
+    for (auto &copy : parallel) {
+        if (regs.at(copy.dst) != copy.src) {
+            std::cout << name << ": v" << copy.dst << " = v"
+                      << regs.at(copy.dst) << ", expected v" << copy.src
+                      << std::endl;
+            failed = 1;
+        }
+    }
+    int temps = types.size() - num_vregs;
+    if (copies.size() != expected_copies or temps != expected_temps) {
+        std::cout << name << ": " << copies.size() << " copies and " << temps
+                  << " temporaries, expected " << expected_copies << " and "
+                  << expected_temps << std::endl;
+        failed = 1;
+    }
+    return failed;
+}
+
+} // namespace
+
+int main() {
+    int failed = 0;
+    // 同一个源复制给多个目标：{v0 = v2, v1 = v2}
+    failed |= check("fan-out", {{0, 2}, {1, 2}}, 3, 2, 0);
+    // 交换：{v0 = v1, v1 = v0}
+    failed |= check("swap", {{0, 1}, {1, 0}}, 2, 3, 1);
+    // 三个寄存器轮换：{v0 = v1, v1 = v2, v2 = v0}
+    failed |= check("3-cycle", {{0, 1}, {1, 2}, {2, 0}}, 3, 4, 1);
+    // 链：{v0 = v1, v1 = v2}，先写 v0 即可
+    failed |= check("chain", {{0, 1}, {1, 2}}, 3, 2, 0);
+    // 环上的值同时被复制到环外：{v0 = v1, v1 = v0, v2 = v0}
+    failed |= check("cycle-fan-out", {{0, 1}, {1, 0}, {2, 0}}, 3, 3, 0);
+    return failed;
+}
@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+# 生成控制流或调用很深的程序，在受限的栈空间（1 MiB）下用 cminusfc 执行，
+# 检查编译器与解释器不会因递归耗尽栈，由 ctest 调用：
+#   deep_programs.py <cminusfc> <case> [cminusfc 选项...]
+import os
+import resource
+import subprocess
+import sys
+import tempfile
+
+STACK_LIMIT = 1 << 20
+
+
+# 5000 条顺序的 if，mem2reg 后支配树是一条长链；开头的 f == 1 可以线程化，
+# y 在被线程化的块中定值并在最后使用，要求 jump-threading 跨过整条链重建 SSA
+def sequential_if():
+    lines = ["int main(void) {", "    int x;", "    int f;", "    int y;",
+             "    x = input();", "    f = 0;", "    if (x > 0) f = 1;",
+             "    y = x + f;", "    if (f == 1) x = x - 1;"]
+    x = 7000
+    y = x + 1
+    x = x - 1
+    for i in range(5000):
+        lines.append("    if (x > %d) x = x - 1;" % i)
+        if x > i:
+            x = x - 1
+    lines += ["    output(x);", "    output(y);", "    return 0;", "}"]
+    return "\n".join(lines) + "\n", "7000\n", "%d\n%d\n" % (x, y)
+
+
+# 递归深度 50000，解释器的调用不能占用本机栈
+def deep_recursion():
+    source = """int depth(int n) {
+    if (n == 0) return 0;
+    return depth(n - 1) + 1;
+}
+int main(void) {
+    output(depth(input()));
+    return 0;
+}
+"""
+    return source, "50000\n", "50000\n"
+
+
+CASES = {
+    "sequential-if": sequential_if,
+    "deep-recursion": deep_recursion,
+}
+
+
+def limit_stack():
+    resource.setrlimit(resource.RLIMIT_STACK, (STACK_LIMIT, STACK_LIMIT))
+
+
+def run(exe_path, case, opt_flags):
+    source, stdin, expected = CASES[case]()
+    with tempfile.NamedTemporaryFile("w", suffix=".cminus",
+                                     delete=False) as fsrc:
+        fsrc.write(source)
+    try:
+        result = subprocess.run([exe_path] + opt_flags + [fsrc.name],
+                                input=stdin.encode(), stdout=subprocess.PIPE,
+                                preexec_fn=limit_stack, timeout=60)
+    finally:
+        os.unlink(fsrc.name)
+    if result.returncode < 0:
+        print("%s: killed by signal %d" % (case, -result.returncode))
+        return 1
+    if result.stdout.decode() != expected:
+        print("%s: expected %r, got %r" %
+              (case, expected, result.stdout.decode()))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 3 or sys.argv[2] not in CASES:
+        print("usage: deep_programs.py <cminusfc> <%s> [options...]" %
+              "|".join(CASES))
+        sys.exit(2)
+    sys.exit(run(sys.argv[1], sys.argv[2], sys.argv[3:]))
@@ -90,10 +90,11 @@ syntax_tree *parse(const char *input_path) {
 }
 
 syntax_tree_node *node(const char *name, int children_num, ...) {
-    syntax_tree_node *p = new_syntax_tree_node(name);
+    syntax_tree_node *p =
+        new_syntax_tree_node(gt, name, children_num ? children_num : 1);
     syntax_tree_node *child;
     if (children_num == 0) {
-        child = new_syntax_tree_node("epsilon");
+        child = new_syntax_tree_node(gt, "epsilon", 0);
         syntax_tree_add_child(p, child);
     } else {
         va_list ap;
@@ -0,0 +1,124 @@
+#include "bench.hpp"
+#include "CodeGen.hpp"
+#include "ast.hpp"
+#include "cminusf_builder.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/resource.h>
+#include <unistd.h>
+
+std::unique_ptr<Module> build_module(const std::string &source) {
+    auto tree = parse_buffer(source.data(), source.size());
+    AST ast(tree);
+    CminusfBuilder builder;
+    ast.run_visitor(builder);
+    return builder.getModule();
+}
+
+std::string var_name(int i) {
+    std::string name = "v";
+    do {
+        name += char('a' + i % 26);
+        i /= 26;
+    } while (i);
+    return name;
+}
+
+double time_ms(const std::function<void()> &fn, int repeat,
+               const std::function<void()> &setup) {
+    double best = 0;
+    for (int i = 0; i < repeat; i++) {
+        if (setup)
+            setup();
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        if (i == 0 or elapsed.count() < best)
+            best = elapsed.count();
+    }
+    return best;
+}
+
+double cpu_time_ms(const std::function<void()> &fn) {
+    auto cpu_ms = [] {
+        double total = 0;
+        for (auto who : {RUSAGE_SELF, RUSAGE_CHILDREN}) {
+            rusage usage;
+            getrusage(who, &usage);
+            total += (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e3 +
+                     (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e3;
+        }
+        return total;
+    };
+    double start = cpu_ms();
+    fn();
+    return cpu_ms() - start;
+}
+
+std::string capture_stdout(const std::function<void()> &fn) {
+    char path[] = "/tmp/cminusf_bench.stdout.XXXXXX";
+    int fd = mkstemp(path);
+    std::fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    dup2(fd, STDOUT_FILENO);
+    fn();
+    std::fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    close(fd);
+    auto output = read_file(path);
+    unlink(path);
+    return output;
+}
+
+std::string read_file(const std::filesystem::path &path) {
+    std::ifstream in(path);
+    std::ostringstream out;
+    out << in.rdbuf();
+    return out.str();
+}
+
+std::filesystem::path make_scratch_dir() {
+    auto dir = std::filesystem::temp_directory_path() /
+               ("cminusf_bench." + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+std::filesystem::path build_native(Module *m, bool regalloc,
+                                   const std::filesystem::path &dir,
+                                   const std::string &name) {
+    CodeGen codegen(m, regalloc);
+    codegen.run();
+
+    auto asm_path = dir / (name + ".s");
+    auto exe_path = dir / name;
+    std::ofstream(asm_path) << codegen.print();
+    auto cmd = std::string(BENCH_CC) + " -o " + exe_path.string() + " " +
+               asm_path.string() + " " + CMINUS_IO_LIB;
+    if (std::system(cmd.c_str()) != 0) {
+        std::cerr << "failed to link " << asm_path << std::endl;
+        std::exit(1);
+    }
+    return exe_path;
+}
+
+void run_native(const std::filesystem::path &exe,
+                const std::filesystem::path &out_path) {
+    auto cmd = exe.string() + " > " + out_path.string();
+    if (std::system(cmd.c_str()) != 0) {
+        std::cerr << exe << " failed" << std::endl;
+        std::exit(1);
+    }
+}
+
+void report(const std::string &name, const std::string &fields) {
+    std::cout << name << ": " << fields << std::endl;
+}
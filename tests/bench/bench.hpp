@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Module.hpp"
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+
+/**
+ * 基准测试的公共部分：由生成的 cminus 源代码建立模块、计时与输出结果
+ *
+ * 每个基准测试自己生成输入（规模写在输出中），不依赖外部文件，
+ * 由 cminusf_bench <name>... 运行，不带参数时运行全部
+ */
+
+// 解析 source 并生成 lightir 模块，不运行任何 pass
+std::unique_ptr<Module> build_module(const std::string &source);
+
+// cminus 的标识符只能由字母组成，把序号 i 写成 "v" 加上若干小写字母
+std::string var_name(int i);
+
+// 运行 repeat 次 fn，返回单次的最短用时（毫秒）；setup 在每次计时前运行，不计入用时
+double time_ms(const std::function<void()> &fn, int repeat = 3,
+               const std::function<void()> &setup = nullptr);
+
+// 运行一次 fn，返回本进程与其间结束的子进程消耗的 CPU 时间（毫秒）
+double cpu_time_ms(const std::function<void()> &fn);
+
+// 运行 fn，返回其间写到标准输出的内容（在文件描述符一级重定向）
+std::string capture_stdout(const std::function<void()> &fn);
+
+std::string read_file(const std::filesystem::path &path);
+
+// 在临时目录下建立本进程专用的目录，用完由调用者删除
+std::filesystem::path make_scratch_dir();
+
+// 把 m 编译为 x86-64 汇编（-S，regalloc 对应 -regalloc），用宿主 C 编译器
+// 与 cminus_io 链接为 dir/name，返回可执行文件的路径
+std::filesystem::path build_native(Module *m, bool regalloc,
+                                   const std::filesystem::path &dir,
+                                   const std::string &name);
+// 运行 exe，标准输出写入 out_path，失败时退出
+void run_native(const std::filesystem::path &exe,
+                const std::filesystem::path &out_path);
+
+// 输出一行结果：名称、规模说明与若干 "键=值"
+void report(const std::string &name, const std::string &fields);
+
+void bench_liveness();
+void bench_mem2reg();
+void bench_regalloc();
+void bench_interpreter();
+void bench_lexing();
+void bench_parse_tree();
@@ -0,0 +1,375 @@
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "DeadCode.hpp"
+#include "Function.hpp"
+#include "GlobalVariable.hpp"
+#include "Instruction.hpp"
+#include "Interpreter.hpp"
+#include "Mem2Reg.hpp"
+#include "bench.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+// 比较 -interpret 的字节码解释器、直接遍历 lightir 指令的朴素求值器
+// 与 -S 生成的本机代码（全部溢出，相当于 -O0）的运行时间
+namespace {
+
+union Slot {
+    int32_t i;
+    float f;
+    char *p;
+};
+
+/**
+ * 朴素的求值器：沿 BasicBlock 的指令链表逐条执行，按指令类型分派，
+ * 值存放在以 Value * 为键的哈希表中，函数调用递归进入 eval，
+ * 即字节码解释器所要避免的做法
+ */
+class NaiveEvaluator {
+  public:
+    explicit NaiveEvaluator(Module *m) : m_(m) {
+        for (auto &gv : m->get_global_variable()) {
+            // cminus 的全局变量都初始化为 0
+            auto size = gv.get_type()->get_pointer_element_type()->get_size();
+            globals_.emplace_back(size, 0);
+            global_addr_[&gv] = globals_.back().data();
+        }
+    }
+
+    void run() {
+        for (auto &func : m_->get_functions()) {
+            if (func.get_name() == "main")
+                eval(&func, {});
+        }
+        std::fflush(stdout);
+    }
+
+  private:
+    struct Frame {
+        std::unordered_map<Value *, Slot> values;
+        std::vector<std::vector<char>> allocas;
+    };
+
+    Slot get(Frame &frame, Value *val) {
+        auto it = frame.values.find(val);
+        if (it != frame.values.end())
+            return it->second;
+        Slot slot{};
+        if (auto const_int = dynamic_cast<ConstantInt *>(val))
+            slot.i = const_int->get_value();
+        else if (auto const_fp = dynamic_cast<ConstantFP *>(val))
+            slot.f = const_fp->get_value();
+        else
+            slot.p = global_addr_.at(val);
+        return slot;
+    }
+
+    Slot eval(Function *f, const std::vector<Slot> &args) {
+        Frame frame;
+        unsigned arg_no = 0;
+        for (auto &arg : f->get_args()) {
+            frame.values[&arg] = args[arg_no++];
+        }
+        BasicBlock *prev = nullptr;
+        BasicBlock *bb = f->get_entry_block();
+        std::vector<std::pair<Value *, Slot>> phi_values;
+        while (true) {
+            // phi 按前驱同时取值
+            phi_values.clear();
+            for (auto &inst : bb->get_instructions()) {
+                if (not inst.is_phi())
+                    break;
+                for (auto [incoming, pre_bb] :
+                     static_cast<PhiInst *>(&inst)->get_phi_pairs()) {
+                    if (pre_bb == prev)
+                        phi_values.emplace_back(&inst, get(frame, incoming));
+                }
+            }
+            for (auto [phi, val] : phi_values) {
+                frame.values[phi] = val;
+            }
+
+            BasicBlock *next = nullptr;
+            for (auto &inst1 : bb->get_instructions()) {
+                auto inst = &inst1;
+                auto op = [&](unsigned i) {
+                    return get(frame, inst->get_operand(i));
+                };
+                Slot result{};
+                switch (inst->get_instr_type()) {
+                case Instruction::ret:
+                    if (inst->get_num_operand() == 0)
+                        return {};
+                    return op(0);
+                case Instruction::br:
+                    if (static_cast<BranchInst *>(inst)->is_cond_br())
+                        next = inst->get_operand(op(0).i ? 1 : 2)
+                                   ->as<BasicBlock>();
+                    else
+                        next = inst->get_operand(0)->as<BasicBlock>();
+                    break;
+                case Instruction::add:
+                    result.i = uint32_t(op(0).i) + uint32_t(op(1).i);
+                    break;
+                case Instruction::sub:
+                    result.i = uint32_t(op(0).i) - uint32_t(op(1).i);
+                    break;
+                case Instruction::mul:
+                    result.i = uint32_t(op(0).i) * uint32_t(op(1).i);
+                    break;
+                case Instruction::sdiv:
+                    result.i = op(0).i / op(1).i;
+                    break;
+                case Instruction::shl:
+                    result.i = uint32_t(op(0).i) << (op(1).i & 31);
+                    break;
+                case Instruction::ashr:
+                    result.i = op(0).i >> (op(1).i & 31);
+                    break;
+                case Instruction::lshr:
+                    result.i = uint32_t(op(0).i) >> (op(1).i & 31);
+                    break;
+                case Instruction::fadd:
+                    result.f = op(0).f + op(1).f;
+                    break;
+                case Instruction::fsub:
+                    result.f = op(0).f - op(1).f;
+                    break;
+                case Instruction::fmul:
+                    result.f = op(0).f * op(1).f;
+                    break;
+                case Instruction::fdiv:
+                    result.f = op(0).f / op(1).f;
+                    break;
+                case Instruction::alloca:
+                    frame.allocas.emplace_back(
+                        static_cast<AllocaInst *>(inst)
+                            ->get_alloca_type()
+                            ->get_size());
+                    result.p = frame.allocas.back().data();
+                    break;
+                case Instruction::load:
+                    std::memcpy(&result, op(0).p,
+                                inst->get_type()->is_pointer_type() ? 8 : 4);
+                    break;
+                case Instruction::store: {
+                    auto val = op(0);
+                    std::memcpy(op(1).p, &val,
+                                inst->get_operand(0)
+                                        ->get_type()
+                                        ->is_pointer_type()
+                                    ? 8
+                                    : 4);
+                    break;
+                }
+                case Instruction::ge:
+                    result.i = op(0).i >= op(1).i;
+                    break;
+                case Instruction::gt:
+                    result.i = op(0).i > op(1).i;
+                    break;
+                case Instruction::le:
+                    result.i = op(0).i <= op(1).i;
+                    break;
+                case Instruction::lt:
+                    result.i = op(0).i < op(1).i;
+                    break;
+                case Instruction::eq:
+                    result.i = op(0).i == op(1).i;
+                    break;
+                case Instruction::ne:
+                    result.i = op(0).i != op(1).i;
+                    break;
+                case Instruction::fge:
+                    result.i = not(op(0).f < op(1).f);
+                    break;
+                case Instruction::fgt:
+                    result.i = not(op(0).f <= op(1).f);
+                    break;
+                case Instruction::fle:
+                    result.i = not(op(0).f > op(1).f);
+                    break;
+                case Instruction::flt:
+                    result.i = not(op(0).f >= op(1).f);
+                    break;
+                case Instruction::feq:
+                    result.i = op(0).f == op(1).f or std::isnan(op(0).f) or
+                               std::isnan(op(1).f);
+                    break;
+                case Instruction::fne:
+                    result.i = not(op(0).f == op(1).f);
+                    break;
+                case Instruction::phi:
+                    continue;
+                case Instruction::call: {
+                    auto callee = inst->get_operand(0)->as<Function>();
+                    std::vector<Slot> call_args;
+                    for (unsigned i = 1; i < inst->get_num_operand(); i++) {
+                        call_args.push_back(op(i));
+                    }
+                    auto name = callee->get_name();
+                    if (not callee->is_declaration()) {
+                        result = eval(callee, call_args);
+                    } else if (name == "input") {
+                        if (std::scanf("%d", &result.i) != 1)
+                            result.i = 0;
+                    } else if (name == "output") {
+                        std::printf("%d\n", call_args[0].i);
+                    } else if (name == "outputFloat") {
+                        std::printf("%f\n", call_args[0].f);
+                    } else if (name == "neg_idx_except") {
+                        std::printf("negative index exception\n");
+                        std::exit(0);
+                    }
+                    break;
+                }
+                case Instruction::getelementptr: {
+                    auto ty = inst->get_operand(0)
+                                  ->get_type()
+                                  ->get_pointer_element_type();
+                    result.p = op(0).p;
+                    for (unsigned i = 1; i < inst->get_num_operand(); i++) {
+                        result.p += static_cast<ptrdiff_t>(op(i).i) *
+                                    ty->get_size();
+                        if (ty->is_array_type())
+                            ty = ty->get_array_element_type();
+                    }
+                    break;
+                }
+                case Instruction::zext:
+                    result.i = op(0).i & 1;
+                    break;
+                case Instruction::fptosi:
+                    result.i = static_cast<int32_t>(op(0).f);
+                    break;
+                case Instruction::sitofp:
+                    result.f = static_cast<float>(op(0).i);
+                    break;
+                }
+                if (not inst->is_void())
+                    frame.values[inst] = result;
+            }
+            prev = bb;
+            bb = next;
+        }
+    }
+
+    Module *m_;
+    std::vector<std::vector<char>> globals_;
+    std::unordered_map<Value *, char *> global_addr_;
+};
+
+// 递归调用：fib(27) 约 30 万次调用
+const char *fib = R"(
+int fib(int n) {
+    if (n < 2) return n;
+    return fib(n - 1) + fib(n - 2);
+}
+int main(void) {
+    output(fib(27));
+    return 0;
+}
+)";
+
+// 数组访问与嵌套循环：筛法求素数个数
+const char *sieve = R"(
+int flag[2000000];
+int main(void) {
+    int n;
+    int i;
+    int j;
+    int count;
+    n = 2000000;
+    count = 0;
+    i = 2;
+    while (i < n) {
+        if (flag[i] == 0) {
+            count = count + 1;
+            j = i + i;
+            while (j < n) {
+                flag[j] = 1;
+                j = j + i;
+            }
+        }
+        i = i + 1;
+    }
+    output(count);
+    return 0;
+}
+)";
+
+// 浮点运算：矩形法数值积分
+const char *float_integrate = R"(
+int main(void) {
+    float x;
+    float h;
+    float s;
+    int i;
+    h = 1.0 / 2000000.0;
+    s = 0.0;
+    i = 0;
+    while (i < 2000000) {
+        x = (i + 0.5) * h;
+        s = s + 4.0 / (1.0 + x * x);
+        i = i + 1;
+    }
+    outputFloat(s * h);
+    return 0;
+}
+)";
+
+void run_one(const std::string &name, const char *source,
+             const std::filesystem::path &dir) {
+    auto m = build_module(source);
+    Mem2Reg(m.get()).run();
+    DeadCode(m.get()).run();
+
+    // 三种方式各运行 3 次，取最短的 CPU 时间，并检查输出一致
+    double interp_ms = 0, naive_ms = 0, native_ms = 0;
+    std::string interp_out, naive_out;
+    for (int i = 0; i < 3; i++) {
+        double t = 0;
+        interp_out = capture_stdout([&] {
+            t = cpu_time_ms([&] { Interpreter(m.get()).run(); });
+        });
+        interp_ms = i == 0 ? t : std::min(interp_ms, t);
+        naive_out = capture_stdout([&] {
+            t = cpu_time_ms([&] { NaiveEvaluator(m.get()).run(); });
+        });
+        naive_ms = i == 0 ? t : std::min(naive_ms, t);
+    }
+    auto exe = build_native(m.get(), false, dir, name);
+    for (int i = 0; i < 3; i++) {
+        double t = cpu_time_ms([&] { run_native(exe, dir / (name + ".out")); });
+        native_ms = i == 0 ? t : std::min(native_ms, t);
+    }
+    if (interp_out != naive_out or interp_out != read_file(dir / (name + ".out"))) {
+        std::cerr << "interpreter: " << name << ": outputs differ" << std::endl;
+        std::exit(1);
+    }
+
+    char ratios[64];
+    std::snprintf(ratios, sizeof(ratios), " vs_native=%.1fx vs_naive=%.1fx",
+                  interp_ms / native_ms, naive_ms / interp_ms);
+    report("interpreter", "program=" + name +
+                              " native_ms=" + std::to_string(native_ms) +
+                              " interpret_ms=" + std::to_string(interp_ms) +
+                              " naive_ms=" + std::to_string(naive_ms) +
+                              ratios);
+}
+
+} // namespace
+
+void bench_interpreter() {
+    auto dir = make_scratch_dir();
+    run_one("fib", fib, dir);
+    run_one("sieve", sieve, dir);
+    run_one("float-integrate", float_integrate, dir);
+    std::filesystem::remove_all(dir);
+}
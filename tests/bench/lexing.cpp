@@ -0,0 +1,145 @@
+#include "bench.hpp"
+
+extern "C" {
+#include "syntax_analyzer.h"
+
+int yylex(YYSTYPE *yylval_param, yyscan_t yyscanner);
+int yylex_init_extra(struct parse_context *extra, yyscan_t *scanner);
+int yylex_destroy(yyscan_t yyscanner);
+void yyset_in(FILE *in, yyscan_t yyscanner);
+struct yy_buffer_state *yy_scan_bytes(const char *bytes, int len,
+                                      yyscan_t yyscanner);
+struct yy_buffer_state *yy_scan_buffer(char *base, size_t size,
+                                       yyscan_t yyscanner);
+}
+
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 词法分析的吞吐量：同一个生成的源文件分别经由 stdio（yyset_in）、
+// mmap 后原地扫描（parse 的做法）、复制到扫描器的缓冲区（parse_buffer）
+// 与调用者缓冲区原地扫描（parse_buffer_inplace）四种输入方式
+namespace {
+
+// 每个函数约 1 KB，包含注释、数组、浮点常量与各类运算符
+std::string gen_source(size_t target_size) {
+    std::ostringstream src;
+    src << "int g[100];\nfloat h;\n";
+    for (int i = 0; src.tellp() < static_cast<std::streamoff>(target_size);
+         i++) {
+        auto name = var_name(i);
+        src << "/* function " << name << ": generated for the lexing "
+            << "benchmark */\n"
+            << "int f" << name << "(int count, float scale[]) {\n"
+            << "    int index;\n    float total;\n"
+            << "    index = 0;\n    total = 0.0;\n"
+            << "    while (index < count) {\n"
+            << "        if (index >= 50) {\n"
+            << "            total = total + scale[index] * 3.14159;\n"
+            << "        } else {\n"
+            << "            total = total - scale[index] / 2.5e0;\n"
+            << "        }\n"
+            << "        g[index - index / 100 * 100] = index * " << i
+            << " + 12345;\n"
+            << "        if (total != h) h = total; /* keep it */\n"
+            << "        index = index + 1;\n"
+            << "    }\n"
+            << "    if (total <= 1000.0) return 1;\n"
+            << "    return index == count;\n"
+            << "}\n";
+    }
+    src << "void main(void) { return; }\n";
+    return src.str();
+}
+
+// 初始化扫描器，由 setup 指定输入，扫描到结束，返回词法单元个数
+unsigned lex_all(const std::function<void(yyscan_t)> &setup) {
+    struct parse_context ctx = {1, 1, 1, new_syntax_tree()};
+    yyscan_t scanner;
+    yylex_init_extra(&ctx, &scanner);
+    setup(scanner);
+    YYSTYPE lval;
+    unsigned count = 0;
+    while (yylex(&lval, scanner)) {
+        count++;
+    }
+    yylex_destroy(scanner);
+    del_syntax_tree(ctx.tree);
+    return count;
+}
+
+// 与 parse 相同：文件映射之后紧跟匿名页，保证结尾有两个 '\0'
+void lex_mmap(const char *path, unsigned &count) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    fstat(fd, &st);
+    size_t size = st.st_size;
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t len = (size + 2 + page - 1) / page * page;
+    auto base = static_cast<char *>(mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    mmap(base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    close(fd);
+    count = lex_all(
+        [&](yyscan_t scanner) { yy_scan_buffer(base, size + 2, scanner); });
+    munmap(base, len);
+}
+
+void run_one(size_t size, const std::filesystem::path &dir) {
+    auto source = gen_source(size);
+    auto path = dir / "lexing.cminus";
+    std::ofstream(path, std::ios::binary) << source;
+    double mb = source.size() / 1e6;
+
+    unsigned stdio_tokens = 0, mmap_tokens = 0, copy_tokens = 0,
+             inplace_tokens = 0;
+    double stdio_ms = time_ms([&] {
+        FILE *input = std::fopen(path.c_str(), "r");
+        stdio_tokens =
+            lex_all([&](yyscan_t scanner) { yyset_in(input, scanner); });
+        std::fclose(input);
+    });
+    double mmap_ms = time_ms([&] { lex_mmap(path.c_str(), mmap_tokens); });
+    double copy_ms = time_ms([&] {
+        copy_tokens = lex_all([&](yyscan_t scanner) {
+            yy_scan_bytes(source.data(), source.size(), scanner);
+        });
+    });
+    std::string buffer = source + '\0' + '\0';
+    double inplace_ms = time_ms([&] {
+        inplace_tokens = lex_all([&](yyscan_t scanner) {
+            yy_scan_buffer(buffer.data(), buffer.size(), scanner);
+        });
+    });
+    if (stdio_tokens != mmap_tokens or stdio_tokens != copy_tokens or
+        stdio_tokens != inplace_tokens) {
+        std::cerr << "lexing: token counts differ between input methods"
+                  << std::endl;
+        std::exit(1);
+    }
+
+    char fields[256];
+    std::snprintf(fields, sizeof(fields),
+                  "size_mb=%.1f tokens=%u stdio_mb_s=%.0f mmap_mb_s=%.0f "
+                  "buffer_copy_mb_s=%.0f buffer_inplace_mb_s=%.0f",
+                  mb, stdio_tokens, mb / stdio_ms * 1e3, mb / mmap_ms * 1e3,
+                  mb / copy_ms * 1e3, mb / inplace_ms * 1e3);
+    report("lexing", fields);
+}
+
+} // namespace
+
+void bench_lexing() {
+    auto dir = make_scratch_dir();
+    for (size_t size : {4u << 20, 32u << 20}) {
+        run_one(size, dir);
+    }
+    std::filesystem::remove_all(dir);
+}
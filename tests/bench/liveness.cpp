@@ -0,0 +1,136 @@
+#include "DeadCode.hpp"
+#include "DominatorTree.hpp"
+#include "Liveness.hpp"
+#include "Mem2Reg.hpp"
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+
+namespace {
+
+// n 个变量在循环中依次相互更新，mem2reg 后每个 if 的汇合处都有 phi，
+// 所有变量都跨越整个循环活跃
+std::string gen_source(int n) {
+    std::ostringstream src;
+    src << "int f(int x) {\n";
+    for (int i = 0; i < n; i++) {
+        src << "    int " << var_name(i) << ";\n";
+    }
+    src << "    " << var_name(0) << " = x;\n";
+    for (int i = 1; i < n; i++) {
+        src << "    " << var_name(i) << " = " << var_name(i - 1) << " + "
+            << i << ";\n";
+    }
+    src << "    while (x > 0) {\n";
+    for (int i = 0; i < n; i++) {
+        auto v = var_name(i);
+        src << "        if (" << v << " > x) " << v << " = " << v << " - "
+            << var_name((i + 1) % n) << ";\n";
+    }
+    src << "        x = x - 1;\n    }\n    return " << var_name(0)
+        << ";\n}\n"
+        << "void main(void) { output(f(input())); }\n";
+    return src.str();
+}
+
+// 对照实现：迭代顺序与 Liveness 相同，集合改用 std::set<Value *>，
+// 只比较集合表示的差别
+struct SetLiveness {
+    std::map<BasicBlock *, std::set<Value *>> live_in, live_out;
+
+    static bool is_var(Value *val) {
+        if (dynamic_cast<Argument *>(val))
+            return true;
+        auto inst = dynamic_cast<Instruction *>(val);
+        return inst and not inst->is_void();
+    }
+
+    void run(Function *f) {
+        live_in.clear();
+        live_out.clear();
+        DomTree tree;
+        tree.build(f);
+        auto post_order = tree.get_post_order();
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (auto bb : post_order) {
+                std::set<Value *> out;
+                for (auto succ_bb : bb->get_succ_basic_blocks()) {
+                    for (auto val : live_in[succ_bb]) {
+                        out.insert(val);
+                    }
+                    for (auto &inst : succ_bb->get_instructions()) {
+                        if (not inst.is_phi())
+                            break;
+                        for (auto [incoming, pre_bb] :
+                             static_cast<PhiInst *>(&inst)->get_phi_pairs()) {
+                            if (pre_bb == bb and is_var(incoming))
+                                out.insert(incoming);
+                        }
+                    }
+                }
+                auto in = out;
+                auto &instrs = bb->get_instructions();
+                for (auto it = instrs.rbegin(); it != instrs.rend(); ++it) {
+                    in.erase(&*it);
+                    if (it->is_phi())
+                        continue;
+                    for (auto op : it->get_operands()) {
+                        if (is_var(op))
+                            in.insert(op);
+                    }
+                }
+                if (out != live_out[bb] or in != live_in[bb]) {
+                    changed = true;
+                    live_out[bb] = std::move(out);
+                    live_in[bb] = std::move(in);
+                }
+            }
+        }
+    }
+};
+
+} // namespace
+
+void bench_liveness() {
+    for (int n : {250, 1000, 2000}) {
+        auto m = build_module(gen_source(n));
+        Mem2Reg(m.get()).run();
+        DeadCode(m.get()).run();
+        Function *f = nullptr;
+        for (auto &func : m->get_functions()) {
+            if (func.get_name() == "f")
+                f = &func;
+        }
+
+        Liveness liveness(m.get());
+        SetLiveness reference;
+        double ms = time_ms([&] { liveness.run_on_func(f); });
+        double set_ms = time_ms([&] { reference.run(f); }, 1);
+
+        for (auto &bb : f->get_basic_blocks()) {
+            auto live_in = liveness.to_values(f, liveness.get_live_in(&bb));
+            auto live_out = liveness.to_values(f, liveness.get_live_out(&bb));
+            if (std::set<Value *>(live_in.begin(), live_in.end()) !=
+                    reference.live_in[&bb] or
+                std::set<Value *>(live_out.begin(), live_out.end()) !=
+                    reference.live_out[&bb]) {
+                std::cerr << "liveness: result differs from std::set version "
+                             "in block "
+                          << bb.get_name() << std::endl;
+                std::exit(1);
+            }
+        }
+        report("liveness",
+               "vars=" + std::to_string(n) +
+                   " blocks=" + std::to_string(f->get_num_basic_blocks()) +
+                   " ssa_values=" + std::to_string(liveness.get_num_values(f)) +
+                   " bitvector_ms=" + std::to_string(ms) +
+                   " std_set_ms=" + std::to_string(set_ms));
+    }
+}
@@ -0,0 +1,67 @@
+#include "bench.hpp"
+
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+struct Benchmark {
+    const char *name;
+    const char *desc;
+    void (*run)();
+};
+
+const Benchmark benchmarks[] = {
+    {"liveness", "bitvector liveness on thousands of SSA values",
+     bench_liveness},
+    {"mem2reg", "mem2reg on 100k-block straight-line and nested-if functions",
+     bench_mem2reg},
+    {"regalloc", "runtime of -S -regalloc code against all-spill -S code",
+     bench_regalloc},
+    {"interpreter",
+     "-interpret against a naive lightir tree-walker and native -S code",
+     bench_interpreter},
+    {"lexing", "lexing throughput (MB/s) through stdio, mmap and buffers",
+     bench_lexing},
+    {"parse-tree", "memory of the arena parse tree on large inputs",
+     bench_parse_tree},
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc == 2 and (argv[1] == std::string("-h") or
+                       argv[1] == std::string("--help"))) {
+        std::cout << "Usage: " << argv[0] << " [<benchmark>...]\n";
+        for (auto &bench : benchmarks) {
+            std::cout << "  " << bench.name << "\t" << bench.desc << "\n";
+        }
+        return 0;
+    }
+    for (int i = 1; i < argc; i++) {
+        bool known = false;
+        for (auto &bench : benchmarks) {
+            known |= std::strcmp(argv[i], bench.name) == 0;
+        }
+        if (not known) {
+            std::cerr << argv[0] << ": unknown benchmark " << argv[i]
+                      << std::endl;
+            return 1;
+        }
+    }
+    if (std::string(BENCH_BUILD_TYPE) != "Release") {
+        std::cerr << "warning: " << BENCH_BUILD_TYPE
+                  << " build, configure with -DCMAKE_BUILD_TYPE=Release "
+                     "for meaningful timings"
+                  << std::endl;
+    }
+    for (auto &bench : benchmarks) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; i++) {
+            selected |= std::strcmp(argv[i], bench.name) == 0;
+        }
+        if (selected)
+            bench.run();
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "IRBuilder.hpp"
+#include "Mem2Reg.hpp"
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+// 10 万个块的函数超出了 cminusfc 前端递归处理嵌套语句的能力，
+// 这里直接用 IRBuilder 构造，与前端生成的形式相同（局部变量经 alloca 读写）
+namespace {
+
+struct Generated {
+    std::unique_ptr<Module> module;
+    Function *func;
+};
+
+Generated create_func(Module *m, IRBuilder &builder, AllocaInst *&var) {
+    auto int32 = m->get_int32_type();
+    auto func =
+        Function::create(FunctionType::get(int32, {int32}), "f", m);
+    builder.set_insert_point(BasicBlock::create(m, "entry", func));
+    var = builder.create_alloca(int32);
+    builder.create_store(&func->get_args().front(), var);
+    return {nullptr, func};
+}
+
+// 直线型：n 个块顺序相连，每块读写一次变量，支配树是一条长链
+Generated gen_straight_line(int n) {
+    auto m = std::make_unique<Module>();
+    IRBuilder builder(nullptr, m.get());
+    AllocaInst *var;
+    auto func = create_func(m.get(), builder, var).func;
+    for (int i = 0; i < n; i++) {
+        auto bb = BasicBlock::create(m.get(), "", func);
+        builder.create_br(bb);
+        builder.set_insert_point(bb);
+        auto val = builder.create_load(var);
+        builder.create_store(
+            builder.create_iadd(val, ConstantInt::get(i, m.get())), var);
+    }
+    builder.create_ret(builder.create_load(var));
+    return {std::move(m), func};
+}
+
+// 嵌套 if：n 层 if 逐层嵌套在 then 分支中，每层的汇合块都需要 phi，
+// 支配树深度约为 2n
+Generated gen_nested_if(int n) {
+    auto m = std::make_unique<Module>();
+    IRBuilder builder(nullptr, m.get());
+    AllocaInst *var;
+    auto func = create_func(m.get(), builder, var).func;
+    std::vector<BasicBlock *> joins;
+    for (int i = 0; i < n; i++) {
+        auto then_bb = BasicBlock::create(m.get(), "", func);
+        auto join_bb = BasicBlock::create(m.get(), "", func);
+        auto cond = builder.create_icmp_gt(builder.create_load(var),
+                                           ConstantInt::get(i, m.get()));
+        builder.create_cond_br(cond, then_bb, join_bb);
+        builder.set_insert_point(then_bb);
+        builder.create_store(builder.create_isub(builder.create_load(var),
+                                                 ConstantInt::get(1, m.get())),
+                             var);
+        joins.push_back(join_bb);
+    }
+    for (auto it = joins.rbegin(); it != joins.rend(); ++it) {
+        builder.create_br(*it);
+        builder.set_insert_point(*it);
+    }
+    builder.create_ret(builder.create_load(var));
+    return {std::move(m), func};
+}
+
+void run_one(const char *shape, int n, Generated (*gen)(int)) {
+    Generated g;
+    double ms = time_ms([&] { Mem2Reg(g.module.get()).run(); }, 1,
+                        [&] { g = gen(n); });
+
+    unsigned num_phis = 0;
+    for (auto &bb : g.func->get_basic_blocks()) {
+        for (auto &inst : bb.get_instructions()) {
+            if (inst.is_load() or inst.is_store()) {
+                std::cerr << "mem2reg: " << shape
+                          << ": load/store left after renaming" << std::endl;
+                std::exit(1);
+            }
+            num_phis += inst.is_phi();
+        }
+    }
+    report("mem2reg",
+           std::string("shape=") + shape +
+               " blocks=" + std::to_string(g.func->get_num_basic_blocks()) +
+               " phis=" + std::to_string(num_phis) +
+               " time_ms=" + std::to_string(ms));
+}
+
+} // namespace
+
+void bench_mem2reg() {
+    run_one("straight-line", 100000, gen_straight_line);
+    run_one("nested-if", 50000, gen_nested_if);
+}
@@ -0,0 +1,99 @@
+#include "ast.hpp"
+#include "bench.hpp"
+
+#include <cstdio>
+#include <malloc.h>
+#include <sstream>
+#include <unistd.h>
+#include <vector>
+
+// 语法树占用的内存：分析前后 malloc 中在用字节数之差，即树存活时的全部开销；
+// 与原先每个结点单独 malloc 的定长结构（parent、children[10]、name[30]）
+// 在同样结点数下的占用比较
+namespace {
+
+struct OldNode {
+    OldNode *parent;
+    OldNode *children[10];
+    int children_num;
+    char name[30];
+};
+
+size_t heap_in_use() {
+    auto info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+// 常驻内存；arena 的大块由 mmap 得到，只有写过的页才计入
+size_t resident_bytes() {
+    size_t pages = 0, resident = 0;
+    if (FILE *f = std::fopen("/proc/self/statm", "r")) {
+        if (std::fscanf(f, "%zu %zu", &pages, &resident) != 2)
+            resident = 0;
+        std::fclose(f);
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+// 与 cminusfc 的大输入相同的形状：大量短小的函数
+std::string gen_source(int num_funcs) {
+    std::ostringstream src;
+    src << "int g[10];\n";
+    for (int i = 0; i < num_funcs; i++) {
+        src << "int f" << var_name(i) << "(int a, float b[]) { int x; x = a * "
+            << i << " + b[x - 1]; while (x > 0) { if (x == 3) x = x - 1; "
+            << "else x = output(x); } return x; }\n";
+    }
+    src << "void main(void) { return; }\n";
+    return src.str();
+}
+
+void run_one(int num_funcs) {
+    auto source = gen_source(num_funcs);
+
+    // 声明列表是左递归的，树很深，用显式栈遍历
+    syntax_tree *tree = nullptr;
+    size_t before = heap_in_use(), rss_before = resident_bytes();
+    double parse_ms = time_ms([&] {
+        tree = parse_buffer(source.data(), source.size());
+    }, 1);
+    size_t tree_bytes = heap_in_use() - before;
+    size_t tree_rss = resident_bytes() - rss_before;
+
+    size_t num_nodes = 0;
+    std::vector<syntax_tree_node *> stack{tree->root};
+    while (not stack.empty()) {
+        auto node = stack.back();
+        stack.pop_back();
+        num_nodes++;
+        for (int i = 0; i < node->children_num; i++) {
+            stack.push_back(node->children[i]);
+        }
+    }
+    double free_ms = time_ms([&] { del_syntax_tree(tree); }, 1);
+
+    // 原先每个结点是一次 malloc(sizeof(OldNode))，加上 8 字节的块头
+    void *probe = malloc(sizeof(OldNode));
+    size_t old_node_bytes = malloc_usable_size(probe) + 8;
+    free(probe);
+    size_t old_bytes = num_nodes * old_node_bytes;
+
+    char fields[256];
+    std::snprintf(fields, sizeof(fields),
+                  "input_mb=%.1f nodes=%zu heap_mb=%.1f rss_mb=%.1f "
+                  "rss_per_node=%.1f old_layout_mb=%.1f reduction=%.1fx "
+                  "parse_ms=%.0f free_ms=%.2f",
+                  source.size() / 1e6, num_nodes, tree_bytes / 1e6,
+                  tree_rss / 1e6, double(tree_rss) / num_nodes,
+                  old_bytes / 1e6, double(old_bytes) / tree_rss, parse_ms,
+                  free_ms);
+    report("parse-tree", fields);
+}
+
+} // namespace
+
+void bench_parse_tree() {
+    for (int num_funcs : {20000, 200000}) {
+        run_one(num_funcs);
+    }
+}
@@ -0,0 +1,182 @@
+#include "DeadCode.hpp"
+#include "Mem2Reg.hpp"
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+// 把生成的程序分别编译为全部溢出（-S）与线性扫描分配（-S -regalloc）的
+// 汇编，用宿主 C 编译器与 cminus_io 链接后运行，比较运行时间与输出
+namespace {
+
+// 整数运算：二重循环中的乘除与累加
+const char *int_loop = R"(
+int main(void) {
+    int i;
+    int j;
+    int s;
+    s = 0;
+    i = 0;
+    while (i < 6000) {
+        j = 1;
+        while (j < 6000) {
+            s = s + i * j - i / j;
+            j = j + 1;
+        }
+        i = i + 1;
+    }
+    output(s);
+    return 0;
+}
+)";
+
+// 数组访问：对伪随机数组冒泡排序，循环变量与数组地址都在寄存器中受益
+const char *bubble_sort = R"(
+int a[6000];
+int main(void) {
+    int n;
+    int i;
+    int j;
+    int t;
+    int seed;
+    n = 6000;
+    seed = 7;
+    i = 0;
+    while (i < n) {
+        seed = seed * 1103 + 12345;
+        seed = seed - seed / 65536 * 65536;
+        a[i] = seed;
+        i = i + 1;
+    }
+    i = 0;
+    while (i < n) {
+        j = 0;
+        while (j < n - i - 1) {
+            if (a[j] > a[j + 1]) {
+                t = a[j];
+                a[j] = a[j + 1];
+                a[j + 1] = t;
+            }
+            j = j + 1;
+        }
+        i = i + 1;
+    }
+    output(a[0]);
+    output(a[n / 2]);
+    output(a[n - 1]);
+    return 0;
+}
+)";
+
+// 浮点运算：矩形法数值积分，使用浮点寄存器类
+const char *float_integrate = R"(
+int main(void) {
+    float x;
+    float h;
+    float s;
+    int i;
+    h = 1.0 / 20000000.0;
+    s = 0.0;
+    i = 0;
+    while (i < 20000000) {
+        x = (i + 0.5) * h;
+        s = s + 4.0 / (1.0 + x * x);
+        i = i + 1;
+    }
+    outputFloat(s * h);
+    return 0;
+}
+)";
+
+// 寄存器压力：12 个变量在循环中轮流相互更新，超过可分配的整数寄存器数；
+// 只用加减，避免 idiv 的延迟掩盖访存的差别
+std::string gen_pressure() {
+    const int n = 12;
+    std::ostringstream src;
+    src << "int main(void) {\n    int k;\n";
+    for (int i = 0; i < n; i++) {
+        src << "    int " << var_name(i) << ";\n";
+    }
+    for (int i = 0; i < n; i++) {
+        src << "    " << var_name(i) << " = " << i + 1 << ";\n";
+    }
+    src << "    k = 0;\n    while (k < 20000000) {\n";
+    for (int i = 0; i < n; i++) {
+        src << "        " << var_name(i) << " = " << var_name(i) << " + "
+            << var_name((i + 1) % n) << " - " << var_name((i + 5) % n)
+            << " - k;\n";
+    }
+    src << "        k = k + 1;\n    }\n";
+    for (int i = 0; i < n; i++) {
+        src << "    output(" << var_name(i) << ");\n";
+    }
+    src << "    return 0;\n}\n";
+    return src.str();
+}
+
+// 生成并链接可执行文件，返回其路径
+std::filesystem::path build(const std::string &source, bool regalloc,
+                            const std::filesystem::path &dir,
+                            const std::string &name) {
+    auto m = build_module(source);
+    Mem2Reg(m.get()).run();
+    DeadCode(m.get()).run();
+    return build_native(m.get(), regalloc, dir, name);
+}
+
+double run_exe(const std::filesystem::path &exe,
+               const std::filesystem::path &out_path) {
+    return cpu_time_ms([&] { run_native(exe, out_path); });
+}
+
+void run_one(const std::string &name, const std::string &source,
+             const std::filesystem::path &dir) {
+    auto spill_exe = build(source, false, dir, name + "-spill");
+    auto regalloc_exe = build(source, true, dir, name + "-regalloc");
+    // 两个版本交替运行 5 次，各取最短的 CPU 时间（墙钟时间在共享的机器上抖动过大）
+    double spill_ms = 0, regalloc_ms = 0;
+    for (int i = 0; i < 5; i++) {
+        double t1 = run_exe(spill_exe, dir / (name + "-spill.out"));
+        double t2 = run_exe(regalloc_exe, dir / (name + "-regalloc.out"));
+        spill_ms = i == 0 ? t1 : std::min(spill_ms, t1);
+        regalloc_ms = i == 0 ? t2 : std::min(regalloc_ms, t2);
+    }
+    if (read_file(dir / (name + "-spill.out")) !=
+        read_file(dir / (name + "-regalloc.out"))) {
+        std::cerr << "regalloc: " << name
+                  << ": output differs from the all-spill build" << std::endl;
+        std::exit(1);
+    }
+    // 静态计数：汇编中对栈帧（%rbp 寻址）的访问次数
+    auto count_stack_refs = [&](const std::string &suffix) {
+        auto text = read_file(dir / (name + suffix + ".s"));
+        unsigned count = 0;
+        for (auto pos = text.find("(%rbp)"); pos != std::string::npos;
+             pos = text.find("(%rbp)", pos + 1)) {
+            count++;
+        }
+        return std::to_string(count);
+    };
+    char speedup[32];
+    std::snprintf(speedup, sizeof(speedup), "%.2f", spill_ms / regalloc_ms);
+    report("regalloc", "program=" + name +
+                           " stack_refs=" + count_stack_refs("-spill") + "/" +
+                           count_stack_refs("-regalloc") +
+                           " all_spill_ms=" + std::to_string(spill_ms) +
+                           " regalloc_ms=" + std::to_string(regalloc_ms) +
+                           " speedup=" + speedup);
+}
+
+} // namespace
+
+void bench_regalloc() {
+    auto dir = make_scratch_dir();
+    run_one("int-loop", int_loop, dir);
+    run_one("bubble-sort", bubble_sort, dir);
+    run_one("float-integrate", float_integrate, dir);
+    run_one("pressure", gen_pressure(), dir);
+    std::filesystem::remove_all(dir);
+}